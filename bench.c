@@ -0,0 +1,2006 @@
+#define _GNU_SOURCE
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Count every allocation strlib makes
+static size_t bench_allocs;
+
+static void* Bench_Calloc(size_t count, size_t size)
+{
+    bench_allocs += 1;
+    return calloc(count, size);
+}
+
+static void* Bench_Malloc(size_t size)
+{
+    bench_allocs += 1;
+    return malloc(size);
+}
+
+static void* Bench_Realloc(void* ptr, size_t size)
+{
+    bench_allocs += 1;
+    return realloc(ptr, size);
+}
+
+#define STRLIB_CALLOC(count, size) Bench_Calloc((count), (size))
+#define STRLIB_MALLOC(size) Bench_Malloc((size))
+#define STRLIB_REALLOC(ptr, size) Bench_Realloc((ptr), (size))
+
+#include "strlib.h"
+
+// Keeps the compiler from optimizing away benchmarked results
+static volatile size_t bench_sink;
+
+static double Bench_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Bytes of heap memory in use, including allocator bookkeeping
+static size_t Bench_HeapInUse(void)
+{
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+// Number of iterations such that each measurement processes roughly `target` bytes
+static size_t Bench_Iterations(size_t bytes_per_iter, size_t target)
+{
+    size_t iters = target / (bytes_per_iter ? bytes_per_iter : 1);
+    return iters ? iters : 1;
+}
+
+/* ---- Substring search ---- */
+
+static ssize_t Naive_FirstOccurrenceOf(const String* str, const String* substr)
+{
+    if (substr->len > str->len) {
+        return -1;
+    }
+
+    for (size_t ii = 0; ii < str->len - substr->len + 1; ii++) {
+        if (!memcmp(&String_Buf(str)[ii], String_Buf(substr), substr->len)) {
+            return (ssize_t)ii;
+        }
+    }
+
+    return -1;
+}
+
+static ssize_t Memmem_FirstOccurrenceOf(const String* str, const String* substr)
+{
+    const char* pos = memmem(String_Buf(str), str->len, String_Buf(substr), substr->len);
+    return pos ? pos - String_Buf(str) : -1;
+}
+
+typedef ssize_t (*SearchFn)(const String*, const String*);
+
+// Returns the throughput of `fn` in GB/s over `hay`
+static double Bench_Search(SearchFn fn, const String* hay, const String* needle)
+{
+    size_t iters = Bench_Iterations(hay->len, 1 << 26);
+    double start = Bench_Now();
+    for (size_t ii = 0; ii < iters; ii++) {
+        bench_sink += (size_t)fn(hay, needle);
+    }
+    double elapsed = Bench_Now() - start;
+
+    return (double)hay->len * (double)iters / elapsed;
+}
+
+// Fills `str` with pseudo-random lowercase text (words separated by spaces)
+static void Bench_FillText(String* str, unsigned seed)
+{
+    for (size_t ii = 0; ii < str->len; ii++) {
+        seed = seed * 1103515245 + 12345;
+        unsigned r = (seed >> 16) % 32;
+        String_Buf(str)[ii] = r < 26 ? (char)('a' + r) : ' ';
+    }
+}
+
+// Fills `str` with web server log lines
+static void Bench_FillLog(String* str, unsigned seed)
+{
+    static const char* const methods[] = { "GET", "GET", "GET", "POST", "PUT", "DELETE" };
+    static const char* const paths[] = { "/api/v1/users/", "/api/v1/orders/", "/static/js/app.", "/health", "/login?next=/" };
+    static const int statuses[] = { 200, 200, 200, 200, 304, 404, 302, 201 };
+
+    StringBuilder sb = StringBuilder_New(str->len + 256);
+    while (sb.len < str->len) {
+        seed = seed * 1103515245 + 12345;
+        unsigned r = seed >> 8;
+        StringBuilder_AppendFormat(
+            &sb,
+            "2024-05-%02u %02u:%02u:%02u INFO  %s %s%u status=%d bytes=%u ua=\"Mozilla/5.0 (X11; Linux x86_64)\"\n",
+            1 + r % 28,
+            r % 24,
+            r % 60,
+            (r >> 6) % 60,
+            methods[r % 6],
+            paths[(r >> 3) % 5],
+            r % 100000,
+            statuses[(r >> 5) % 8],
+            r % 65536);
+    }
+
+    memcpy(String_Buf(str), sb.buf, str->len);
+    StringBuilder_Delete(&sb);
+}
+
+static void bench_search(void)
+{
+    static const size_t hay_lens[] = { 64, 4096, 1 << 20 };
+    static const size_t needle_lens[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+    printf("== substring search, random text (GB/s) ==\n");
+    printf("%10s %8s %10s %10s %10s\n", "haystack", "needle", "naive", "memmem", "strlib");
+
+    for (size_t hh = 0; hh < sizeof(hay_lens) / sizeof(hay_lens[0]); hh++) {
+        String hay = String_New(hay_lens[hh]);
+        Bench_FillText(&hay, 1);
+
+        for (size_t nn = 0; nn < sizeof(needle_lens) / sizeof(needle_lens[0]); nn++) {
+            // needle drawn from the same distribution as the text, so first/last bytes match often,
+            // with a middle byte that never occurs so the whole haystack is scanned
+            String needle = String_New(needle_lens[nn]);
+            Bench_FillText(&needle, 7);
+            String_Buf(&needle)[needle.len / 2] = '#';
+
+            printf(
+                "%10zu %8zu %10.2f %10.2f %10.2f\n",
+                (size_t)hay.len,
+                (size_t)needle.len,
+                Bench_Search(Naive_FirstOccurrenceOf, &hay, &needle),
+                Bench_Search(Memmem_FirstOccurrenceOf, &hay, &needle),
+                Bench_Search(String_FirstOccurrenceOf, &hay, &needle));
+
+            String_Delete(&needle);
+        }
+
+        String_Delete(&hay);
+    }
+
+    printf("\n== substring search, adversarial \"aaa...a\" / \"aa..b..aa\" (GB/s) ==\n");
+    printf("%10s %8s %10s %10s %10s\n", "haystack", "needle", "naive", "memmem", "strlib");
+
+    for (size_t nn = 3; nn < sizeof(needle_lens) / sizeof(needle_lens[0]); nn++) {
+        String hay = String_New(1 << 20);
+        memset(String_Buf(&hay), 'a', hay.len);
+        String needle = String_New(needle_lens[nn]);
+        memset(String_Buf(&needle), 'a', needle.len);
+        String_Buf(&needle)[needle.len / 2] = 'b';
+
+        printf(
+            "%10zu %8zu %10.2f %10.2f %10.2f\n",
+            (size_t)hay.len,
+            (size_t)needle.len,
+            Bench_Search(Naive_FirstOccurrenceOf, &hay, &needle),
+            Bench_Search(Memmem_FirstOccurrenceOf, &hay, &needle),
+            Bench_Search(String_FirstOccurrenceOf, &hay, &needle));
+
+        String_Delete(&hay);
+        String_Delete(&needle);
+    }
+
+    printf("\n");
+}
+
+/* ---- String construction ---- */
+
+// Builds a String out of `count` pieces by chaining String_Join, returns ns elapsed
+static double Bench_JoinChain(const String* piece, size_t count)
+{
+    double start = Bench_Now();
+    String acc = String_New(0);
+    for (size_t ii = 0; ii < count; ii++) {
+        String next = String_Join(&acc, piece);
+        String_Delete(&acc);
+        acc = next;
+    }
+    bench_sink += acc.len;
+    String_Delete(&acc);
+
+    return Bench_Now() - start;
+}
+
+// Builds a String out of `count` pieces with a StringBuilder, returns ns elapsed
+static double Bench_Builder(const String* piece, size_t count)
+{
+    double start = Bench_Now();
+    StringBuilder sb = StringBuilder_New(0);
+    for (size_t ii = 0; ii < count; ii++) {
+        StringBuilder_Append(&sb, piece);
+    }
+    String acc = StringBuilder_Finalize(&sb);
+    bench_sink += acc.len;
+    String_Delete(&acc);
+
+    return Bench_Now() - start;
+}
+
+static void bench_builder(void)
+{
+    static const size_t counts[] = { 10, 100, 1000, 10000, 100000 };
+    const String* piece = str("field=value;");
+
+    printf("== N appends of a 12 byte piece (ns/append) ==\n");
+    printf("%10s %12s %12s\n", "N", "String_Join", "Builder");
+
+    for (size_t ii = 0; ii < sizeof(counts) / sizeof(counts[0]); ii++) {
+        printf(
+            "%10zu %12.2f %12.2f\n",
+            counts[ii],
+            Bench_JoinChain(piece, counts[ii]) / (double)counts[ii],
+            Bench_Builder(piece, counts[ii]) / (double)counts[ii]);
+    }
+
+    printf("\n");
+}
+
+/* ---- Small-string optimization ---- */
+
+#define BENCH_TOKENS 1000000
+
+typedef String TokenCtor(const char* arr, size_t len);
+
+static String Bench_HeapToken(const char* arr, size_t len)
+{
+    String ret = String_NewHeap(len);
+    memcpy(String_Buf(&ret), arr, len);
+
+    return ret;
+}
+
+// Creates, compares and frees a String for every token in `corpus`
+static void Bench_Tokens(const char* name, TokenCtor* ctor, const String* corpus)
+{
+    String* tokens = malloc(sizeof(String) * BENCH_TOKENS);
+    const char* text = String_Buf(corpus);
+    size_t allocs = bench_allocs;
+    size_t count = 0;
+    size_t pos = 0;
+
+    double start = Bench_Now();
+    while (count < BENCH_TOKENS && pos < corpus->len) {
+        const char* end = memchr(&text[pos], ' ', corpus->len - pos);
+        size_t len = end ? (size_t)(end - &text[pos]) : corpus->len - pos;
+        tokens[count++] = ctor(&text[pos], len);
+        pos += len + 1;
+    }
+
+    size_t matches = 0;
+    for (size_t ii = 1; ii < count; ii++) {
+        matches += String_Equal(&tokens[ii - 1], &tokens[ii]) || String_StartsWith(&tokens[ii], str("ab"));
+    }
+
+    for (size_t ii = 0; ii < count; ii++) {
+        String_Delete(&tokens[ii]);
+    }
+    double elapsed = Bench_Now() - start;
+
+    bench_sink += matches;
+    printf(
+        "%10s %12.2f %12.3f\n",
+        name,
+        elapsed / (double)count,
+        (double)(bench_allocs - allocs) / (double)count);
+    free(tokens);
+}
+
+static void bench_sso(void)
+{
+    // space separated words, about 4 chars on average
+    String corpus = String_New(8 * BENCH_TOKENS);
+    Bench_FillText(&corpus, 3);
+
+    printf("== token corpus, create + compare + delete (%d tokens) ==\n", BENCH_TOKENS);
+    printf("%10s %12s %12s\n", "strings", "ns/token", "allocs/token");
+    Bench_Tokens("sso", String_FromCharArray, &corpus);
+    Bench_Tokens("heap", Bench_HeapToken, &corpus);
+    printf("\n");
+
+    String_Delete(&corpus);
+}
+
+/* ---- Trim and character classes ---- */
+
+// Byte at a time trim, as String_TrimView used to be
+static StringView Naive_Trim(StringView view)
+{
+    size_t front = 0;
+    size_t back = view.len;
+    while (front < back && String_IsWhitespaceChar(view.buf[front])) {
+        front += 1;
+    }
+    while (back > front && String_IsWhitespaceChar(view.buf[back - 1])) {
+        back -= 1;
+    }
+
+    return StringView_Slice(view, front, back);
+}
+
+static void bench_trim(void)
+{
+    static const size_t pads[] = { 0, 4, 16, 64, 256, 4096 };
+
+    printf("== trim, value padded with whitespace on both sides (ns/trim) ==\n");
+    printf("%10s %10s %10s\n", "padding", "naive", "strlib");
+    for (size_t ii = 0; ii < sizeof(pads) / sizeof(pads[0]); ii++) {
+        String padded = String_New(2 * pads[ii] + 5);
+        memset(String_Buf(&padded), ' ', padded.len);
+        memcpy(&String_Buf(&padded)[pads[ii]], "value", 5);
+        for (size_t jj = 0; jj < pads[ii]; jj += 7) {
+            String_Buf(&padded)[jj] = '\t';
+        }
+        StringView view = String_View(&padded);
+        size_t iters = Bench_Iterations(padded.len, 1 << 26);
+
+        double start = Bench_Now();
+        for (size_t jj = 0; jj < iters; jj++) {
+            bench_sink += Naive_Trim(view).len;
+        }
+        double naive = (Bench_Now() - start) / (double)iters;
+
+        start = Bench_Now();
+        for (size_t jj = 0; jj < iters; jj++) {
+            bench_sink += StringView_Trim(view).len;
+        }
+        double strlib = (Bench_Now() - start) / (double)iters;
+
+        printf("%10zu %10.1f %10.1f\n", pads[ii], naive, strlib);
+        String_Delete(&padded);
+    }
+    printf("\n");
+
+    String text = String_New(1 << 20);
+    Bench_FillText(&text, 5);
+    String_Buf(&text)[text.len - 1] = ';';
+    StringCharSet delims = StringCharSet_FromView(strview(";,|"));
+    size_t iters = Bench_Iterations(text.len, 1 << 28);
+
+    double start = Bench_Now();
+    for (size_t ii = 0; ii < iters; ii++) {
+        bench_sink += strcspn(String_CStr(&text), ";,|");
+    }
+    double libc = (double)text.len * (double)iters / (Bench_Now() - start);
+
+    start = Bench_Now();
+    for (size_t ii = 0; ii < iters; ii++) {
+        bench_sink += (size_t)StringView_FindFirstOf(String_View(&text), &delims);
+    }
+    double strlib = (double)text.len * (double)iters / (Bench_Now() - start);
+
+    printf("== find first of 3 delimiters, 1 MiB random text (GB/s) ==\n");
+    printf("%10s %10s\n", "strcspn", "strlib");
+    printf("%10.2f %10.2f\n\n", libc, strlib);
+    String_Delete(&text);
+}
+
+/* ---- Multi-pattern matching ---- */
+
+static void bench_matcher(void)
+{
+    enum { LINE_LEN = 200, LINES = 2000 };
+    static const size_t keyword_counts[] = { 10, 100, 500 };
+
+    String corpus = String_New(LINE_LEN * LINES);
+    Bench_FillText(&corpus, 11);
+
+    printf("== keyword scan over %d lines of %d bytes (ns/line) ==\n", LINES, LINE_LEN);
+    printf("%10s %16s %16s\n", "keywords", "String_Contains", "StringMatcher");
+
+    for (size_t kk = 0; kk < sizeof(keyword_counts) / sizeof(keyword_counts[0]); kk++) {
+        size_t count = keyword_counts[kk];
+        String* keywords = malloc(sizeof(String) * count);
+        for (size_t ii = 0; ii < count; ii++) {
+            keywords[ii] = String_New(6 + ii % 5);
+            Bench_FillText(&keywords[ii], 100 + (unsigned)ii);
+        }
+
+        StringMatcher m = StringMatcher_New(keywords, count);
+
+        double start = Bench_Now();
+        for (size_t line = 0; line < LINES; line++) {
+            String text = StringView_AsString(String_SliceView(&corpus, line * LINE_LEN, (line + 1) * LINE_LEN));
+            for (size_t ii = 0; ii < count; ii++) {
+                bench_sink += String_Contains(&text, &keywords[ii]);
+            }
+        }
+        double naive = Bench_Now() - start;
+
+        start = Bench_Now();
+        for (size_t line = 0; line < LINES; line++) {
+            String text = StringView_AsString(String_SliceView(&corpus, line * LINE_LEN, (line + 1) * LINE_LEN));
+            bench_sink += StringMatcher_Count(&m, &text);
+        }
+        double matcher = Bench_Now() - start;
+
+        printf("%10zu %16.1f %16.1f\n", count, naive / LINES, matcher / LINES);
+
+        StringMatcher_Delete(&m);
+        for (size_t ii = 0; ii < count; ii++) {
+            String_Delete(&keywords[ii]);
+        }
+        free(keywords);
+    }
+
+    printf("\n");
+    String_Delete(&corpus);
+}
+
+/* ---- Allocators ---- */
+
+static const char bench_request[] =
+    "GET /api/v1/items?page=2&sort=name HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) Gecko/20100101 Firefox/118.0\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Language: en-US,en;q=0.5\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Connection: keep-alive\r\n"
+    "Cookie: session=8f2a9c1e77b04d3a; theme=dark; lang=en\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "X-Request-Id: 4b1e0b2a-9a8e-4c5d-bb7e-0d2f3c4a5b6c\r\n";
+
+// Parses `bench_request` into header names and values the way a request handler would, freeing everything unless
+// an arena is in use
+static void Bench_HandleRequest(bool arena)
+{
+    String request = String(bench_request);
+    StringList lines = String_Split(&request, str("\r\n"));
+    String* fields = malloc(sizeof(String) * lines.len * 2);
+    size_t field_count = 0;
+
+    for (size_t ii = 1; ii < lines.len; ii++) {
+        String line = String_Trim(&lines.str[ii]);
+        StringList kv = String_Split(&line, str(": "));
+        if (kv.len == 2) {
+            String name = String_Replace(&kv.str[0], str("-"), str("_"));
+            fields[field_count++] = String_Join(&name, str("="));
+            fields[field_count++] = String_Trim(&kv.str[1]);
+            bench_sink += name.len;
+            if (!arena) {
+                String_Delete(&name);
+            }
+        }
+
+        if (!arena) {
+            String_Delete(&line);
+            StringList_Delete(&kv);
+        }
+    }
+
+    bench_sink += field_count;
+    if (!arena) {
+        for (size_t ii = 0; ii < field_count; ii++) {
+            String_Delete(&fields[ii]);
+        }
+        StringList_Delete(&lines);
+        String_Delete(&request);
+    }
+    free(fields);
+}
+
+static void bench_allocators(void)
+{
+    enum { REQUESTS = 200000 };
+
+    printf("== request parsing, %d requests ==\n", REQUESTS);
+    printf("%10s %12s %14s\n", "allocator", "ns/request", "allocs/request");
+
+    size_t allocs = bench_allocs;
+    double start = Bench_Now();
+    for (size_t ii = 0; ii < REQUESTS; ii++) {
+        Bench_HandleRequest(false);
+    }
+    double elapsed = Bench_Now() - start;
+    printf("%10s %12.1f %14.2f\n", "malloc", elapsed / REQUESTS, (double)(bench_allocs - allocs) / REQUESTS);
+
+    StringArena arena = StringArena_New(16 << 10);
+    allocs = bench_allocs;
+    start = Bench_Now();
+    for (size_t ii = 0; ii < REQUESTS; ii++) {
+        String_SetAllocator(&arena.base);
+        Bench_HandleRequest(true);
+        StringArena_Reset(&arena);
+        String_SetAllocator(NULL);
+    }
+    elapsed = Bench_Now() - start;
+    printf("%10s %12.1f %14.2f\n", "arena", elapsed / REQUESTS, (double)(bench_allocs - allocs) / REQUESTS);
+    StringArena_Delete(&arena);
+
+    printf("\n");
+}
+
+/* ---- Hashing and hash map ---- */
+
+// Largest key count of the hash map benchmark, 100M keys need about 10 GiB of memory
+#ifndef BENCH_MAP_MAX_KEYS
+#define BENCH_MAP_MAX_KEYS 10000000
+#endif
+
+// Byte at a time hash commonly used for string keys
+static uint64_t Fnv1a_Hash(const char* buf, size_t len)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t ii = 0; ii < len; ii++) {
+        hash = (hash ^ (unsigned char)buf[ii]) * 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+static void bench_hash(void)
+{
+    static const size_t lens[] = { 8, 16, 32, 64, 256, 4096 };
+
+    printf("== hashing (GB/s) ==\n");
+    printf("%10s %10s %10s\n", "key len", "fnv1a", "strlib");
+    String text = String_New(4096 + 64);
+    Bench_FillText(&text, 9);
+    for (size_t ii = 0; ii < sizeof(lens) / sizeof(lens[0]); ii++) {
+        size_t iters = Bench_Iterations(lens[ii], 1 << 27);
+        const char* buf = String_Buf(&text);
+
+        double start = Bench_Now();
+        for (size_t jj = 0; jj < iters; jj++) {
+            bench_sink += Fnv1a_Hash(&buf[jj & 63], lens[ii]);
+        }
+        double fnv = (double)lens[ii] * (double)iters / (Bench_Now() - start);
+
+        start = Bench_Now();
+        for (size_t jj = 0; jj < iters; jj++) {
+            bench_sink += StrLib_Hash(&buf[jj & 63], lens[ii], 0);
+        }
+        double strlib = (double)lens[ii] * (double)iters / (Bench_Now() - start);
+
+        printf("%10zu %10.2f %10.2f\n", lens[ii], fnv, strlib);
+    }
+    printf("\n");
+    String_Delete(&text);
+
+    printf("== StringMap, keys \"user:<n>\" (ns/op) ==\n");
+    printf("%12s %10s %10s %10s %10s\n", "keys", "insert", "presized", "hit", "miss");
+    for (size_t count = 1000000; count <= BENCH_MAP_MAX_KEYS; count *= 10) {
+        // keys are looked up in a pseudo-random order, so most lookups miss the cache
+        char* keys = malloc(count * 16);
+        size_t* order = malloc(count * sizeof(size_t));
+        for (size_t ii = 0; ii < count; ii++) {
+            snprintf(&keys[ii * 16], 16, "user:%zu", ii);
+            order[ii] = ii;
+        }
+        for (size_t ii = count - 1; ii > 0; ii--) {
+            size_t jj = (ii * 2654435761u) % (ii + 1);
+            size_t tmp = order[ii];
+            order[ii] = order[jj];
+            order[jj] = tmp;
+        }
+
+        StringMap map = StringMap_New(0, 1);
+        double start = Bench_Now();
+        for (size_t ii = 0; ii < count; ii++) {
+            StringMap_Set(&map, StringView_FromCString(&keys[order[ii] * 16]), (void*)ii);
+        }
+        double insert = (Bench_Now() - start) / (double)count;
+        StringMap_Delete(&map);
+
+        map = StringMap_New(count, 1);
+        start = Bench_Now();
+        for (size_t ii = 0; ii < count; ii++) {
+            StringMap_Set(&map, StringView_FromCString(&keys[order[ii] * 16]), (void*)ii);
+        }
+        double presized = (Bench_Now() - start) / (double)count;
+
+        start = Bench_Now();
+        for (size_t ii = 0; ii < count; ii++) {
+            bench_sink += (size_t)StringMap_Get(&map, StringView_FromCString(&keys[ii * 16]));
+        }
+        double hit = (Bench_Now() - start) / (double)count;
+
+        start = Bench_Now();
+        for (size_t ii = 0; ii < count; ii++) {
+            keys[ii * 16] = 'U';
+            bench_sink += StringMap_Contains(&map, StringView_FromCString(&keys[ii * 16]));
+        }
+        double miss = (Bench_Now() - start) / (double)count;
+
+        printf("%12zu %10.1f %10.1f %10.1f %10.1f\n", count, insert, presized, hit, miss);
+        StringMap_Delete(&map);
+        free(keys);
+        free(order);
+    }
+    printf("\n");
+}
+
+/* ---- Interning ---- */
+
+#define BENCH_VOCAB 4000
+#define BENCH_FIELDS 4000000
+
+static void bench_interning(void)
+{
+    // field names of 6-45 chars, drawn with a skewed distribution so a few hundred of them make up most of the data
+    String vocab = String_New(BENCH_VOCAB * 48);
+    Bench_FillText(&vocab, 11);
+    StringView names[BENCH_VOCAB];
+    for (size_t ii = 0; ii < BENCH_VOCAB; ii++) {
+        names[ii] = String_SliceView(&vocab, ii * 48, ii * 48 + 6 + (ii * 7919) % 40);
+    }
+
+    StringList fields = { .len = BENCH_FIELDS, .str = malloc(sizeof(String) * BENCH_FIELDS) };
+    size_t before = Bench_HeapInUse();
+    unsigned seed = 13;
+    for (size_t ii = 0; ii < BENCH_FIELDS; ii++) {
+        seed = seed * 1103515245 + 12345;
+        unsigned r = (seed >> 8) % (BENCH_VOCAB * BENCH_VOCAB);
+        fields.str[ii] = String_FromView(names[(size_t)(r / BENCH_VOCAB) * r / (BENCH_VOCAB * BENCH_VOCAB)]);
+    }
+    size_t separate = Bench_HeapInUse() - before + sizeof(String) * BENCH_FIELDS;
+
+    const String** interned = malloc(sizeof(String*) * BENCH_FIELDS);
+    StringInterner in = StringInterner_New(1, false);
+    before = Bench_HeapInUse();
+    double start = Bench_Now();
+    for (size_t ii = 0; ii < BENCH_FIELDS; ii++) {
+        interned[ii] = StringInterner_Intern(&in, String_View(&fields.str[ii]));
+    }
+    double intern = (Bench_Now() - start) / BENCH_FIELDS;
+    size_t pooled = Bench_HeapInUse() - before + sizeof(String*) * BENCH_FIELDS;
+    size_t distinct = in.len;
+    StringInterner_Delete(&in);
+
+    in = StringInterner_New(1, false);
+    start = Bench_Now();
+    StringInterner_InternList(&in, &fields, interned);
+    double bulk = (Bench_Now() - start) / BENCH_FIELDS;
+    StringInterner_Delete(&in);
+
+    in = StringInterner_New(1, true);
+    start = Bench_Now();
+    for (size_t ii = 0; ii < BENCH_FIELDS; ii++) {
+        interned[ii] = StringInterner_Intern(&in, String_View(&fields.str[ii]));
+    }
+    double locked = (Bench_Now() - start) / BENCH_FIELDS;
+
+    printf("== interning %d fields, %zu distinct ==\n", BENCH_FIELDS, distinct);
+    printf("%20s %10.1f ns/field\n", "intern", intern);
+    printf("%20s %10.1f ns/field\n", "intern list", bulk);
+    printf("%20s %10.1f ns/field\n", "intern thread-safe", locked);
+    printf("%20s %10.1f bytes/field\n", "separate Strings", (double)separate / BENCH_FIELDS);
+    printf("%20s %10.1f bytes/field\n", "interned", (double)pooled / BENCH_FIELDS);
+
+    // count the fields equal to their predecessor
+    size_t equal = 0;
+    start = Bench_Now();
+    for (size_t ii = 1; ii < BENCH_FIELDS; ii++) {
+        equal += String_Equal(&fields.str[ii - 1], &fields.str[ii]);
+    }
+    double by_content = (Bench_Now() - start) / BENCH_FIELDS;
+
+    start = Bench_Now();
+    for (size_t ii = 1; ii < BENCH_FIELDS; ii++) {
+        equal += interned[ii - 1] == interned[ii];
+    }
+    double by_pointer = (Bench_Now() - start) / BENCH_FIELDS;
+    bench_sink += equal;
+
+    printf("%20s %10.2f ns/compare\n", "String_Equal", by_content);
+    printf("%20s %10.2f ns/compare\n\n", "pointer", by_pointer);
+
+    StringInterner_Delete(&in);
+    free(interned);
+    for (size_t ii = 0; ii < BENCH_FIELDS; ii++) {
+        String_Delete(&fields.str[ii]);
+    }
+    free(fields.str);
+    String_Delete(&vocab);
+}
+
+/* ---- Memory footprint ---- */
+
+#define BENCH_RECORDS 4000000
+
+// Builds a corpus of `BENCH_RECORDS` newline separated records, mostly short words with some longer phrases
+static String Bench_RecordCorpus(void)
+{
+    StringBuilder sb = StringBuilder_New(0);
+    unsigned seed = 7;
+    for (size_t ii = 0; ii < BENCH_RECORDS; ii++) {
+        seed = seed * 1103515245 + 12345;
+        unsigned r = (seed >> 16) % 100;
+        size_t len = r < 60 ? 2 + r % 11 : r < 90 ? 13 + r % 28 : 41 + (seed >> 8) % 160;
+        for (size_t jj = 0; jj < len; jj++) {
+            seed = seed * 1103515245 + 12345;
+            StringBuilder_AppendChar(&sb, (char)('a' + (seed >> 16) % 26));
+        }
+        StringBuilder_AppendChar(&sb, '\n');
+    }
+
+    return StringBuilder_Finalize(&sb);
+}
+
+// Next record of `corpus` starting at `*pos`
+static StringView Bench_NextRecord(const String* corpus, size_t* pos)
+{
+    const char* start = &String_Buf(corpus)[*pos];
+    const char* end = memchr(start, '\n', corpus->len - *pos);
+    *pos += (size_t)(end - start) + 1;
+
+    return StringView_FromCharArray(start, (size_t)(end - start));
+}
+
+static void Bench_PrintFootprint(const char* name, size_t bytes, size_t chars)
+{
+    printf(
+        "%22s %12.1f %14.1f %10.1f\n",
+        name,
+        (double)bytes / BENCH_RECORDS,
+        (double)(bytes - chars) / BENCH_RECORDS,
+        (double)bytes / (1 << 20));
+}
+
+static void bench_footprint(void)
+{
+    String corpus = Bench_RecordCorpus();
+    size_t chars = corpus.len - BENCH_RECORDS;
+    size_t pos = 0;
+
+    printf(
+        "== memory footprint, %d records, %.1f chars/record, sizeof(String) = %zu, SSO capacity %zu ==\n",
+        BENCH_RECORDS,
+        (double)chars / BENCH_RECORDS,
+        sizeof(String),
+        (size_t)STRING_SSO_CAPACITY);
+    printf("%22s %12s %14s %10s\n", "representation", "bytes/record", "overhead/record", "MiB");
+
+    size_t before = Bench_HeapInUse();
+    String* strs = malloc(sizeof(String) * BENCH_RECORDS);
+    for (size_t ii = 0; ii < BENCH_RECORDS; ii++) {
+        strs[ii] = String_FromView(Bench_NextRecord(&corpus, &pos));
+    }
+    Bench_PrintFootprint("String[]", Bench_HeapInUse() - before, chars);
+    for (size_t ii = 0; ii < BENCH_RECORDS; ii++) {
+        String_Delete(&strs[ii]);
+    }
+    free(strs);
+
+    before = Bench_HeapInUse();
+    StringList list = String_Split(&corpus, str("\n"));
+    Bench_PrintFootprint("StringList (Split)", Bench_HeapInUse() - before, chars);
+    StringList_Delete(&list);
+
+    pos = 0;
+    before = Bench_HeapInUse();
+    StringPacked* packed = malloc(sizeof(StringPacked) * BENCH_RECORDS);
+    for (size_t ii = 0; ii < BENCH_RECORDS; ii++) {
+        packed[ii] = StringPacked_FromView(Bench_NextRecord(&corpus, &pos));
+    }
+    Bench_PrintFootprint("StringPacked[]", Bench_HeapInUse() - before, chars);
+    for (size_t ii = 0; ii < BENCH_RECORDS; ii++) {
+        StringPacked_Delete(&packed[ii]);
+    }
+
+    pos = 0;
+    before = Bench_HeapInUse();
+    StringArena arena = StringArena_New(1 << 20);
+    String_SetAllocator(&arena.base);
+    for (size_t ii = 0; ii < BENCH_RECORDS; ii++) {
+        packed[ii] = StringPacked_FromView(Bench_NextRecord(&corpus, &pos));
+    }
+    String_SetAllocator(NULL);
+    Bench_PrintFootprint("StringPacked[] (arena)", Bench_HeapInUse() - before + sizeof(StringPacked) * BENCH_RECORDS, chars);
+    StringArena_Delete(&arena);
+    free(packed);
+
+    printf("\n");
+    String_Delete(&corpus);
+}
+
+/* ---- Memory-mapped files ---- */
+
+// Size of the file searched by the mapping benchmark
+#ifndef BENCH_MAP_FILE_SIZE
+#define BENCH_MAP_FILE_SIZE (512u << 20)
+#endif
+
+static void bench_mapping(void)
+{
+    const char* path = "bench_map.txt";
+    String text = String_New(BENCH_MAP_FILE_SIZE);
+    Bench_FillText(&text, 23);
+    FILE* fd = fopen(path, "wb");
+    if (!fd) {
+        perror(path);
+        return;
+    }
+    String_Write(&text, fd);
+    fclose(fd);
+    String_Delete(&text);
+
+    printf("== searching a %u MiB file (warm page cache) ==\n", BENCH_MAP_FILE_SIZE >> 20);
+    printf("%28s %10s %14s\n", "", "ms", "heap (MiB)");
+
+    // fread into a buffer, then copy into a String
+    size_t heap = Bench_HeapInUse();
+    double start = Bench_Now();
+    fd = fopen(path, "rb");
+    char* buf = malloc(BENCH_MAP_FILE_SIZE);
+    size_t read = fread(buf, 1, BENCH_MAP_FILE_SIZE, fd);
+    fclose(fd);
+    String copy = String_FromCharArray(buf, read);
+    bench_sink += String_InstancesOf(&copy, str("the"));
+    size_t peak = Bench_HeapInUse() - heap;
+    free(buf);
+    String_Delete(&copy);
+    printf("%28s %10.1f %14.1f\n", "fread + String_FromCharArray", (Bench_Now() - start) / 1e6, (double)peak / (1 << 20));
+
+    heap = Bench_HeapInUse();
+    start = Bench_Now();
+    String mapped;
+    if (String_MapFile(path, &mapped)) {
+        bench_sink += String_InstancesOf(&mapped, str("the"));
+        peak = Bench_HeapInUse() - heap;
+        String_UnmapFile(&mapped);
+        printf("%28s %10.1f %14.1f\n", "String_MapFile", (Bench_Now() - start) / 1e6, (double)peak / (1 << 20));
+    }
+
+    remove(path);
+    printf("\n");
+}
+
+/* ---- Streaming reader ---- */
+
+static void bench_reader(void)
+{
+    const char* path = "bench_map.txt";
+    String text = String_New(BENCH_MAP_FILE_SIZE / 2);
+    Bench_FillLog(&text, 29);
+    FILE* fd = fopen(path, "wb");
+    if (!fd) {
+        perror(path);
+        return;
+    }
+    String_Write(&text, fd);
+    fclose(fd);
+    String_Delete(&text);
+
+    printf("== reading lines of a %u MiB log (warm page cache) ==\n", BENCH_MAP_FILE_SIZE >> 21);
+    printf("%32s %10s %10s %12s\n", "", "ms", "lines", "allocs");
+
+    size_t allocs = bench_allocs;
+    double start = Bench_Now();
+    fd = fopen(path, "rb");
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    size_t lines = 0;
+    while ((len = getline(&line, &cap, fd)) > 0) {
+        line[len - 1] = '\0';
+        String str = String_FromCString(line);
+        lines += String_StartsWith(&str, str("2024"));
+        String_Delete(&str);
+    }
+    free(line);
+    fclose(fd);
+    printf("%32s %10.1f %10zu %12zu\n", "getline + String_FromCString", (Bench_Now() - start) / 1e6, lines, bench_allocs - allocs);
+
+    allocs = bench_allocs;
+    start = Bench_Now();
+    fd = fopen(path, "rb");
+    StringReader reader = StringReader_New(fd, '\n', 0);
+    StringView record;
+    lines = 0;
+    while (StringReader_Next(&reader, &record)) {
+        lines += StringView_StartsWith(record, strview("2024"));
+    }
+    StringReader_Delete(&reader);
+    fclose(fd);
+    printf("%32s %10.1f %10zu %12zu\n", "StringReader_Next", (Bench_Now() - start) / 1e6, lines, bench_allocs - allocs);
+
+    remove(path);
+    printf("\n");
+}
+
+/* ---- Vectored output ---- */
+
+static void Bench_WriteList(const StringList* list, const String* sep)
+{
+    const char* path = "bench_map.txt";
+    FILE* fd = fopen(path, "wb");
+    double start = Bench_Now();
+    for (size_t ii = 0; ii < list->len; ii++) {
+        if (ii) {
+            String_Write(sep, fd);
+        }
+        String_Write(&list->str[ii], fd);
+    }
+    fflush(fd);
+    double elapsed = Bench_Now() - start;
+    size_t bytes = (size_t)ftell(fd);
+    fclose(fd);
+    printf("%8zu %12.1f", bytes / list->len, (double)bytes / (1 << 20) / (elapsed / 1e9));
+
+    int raw = open(path, O_WRONLY | O_TRUNC);
+    start = Bench_Now();
+    bytes = (size_t)StringList_WriteV(raw, list, sep);
+    elapsed = Bench_Now() - start;
+    close(raw);
+    printf(" %12.1f\n", (double)bytes / (1 << 20) / (elapsed / 1e9));
+    remove(path);
+}
+
+static void bench_writev(void)
+{
+    String text = String_New(64 << 20);
+    Bench_FillLog(&text, 31);
+
+    printf("== writing a split log (MiB/s) ==\n");
+    printf("%8s %12s %12s\n", "piece", "String_Write", "WriteV");
+    const String* seps[] = { str(" "), str("\n") };
+    for (size_t ii = 0; ii < 2; ii++) {
+        StringList list = String_Split(&text, seps[ii]);
+        Bench_WriteList(&list, seps[ii]);
+        StringList_Delete(&list);
+    }
+
+    String_Delete(&text);
+    printf("\n");
+}
+
+/* ---- Joining ---- */
+
+// Joins `list` by repeatedly appending to the result of the previous String_Join
+static String Naive_JoinList(const StringList* list, const String* sep)
+{
+    String ret = String("");
+    for (size_t ii = 0; ii < list->len; ii++) {
+        String with_sep = ii ? String_Join(&ret, sep) : String_Copy(&ret);
+        String_Delete(&ret);
+        ret = String_Join(&with_sep, &list->str[ii]);
+        String_Delete(&with_sep);
+    }
+
+    return ret;
+}
+
+static void bench_join(void)
+{
+    static const size_t counts[] = { 4, 64, 1024, 16384 };
+
+    printf("== split + join of log fields (ns/field) ==\n");
+    printf("%10s %14s %16s\n", "fields", "String_Join", "StringList_Join");
+    for (size_t ii = 0; ii < sizeof(counts) / sizeof(counts[0]); ii++) {
+        String text = String_New(9 * counts[ii]);
+        Bench_FillLog(&text, 37);
+        StringList list = String_Split(&text, str(" "));
+        size_t iters = Bench_Iterations(list.len * list.len, 1 << 24);
+
+        double start = Bench_Now();
+        for (size_t jj = 0; jj < iters; jj++) {
+            String joined = Naive_JoinList(&list, str(" "));
+            bench_sink += joined.len;
+            String_Delete(&joined);
+        }
+        double naive = (Bench_Now() - start) / (double)(iters * list.len);
+
+        iters = Bench_Iterations(list.len, 1 << 24);
+        start = Bench_Now();
+        for (size_t jj = 0; jj < iters; jj++) {
+            String joined = StringList_Join(&list, str(" "));
+            bench_sink += joined.len;
+            String_Delete(&joined);
+        }
+        double joined = (Bench_Now() - start) / (double)(iters * list.len);
+
+        printf("%10zu %14.1f %16.1f\n", list.len, naive, joined);
+        StringList_Delete(&list);
+        String_Delete(&text);
+    }
+
+    printf("\n");
+}
+
+/* ---- Parallel operations ---- */
+
+// Largest thread count of the scaling benchmark, 0 for the number of online CPUs
+#ifndef BENCH_MAX_THREADS
+#define BENCH_MAX_THREADS 0
+#endif
+
+static void bench_parallel(void)
+{
+    String text = String_New(BENCH_MAP_FILE_SIZE / 2);
+    Bench_FillLog(&text, 41);
+    StringList fields = String_Split(&text, str(" "));
+    uint64_t* hashes = malloc(fields.len * sizeof(uint64_t));
+    long cpus = BENCH_MAX_THREADS ? BENCH_MAX_THREADS : sysconf(_SC_NPROCESSORS_ONLN);
+
+    printf("== parallel operations on a %u MiB log (GB/s) ==\n", BENCH_MAP_FILE_SIZE >> 21);
+    printf("%8s %12s %12s %12s %12s\n", "threads", "InstancesOf", "Distinct", "Replace", "ListHash");
+    for (size_t threads = 1; threads <= (size_t)(cpus > 0 ? cpus : 1); threads *= 2) {
+        StringThreadPool pool = StringThreadPool_New(threads);
+
+        double start = Bench_Now();
+        bench_sink += String_ParallelInstancesOf(&pool, &text, str("status=404"));
+        double instances = Bench_Now() - start;
+
+        start = Bench_Now();
+        bench_sink += String_ParallelDistinctInstancesOf(&pool, &text, str("status=404"));
+        double distinct = Bench_Now() - start;
+
+        start = Bench_Now();
+        String replaced = String_ParallelReplace(&pool, &text, str("status=404"), str("status=410"));
+        double replace = Bench_Now() - start;
+        String_Delete(&replaced);
+
+        start = Bench_Now();
+        StringList_ParallelHash(&pool, &fields, 1, hashes);
+        double hash = Bench_Now() - start;
+        bench_sink += hashes[fields.len / 2];
+
+        printf(
+            "%8zu %12.2f %12.2f %12.2f %12.2f\n",
+            StringThreadPool_Threads(&pool),
+            (double)text.len / instances,
+            (double)text.len / distinct,
+            (double)text.len / replace,
+            (double)text.len / hash);
+        StringThreadPool_Delete(&pool);
+    }
+
+    free(hashes);
+    StringList_Delete(&fields);
+    String_Delete(&text);
+    printf("\n");
+}
+
+/* ---- Sorting ---- */
+
+static int Bench_CompareStrings(const void* a, const void* b)
+{
+    ssize_t cmp = String_Compare(a, b);
+    return (cmp > 0) - (cmp < 0);
+}
+
+static void bench_sort(void)
+{
+    static const struct {
+        const char* name;
+        const char* delim;
+        size_t size;
+    } inputs[] = {
+        { "words", " ", 8 << 20 },
+        { "words", " ", 64 << 20 },
+        { "log lines", "\n", 64 << 20 },
+        { "log lines", "\n", 256 << 20 },
+    };
+
+    StringThreadPool pool = StringThreadPool_New(0);
+    printf("== sorting (ns/string), %zu threads for the parallel sort ==\n", StringThreadPool_Threads(&pool));
+    printf("%10s %10s %10s %14s %14s %10s\n", "input", "strings", "qsort", "StringList", "Parallel", "Unique");
+    for (size_t ii = 0; ii < sizeof(inputs) / sizeof(inputs[0]); ii++) {
+        String text = String_New(inputs[ii].size);
+        if (!strcmp(inputs[ii].name, "words")) {
+            Bench_FillText(&text, 43);
+        } else {
+            Bench_FillLog(&text, 43);
+        }
+        String delim = String(inputs[ii].delim);
+        double times[4] = { 0 };
+
+        for (size_t mode = 0; mode < 3; mode++) {
+            StringList list = String_Split(&text, &delim);
+            double start = Bench_Now();
+            if (mode == 0) {
+                qsort(list.str, list.len, sizeof(String), Bench_CompareStrings);
+            } else if (mode == 1) {
+                StringList_Sort(&list);
+            } else {
+                StringList_ParallelSort(&pool, &list);
+            }
+            times[mode] = (Bench_Now() - start) / (double)list.len;
+
+            if (mode == 2) {
+                start = Bench_Now();
+                bench_sink += StringList_Unique(&list);
+                times[3] = (Bench_Now() - start) / (double)list.len;
+                printf(
+                    "%10s %10zu %10.1f %14.1f %14.1f %10.1f\n",
+                    inputs[ii].name,
+                    list.len,
+                    times[0],
+                    times[1],
+                    times[2],
+                    times[3]);
+            }
+            StringList_Delete(&list);
+        }
+
+        String_Delete(&delim);
+        String_Delete(&text);
+    }
+
+    StringThreadPool_Delete(&pool);
+    printf("\n");
+}
+
+/* ---- Comparison ---- */
+
+// StringView_Equal and StringView_Compare as they were before the comparison kernels, a call to memcmp
+static bool Naive_Equal(StringView view_a, StringView view_b)
+{
+    return view_a.len == view_b.len && !memcmp(view_a.buf, view_b.buf, view_a.len);
+}
+
+static ssize_t Naive_Compare(StringView view_a, StringView view_b)
+{
+    size_t min_len = view_a.len < view_b.len ? view_a.len : view_b.len;
+    int cmp = memcmp(view_a.buf, view_b.buf, min_len);
+    return cmp ? (ssize_t)cmp : (ssize_t)view_a.len - (ssize_t)view_b.len;
+}
+
+static int Bench_NaiveCompareStrings(const void* a, const void* b)
+{
+    ssize_t cmp = Naive_Compare(String_View(a), String_View(b));
+    return (cmp > 0) - (cmp < 0);
+}
+
+static int Bench_ComparePrefixViews(const void* a, const void* b)
+{
+    ssize_t cmp = StringPrefixView_Compare(a, b);
+    return (cmp > 0) - (cmp < 0);
+}
+
+// Times `expr` on a different pair of misaligned views each iteration, so nothing is hoisted out of the loop, and
+// keeps the best of 3 runs since a few ns per op are easily lost to noise
+#define BENCH_COMPARE_LOOP(time, expr)                                                     \
+    do {                                                                                  \
+        (time) = 1e30;                                                                    \
+        for (size_t run = 0; run < 3; run++) {                                            \
+            double start = Bench_Now();                                                   \
+            for (size_t jj = 0; jj < iters; jj++) {                                       \
+                StringView view_a = { .len = lens[ii], .buf = &buf[jj & 63] };            \
+                StringView view_b = { .len = lens[ii], .buf = &buf[1024 + 64 + (jj & 63)] }; \
+                bench_sink += (expr);                                                     \
+            }                                                                             \
+            double elapsed = (Bench_Now() - start) / (double)iters;                       \
+            (time) = elapsed < (time) ? elapsed : (time);                                 \
+        }                                                                                 \
+    } while (0)
+
+static void bench_compare(void)
+{
+    static const size_t lens[] = { 4, 8, 12, 16, 24, 32, 64, 128, 1024 };
+
+    // equal views are the worst case, every byte has to be compared
+    printf("== comparing equal views (ns/op) ==\n");
+    printf("%10s %10s %10s %10s %10s\n", "len", "memcmp ==", "Equal", "memcmp <>", "Compare");
+    String text = String_New(2 * (1024 + 64));
+    Bench_FillText(&text, 5);
+    const char* buf = String_Buf(&text);
+    memcpy(String_Buf(&text) + 1024 + 64, buf, 1024 + 64);
+    for (size_t ii = 0; ii < sizeof(lens) / sizeof(lens[0]); ii++) {
+        size_t iters = Bench_Iterations(lens[ii], 1 << 26);
+        double times[4];
+        BENCH_COMPARE_LOOP(times[0], Naive_Equal(view_a, view_b));
+        BENCH_COMPARE_LOOP(times[1], StringView_Equal(view_a, view_b));
+        BENCH_COMPARE_LOOP(times[2], (size_t)Naive_Compare(view_a, view_b));
+        BENCH_COMPARE_LOOP(times[3], (size_t)StringView_Compare(view_a, view_b));
+        printf("%10zu %10.2f %10.2f %10.2f %10.2f\n", lens[ii], times[0], times[1], times[2], times[3]);
+    }
+    printf("\n");
+    String_Delete(&text);
+
+    static const struct {
+        const char* name;
+        const char* delim;
+    } inputs[] = {
+        { "words", " " },
+        { "log lines", "\n" },
+    };
+
+    printf("== qsort by comparator (ns/string) ==\n");
+    printf("%10s %10s %10s %10s %14s\n", "input", "strings", "memcmp", "Compare", "PrefixView");
+    for (size_t ii = 0; ii < sizeof(inputs) / sizeof(inputs[0]); ii++) {
+        String input = String_New(16 << 20);
+        if (!strcmp(inputs[ii].name, "words")) {
+            Bench_FillText(&input, 47);
+        } else {
+            Bench_FillLog(&input, 47);
+        }
+        String delim = String(inputs[ii].delim);
+        StringList list = String_Split(&input, &delim);
+        String* unsorted = malloc(list.len * sizeof(String));
+        memcpy(unsorted, list.str, list.len * sizeof(String));
+        double times[3];
+
+        for (size_t mode = 0; mode < 2; mode++) {
+            memcpy(list.str, unsorted, list.len * sizeof(String));
+            double start = Bench_Now();
+            qsort(list.str, list.len, sizeof(String), mode ? Bench_CompareStrings : Bench_NaiveCompareStrings);
+            times[mode] = (Bench_Now() - start) / (double)list.len;
+        }
+
+        // building the side table is part of the cost
+        double start = Bench_Now();
+        StringPrefixView* views = malloc(list.len * sizeof(StringPrefixView));
+        for (size_t jj = 0; jj < list.len; jj++) {
+            views[jj] = String_PrefixView(&unsorted[jj]);
+        }
+        qsort(views, list.len, sizeof(StringPrefixView), Bench_ComparePrefixViews);
+        times[2] = (Bench_Now() - start) / (double)list.len;
+
+        printf("%10s %10zu %10.1f %10.1f %14.1f\n", inputs[ii].name, list.len, times[0], times[1], times[2]);
+        free(views);
+        free(unsorted);
+        StringList_Delete(&list);
+        String_Delete(&delim);
+        String_Delete(&input);
+    }
+    printf("\n");
+}
+
+/* ---- Shared Strings ---- */
+
+#define BENCH_STAGES 8
+
+// Passes `payload` through BENCH_STAGES stages, each keeping its own copy (and a slice without the first and last
+// byte) until the end of the pipeline, like a chain of handlers that each hold on to the request body
+static void Bench_Pipeline(const String* payload, bool shared, double* ns, size_t* peak)
+{
+    String copies[2 * BENCH_STAGES];
+    size_t heap = Bench_HeapInUse();
+    double start = Bench_Now();
+    const String* prev = payload;
+    for (size_t ii = 0; ii < BENCH_STAGES; ii++) {
+        copies[2 * ii] = shared ? String_Retain(prev) : String_Copy(prev);
+        prev = &copies[2 * ii];
+        copies[2 * ii + 1] = shared ? String_SliceShared(prev, 1, prev->len - 1) : String_Slice(prev, 1, prev->len - 1);
+        bench_sink += String_Buf(&copies[2 * ii + 1])[0];
+    }
+    *peak = Bench_HeapInUse() - heap;
+    for (size_t ii = 0; ii < 2 * BENCH_STAGES; ii++) {
+        String_Delete(&copies[ii]);
+    }
+    *ns = Bench_Now() - start;
+}
+
+static void bench_shared(void)
+{
+    printf("== %d stage pipeline, a copy and a slice per stage (us, MiB of heap) ==\n", BENCH_STAGES);
+    printf("%10s %10s %10s %10s %10s\n", "payload", "copy", "heap", "shared", "heap");
+    for (size_t size = 1 << 10; size <= 64 << 20; size <<= 4) {
+        String text = String_New(size);
+        Bench_FillText(&text, 53);
+        String payload = String_Share(&text);
+
+        double copy_ns;
+        double shared_ns;
+        size_t copy_peak;
+        size_t shared_peak;
+        Bench_Pipeline(&text, false, &copy_ns, &copy_peak);
+        Bench_Pipeline(&payload, true, &shared_ns, &shared_peak);
+        printf(
+            "%10zu %10.1f %10.2f %10.1f %10.2f\n",
+            size,
+            copy_ns / 1e3,
+            (double)copy_peak / (1 << 20),
+            shared_ns / 1e3,
+            (double)shared_peak / (1 << 20));
+
+        String_Delete(&payload);
+        String_Delete(&text);
+    }
+    printf("\n");
+}
+
+/* ---- Rope ---- */
+
+#define BENCH_EDITS 200
+
+// Applies BENCH_EDITS edits (insert a word, remove a few chars, both at pseudo-random positions) to a document
+// either kept flat, rebuilding it with String_Slice and String_Join, or as a rope, then searches it for a word
+// inserted near the end, returns the ns per edit and stores the ns of the search in `find_ns`
+static double Bench_Edits(const String* doc, bool rope, double* find_ns)
+{
+    unsigned seed = 97;
+    String flat = String_Copy(doc);
+    StringRope text = rope ? StringRope_FromString(doc) : StringRope_New();
+    double start = Bench_Now();
+    size_t len = doc->len;
+    for (size_t ii = 0; ii < BENCH_EDITS; ii++) {
+        seed = seed * 1103515245 + 12345;
+        size_t pos = (seed >> 4) % (len - 8);
+        if (ii == BENCH_EDITS - 1) {
+            pos = len - 100;
+        }
+        if (rope) {
+            StringRope_Insert(&text, pos, str("inserted "));
+            StringRope_Remove(&text, pos / 2, pos / 2 + 5);
+        } else {
+            String before = String_Slice(&flat, 0, pos);
+            String after = String_Slice(&flat, pos, flat.len);
+            String head = String_Join(&before, str("inserted "));
+            String edited = String_Join(&head, &after);
+            String_Delete(&before);
+            String_Delete(&after);
+            String_Delete(&head);
+            String_Delete(&flat);
+            before = String_Slice(&edited, 0, pos / 2);
+            after = String_Slice(&edited, pos / 2 + 5, edited.len);
+            flat = String_Join(&before, &after);
+            String_Delete(&before);
+            String_Delete(&after);
+            String_Delete(&edited);
+        }
+        len += 4;
+    }
+    double edit_ns = (Bench_Now() - start) / BENCH_EDITS;
+
+    start = Bench_Now();
+    const String* word = str("inserted inserted ");
+    ssize_t found = rope ? StringRope_Find(&text, word, 0) : String_FirstOccurrenceOf(&flat, word);
+    bench_sink += (size_t)found;
+    *find_ns = Bench_Now() - start;
+
+    StringRope_Delete(&text);
+    String_Delete(&flat);
+    return edit_ns;
+}
+
+static void bench_rope(void)
+{
+    printf("== %d edits of a document, flat String vs StringRope (us per edit, us to search) ==\n", BENCH_EDITS);
+    printf("%10s %10s %10s %10s %10s\n", "document", "flat", "search", "rope", "search");
+    for (size_t size = 1 << 18; size <= 16 << 20; size <<= 2) {
+        String doc = String_New(size);
+        Bench_FillText(&doc, 59);
+
+        double flat_find;
+        double rope_find;
+        double flat_edit = Bench_Edits(&doc, false, &flat_find);
+        double rope_edit = Bench_Edits(&doc, true, &rope_find);
+        printf(
+            "%10zu %10.2f %10.1f %10.2f %10.1f\n",
+            size,
+            flat_edit / 1e3,
+            flat_find / 1e3,
+            rope_edit / 1e3,
+            rope_find / 1e3);
+
+        String_Delete(&doc);
+    }
+    printf("\n");
+}
+
+/* ---- UTF-8 ---- */
+
+// Validates `buf` one code point at a time, like the loops strlib's validator replaces
+static bool Scalar_ValidUtf8(const char* buf, size_t len)
+{
+    uint32_t cp;
+    for (size_t ii = 0; ii < len;) {
+        size_t n = StrLib_Utf8Decode((const unsigned char*)&buf[ii], len - ii, &cp);
+        if (!n) {
+            return false;
+        }
+        ii += n;
+    }
+
+    return true;
+}
+
+static size_t Scalar_Utf8Len(const char* buf, size_t len)
+{
+    size_t count = 0;
+    for (size_t ii = 0; ii < len; ii++) {
+        count += ((unsigned char)buf[ii] & 0xC0) != 0x80;
+    }
+
+    return count;
+}
+
+// Fills `str` with text whose words are made of the code points in `cps` (with spaces between them)
+static void Bench_FillUtf8(String* str, const uint32_t* cps, size_t count, unsigned seed)
+{
+    char* dst = String_Buf(str);
+    size_t len = 0;
+    while (len + 4 < str->len) {
+        seed = seed * 1103515245 + 12345;
+        unsigned r = (seed >> 16) % (count + 4);
+        len += StrLib_Utf8Encode(r < count ? cps[r] : ' ', &dst[len]);
+    }
+    memset(&dst[len], ' ', str->len - len);
+}
+
+static void bench_utf8(void)
+{
+    static const uint32_t latin[] = { 'a', 'e', 'n', 'r', 's', 't', 0xE9, 0xE8, 0xF6, 0xFC, 0xDF, 0xE7 };
+    static const uint32_t cjk[] = { 0x65E5, 0x672C, 0x8A9E, 0x4E2D, 0x6587, 0x5B57, 0x3042, 0x3044, 0x3046 };
+    static const uint32_t emoji[] = { 'o', 'k', '!', 0x1F389, 0x1F600, 0x1F44D, 0x2764, 0x1F525 };
+    static const struct {
+        const char* name;
+        const uint32_t* cps;
+        size_t count;
+    } inputs[] = {
+        { "ascii", NULL, 0 },
+        { "latin", latin, sizeof(latin) / sizeof(latin[0]) },
+        { "cjk", cjk, sizeof(cjk) / sizeof(cjk[0]) },
+        { "emoji", emoji, sizeof(emoji) / sizeof(emoji[0]) },
+    };
+
+    printf("== UTF-8 on 1 MiB of text, one code point at a time vs strlib (GB/s) ==\n");
+    printf("%10s %10s %10s %10s %10s %10s\n", "text", "validate", "strlib", "count", "strlib", "to utf16");
+    String text = String_New(1 << 20);
+    uint16_t* utf16 = malloc(text.len * sizeof(uint16_t));
+    for (size_t ii = 0; ii < sizeof(inputs) / sizeof(inputs[0]); ii++) {
+        if (inputs[ii].cps) {
+            Bench_FillUtf8(&text, inputs[ii].cps, inputs[ii].count, 61);
+        } else {
+            Bench_FillText(&text, 61);
+        }
+
+        size_t iters = Bench_Iterations(text.len, 1 << 28);
+        double gbs[5];
+        for (size_t fn = 0; fn < 5; fn++) {
+            double start = Bench_Now();
+            for (size_t jj = 0; jj < iters; jj++) {
+                switch (fn) {
+                case 0: bench_sink += Scalar_ValidUtf8(String_Buf(&text), text.len); break;
+                case 1: bench_sink += String_ValidateUtf8(&text); break;
+                case 2: bench_sink += Scalar_Utf8Len(String_Buf(&text), text.len); break;
+                case 3: bench_sink += String_Utf8Len(&text); break;
+                default: bench_sink += (size_t)StringView_ToUtf16(String_View(&text), utf16); break;
+                }
+            }
+            gbs[fn] = (double)text.len * (double)iters / (Bench_Now() - start);
+        }
+
+        printf(
+            "%10s %10.2f %10.2f %10.2f %10.2f %10.2f\n", inputs[ii].name, gbs[0], gbs[1], gbs[2], gbs[3], gbs[4]);
+    }
+    printf("\n");
+    free(utf16);
+    String_Delete(&text);
+
+    printf("== code point slicing of a 4 MiB latin document, 1000 slices (us) ==\n");
+    printf("%10s %10s %10s\n", "offset", "index", "build");
+    text = String_New(4 << 20);
+    Bench_FillUtf8(&text, latin, sizeof(latin) / sizeof(latin[0]), 67);
+    size_t len = String_Utf8Len(&text);
+
+    double start = Bench_Now();
+    for (size_t ii = 0; ii < 1000; ii++) {
+        size_t cp = (ii * 7919) % len;
+        bench_sink += StringView_Utf8Slice(String_View(&text), cp, cp + (len - cp) / 2 / (ii + 1)).len;
+    }
+    double offset = Bench_Now() - start;
+
+    start = Bench_Now();
+    StringUtf8Index index = StringUtf8Index_New(String_View(&text));
+    double build = Bench_Now() - start;
+    start = Bench_Now();
+    for (size_t ii = 0; ii < 1000; ii++) {
+        size_t cp = (ii * 7919) % len;
+        bench_sink += StringUtf8Index_Slice(&index, cp, cp + (len - cp) / 2 / (ii + 1)).len;
+    }
+    double indexed = Bench_Now() - start;
+    printf("%10.1f %10.1f %10.1f\n\n", offset / 1e3, indexed / 1e3, build / 1e3);
+
+    StringUtf8Index_Delete(&index);
+    String_Delete(&text);
+}
+
+/* ---- Function suite ---- */
+
+// Every public function is measured on each input kind at each size, and reported as one row of
+// function, input, size, ns/op, bytes/s and allocs/op (as text, CSV or JSON lines, see main)
+
+static enum { BENCH_TEXT, BENCH_CSV, BENCH_JSON } bench_format = BENCH_TEXT;
+
+// Minimum time spent measuring each row, in ns
+static double bench_min_time = 10e6;
+
+// Command line filters, a function or section runs if its name contains any of them (or there are none)
+static char** bench_filters;
+static int bench_filter_count;
+
+// Realistic input read from a file with --corpus, the built-in log corpus is used otherwise
+static String bench_corpus_file;
+
+static bool Bench_Selected(const char* name)
+{
+    for (int ii = 0; ii < bench_filter_count; ii++) {
+        if (strstr(name, bench_filters[ii])) {
+            return true;
+        }
+    }
+
+    return bench_filter_count == 0;
+}
+
+typedef struct {
+    const char* name; // "random", "adversarial" or "corpus"
+    String text;      // input of the size being measured
+    String copy;      // equal copy of `text`
+    String needle;    // substring that occurs once, near the end of `text`
+    String repl;      // replacement for `needle`
+    String delim;     // delimiter occurring throughout `text`
+    StringCharSet absent; // chars that don't occur in `text`
+    StringMatcher matcher; // `needle` and a few patterns that don't occur
+    StringMap map;         // has `text` as a key
+    StringList pieces;     // `text` split on `delim`
+} BenchInput;
+
+typedef size_t BenchFn(const BenchInput* in);
+
+// Fills `str` with (repeated) contents of the --corpus file
+static void Bench_FillCorpusFile(String* str)
+{
+    for (size_t pos = 0; pos < str->len; pos += bench_corpus_file.len) {
+        size_t len = str->len - pos < bench_corpus_file.len ? str->len - pos : bench_corpus_file.len;
+        memcpy(&String_Buf(str)[pos], String_Buf(&bench_corpus_file), len);
+    }
+}
+
+static BenchInput Bench_MakeInput(const char* name, size_t size)
+{
+    BenchInput in = { .name = name, .text = String_New(size) };
+    char* text = String_Buf(&in.text);
+
+    if (!strcmp(name, "adversarial")) {
+        // "aaaa...ab", every position is a near match of the needle
+        memset(text, 'a', size);
+        text[size - 1] = 'b';
+        in.needle = String("aaaaaaab");
+        in.repl = String("ccccccc");
+        in.delim = String("aaab");
+    } else if (!strcmp(name, "corpus")) {
+        if (bench_corpus_file.len) {
+            Bench_FillCorpusFile(&in.text);
+        } else {
+            Bench_FillLog(&in.text, 17);
+        }
+        in.needle = String("status=500");
+        in.repl = String("status=503 retried");
+        in.delim = String("\n");
+    } else {
+        Bench_FillText(&in.text, 19);
+        in.needle = String("#needle#");
+        in.repl = String("replacement");
+        in.delim = String(" ");
+    }
+
+    // place the needle near the end, unless the input is too short
+    if (size >= 2 * in.needle.len && strcmp(name, "adversarial")) {
+        memcpy(&text[size - size / 8 - in.needle.len], String_Buf(&in.needle), in.needle.len);
+    }
+
+    in.copy = String_Copy(&in.text);
+    in.absent = StringCharSet_FromView(strview("\x01\x02|"));
+    String patterns[] = { in.needle, String("\x01\x02"), String("zzzzzzzzzz"), String("\x03needle") };
+    in.matcher = StringMatcher_New(patterns, 4);
+    for (size_t ii = 1; ii < 4; ii++) {
+        String_Delete(&patterns[ii]);
+    }
+    in.map = StringMap_New(0, 1);
+    StringMap_Set(&in.map, String_View(&in.text), NULL);
+    in.pieces = String_Split(&in.text, &in.delim);
+
+    return in;
+}
+
+static void Bench_DeleteInput(BenchInput* in)
+{
+    String_Delete(&in->text);
+    String_Delete(&in->copy);
+    String_Delete(&in->needle);
+    String_Delete(&in->repl);
+    String_Delete(&in->delim);
+    StringMatcher_Delete(&in->matcher);
+    StringMap_Delete(&in->map);
+    StringList_Delete(&in->pieces);
+}
+
+// Defines a benchmark of `expr`, which is converted to size_t
+#define BENCH_VALUE(name, expr)                  \
+    static size_t name(const BenchInput* in)     \
+    {                                            \
+        (void)in;                                \
+        return (size_t)(expr);                   \
+    }
+
+// Defines a benchmark of `expr`, which returns a String that is deleted afterwards
+#define BENCH_STRING(name, expr)                 \
+    static size_t name(const BenchInput* in)     \
+    {                                            \
+        String ret = (expr);                     \
+        size_t len = ret.len;                    \
+        String_Delete(&ret);                     \
+        return len;                              \
+    }
+
+BENCH_STRING(Fn_New, String_New(in->text.len))
+BENCH_STRING(Fn_NewHeap, String_NewHeap(in->text.len))
+BENCH_STRING(Fn_FromCharArray, String_FromCharArray(String_Buf(&in->text), in->text.len))
+BENCH_STRING(Fn_Copy, String_Copy(&in->text))
+BENCH_STRING(Fn_Join, String_Join(&in->text, &in->needle))
+BENCH_VALUE(Fn_FirstOccurrenceOf, String_FirstOccurrenceOf(&in->text, &in->needle))
+BENCH_VALUE(Fn_LastOccurrenceOf, String_LastOccurrenceOf(&in->text, &in->needle))
+BENCH_VALUE(Fn_Contains, String_Contains(&in->text, &in->repl))
+BENCH_VALUE(Fn_StartsWith, String_StartsWith(&in->text, &in->copy))
+BENCH_VALUE(Fn_EndsWith, String_EndsWith(&in->text, &in->copy))
+BENCH_VALUE(Fn_Compare, String_Compare(&in->text, &in->copy))
+BENCH_VALUE(Fn_Equal, String_Equal(&in->text, &in->copy))
+BENCH_VALUE(Fn_InstancesOf, String_InstancesOf(&in->text, &in->delim))
+BENCH_VALUE(Fn_DistinctInstancesOf, String_DistinctInstancesOf(&in->text, &in->delim))
+BENCH_STRING(Fn_Replace, String_Replace(&in->text, &in->delim, &in->repl))
+BENCH_STRING(Fn_Trim, String_Trim(&in->text))
+BENCH_STRING(Fn_TrimSet, String_TrimSet(&in->text, &in->absent))
+BENCH_STRING(Fn_Slice, String_Slice(&in->text, 1, in->text.len - 1))
+BENCH_VALUE(Fn_TrimView, String_TrimView(&in->text).len)
+BENCH_VALUE(Fn_FindFirstOf, StringView_FindFirstOf(String_View(&in->text), &in->absent))
+BENCH_VALUE(Fn_FindLastNotOf, StringView_FindLastNotOf(String_View(&in->copy), &in->absent))
+BENCH_VALUE(Fn_MatcherCount, StringMatcher_Count(&in->matcher, &in->text))
+BENCH_VALUE(Fn_Hash, String_Hash(&in->text, 0))
+BENCH_STRING(Fn_ListJoin, StringList_Join(&in->pieces, &in->delim))
+BENCH_VALUE(Fn_MapGet, StringMap_Contains(&in->map, String_View(&in->copy)))
+
+static size_t Fn_ReplaceMany(const BenchInput* in)
+{
+    StringReplacement reps[] = { { &in->needle, &in->repl }, { &in->delim, &in->repl } };
+    String ret = String_ReplaceMany(&in->text, reps, 2);
+    size_t len = ret.len;
+    String_Delete(&ret);
+    return len;
+}
+
+static size_t Fn_FindAll(const BenchInput* in)
+{
+    size_t positions[64];
+    return String_FindAll(&in->text, &in->delim, false, positions, 64);
+}
+
+static size_t Fn_FindIter(const BenchInput* in)
+{
+    StringFindIterator it = String_FindIter(&in->text, &in->delim, true);
+    size_t pos;
+    size_t sum = 0;
+    while (StringFindIterator_Next(&it, &pos)) {
+        sum += pos;
+    }
+    return sum;
+}
+
+static size_t Fn_Split(const BenchInput* in)
+{
+    StringList list = String_Split(&in->text, &in->delim);
+    size_t len = list.len;
+    StringList_Delete(&list);
+    return len;
+}
+
+static size_t Fn_SplitIter(const BenchInput* in)
+{
+    StringSplitIterator it = String_SplitIter(&in->text, &in->delim);
+    StringView piece;
+    size_t count = 0;
+    while (StringSplitIterator_Next(&it, &piece)) {
+        count += 1;
+    }
+    return count;
+}
+
+static size_t Fn_ViewSplit(const BenchInput* in)
+{
+    StringView pieces[64];
+    return StringView_Split(String_View(&in->text), String_View(&in->delim), pieces, 64);
+}
+
+static size_t Fn_Builder(const BenchInput* in)
+{
+    StringBuilder sb = StringBuilder_New(0);
+    for (size_t pos = 0; pos < in->text.len; pos += 64) {
+        size_t len = in->text.len - pos < 64 ? in->text.len - pos : 64;
+        StringBuilder_AppendCharArray(&sb, &String_Buf(&in->text)[pos], len);
+    }
+    String ret = StringBuilder_Finalize(&sb);
+    size_t len = ret.len;
+    String_Delete(&ret);
+    return len;
+}
+
+static size_t Fn_Pack(const BenchInput* in)
+{
+    StringPacked packed = String_Pack(&in->text);
+    size_t len = StringPacked_Len(packed);
+    StringPacked_Delete(&packed);
+    return len;
+}
+
+static const struct {
+    const char* function;
+    BenchFn* fn;
+} bench_functions[] = {
+    { "String_New", Fn_New },
+    { "String_NewHeap", Fn_NewHeap },
+    { "String_FromCharArray", Fn_FromCharArray },
+    { "String_Copy", Fn_Copy },
+    { "String_Join", Fn_Join },
+    { "String_FirstOccurrenceOf", Fn_FirstOccurrenceOf },
+    { "String_LastOccurrenceOf", Fn_LastOccurrenceOf },
+    { "String_Contains", Fn_Contains },
+    { "String_StartsWith", Fn_StartsWith },
+    { "String_EndsWith", Fn_EndsWith },
+    { "String_Compare", Fn_Compare },
+    { "String_Equal", Fn_Equal },
+    { "String_InstancesOf", Fn_InstancesOf },
+    { "String_DistinctInstancesOf", Fn_DistinctInstancesOf },
+    { "String_FindAll", Fn_FindAll },
+    { "String_Replace", Fn_Replace },
+    { "String_ReplaceMany", Fn_ReplaceMany },
+    { "String_Split", Fn_Split },
+    { "String_Trim", Fn_Trim },
+    { "String_TrimSet", Fn_TrimSet },
+    { "String_Slice", Fn_Slice },
+    { "String_TrimView", Fn_TrimView },
+    { "StringView_Split", Fn_ViewSplit },
+    { "StringView_FindFirstOf", Fn_FindFirstOf },
+    { "StringView_FindLastNotOf", Fn_FindLastNotOf },
+    { "StringSplitIterator_Next", Fn_SplitIter },
+    { "StringFindIterator_Next", Fn_FindIter },
+    { "StringBuilder_AppendCharArray", Fn_Builder },
+    { "StringMatcher_Count", Fn_MatcherCount },
+    { "String_Hash", Fn_Hash },
+    { "StringMap_Contains", Fn_MapGet },
+    { "String_Pack", Fn_Pack },
+    { "StringList_Join", Fn_ListJoin },
+};
+
+static void Bench_Report(const char* function, const char* input, size_t size, double ns_per_op, double allocs_per_op)
+{
+    double bytes_per_sec = (double)size / ns_per_op * 1e9;
+    switch (bench_format) {
+    case BENCH_CSV:
+        printf("%s,%s,%zu,%.2f,%.0f,%.3f\n", function, input, size, ns_per_op, bytes_per_sec, allocs_per_op);
+        break;
+    case BENCH_JSON:
+        printf(
+            "{\"function\":\"%s\",\"input\":\"%s\",\"size\":%zu,\"ns_per_op\":%.2f,\"bytes_per_sec\":%.0f,"
+            "\"allocs_per_op\":%.3f}\n",
+            function,
+            input,
+            size,
+            ns_per_op,
+            bytes_per_sec,
+            allocs_per_op);
+        break;
+    default:
+        printf(
+            "%-30s %-12s %8zu %14.1f %12.1f %10.2f\n",
+            function,
+            input,
+            size,
+            ns_per_op,
+            bytes_per_sec / (1 << 20),
+            allocs_per_op);
+        break;
+    }
+}
+
+// Runs `fn` in batches of doubling size until at least bench_min_time has passed
+static void Bench_Run(const char* function, const BenchInput* in, BenchFn* fn)
+{
+    bench_sink += fn(in);
+
+    size_t allocs = bench_allocs;
+    size_t iters = 0;
+    double start = Bench_Now();
+    double elapsed = 0;
+    for (size_t batch = 1; elapsed < bench_min_time; batch *= 2) {
+        for (size_t ii = 0; ii < batch; ii++) {
+            bench_sink += fn(in);
+        }
+        iters += batch;
+        elapsed = Bench_Now() - start;
+    }
+
+    Bench_Report(function, in->name, in->text.len, elapsed / (double)iters, (double)(bench_allocs - allocs) / (double)iters);
+}
+
+static void bench_functions_suite(void)
+{
+    static const char* const inputs[] = { "random", "adversarial", "corpus" };
+    static const size_t sizes[] = { 16, 256, 4096, 65536, 1 << 20 };
+
+    if (bench_format == BENCH_TEXT) {
+        printf("== functions ==\n");
+        printf("%-30s %-12s %8s %14s %12s %10s\n", "function", "input", "size", "ns/op", "MiB/s", "allocs/op");
+    } else if (bench_format == BENCH_CSV) {
+        printf("function,input,size,ns_per_op,bytes_per_sec,allocs_per_op\n");
+    }
+
+    for (size_t ii = 0; ii < sizeof(bench_functions) / sizeof(bench_functions[0]); ii++) {
+        if (!Bench_Selected(bench_functions[ii].function)) {
+            continue;
+        }
+
+        for (size_t jj = 0; jj < sizeof(inputs) / sizeof(inputs[0]); jj++) {
+            for (size_t kk = 0; kk < sizeof(sizes) / sizeof(sizes[0]); kk++) {
+                BenchInput in = Bench_MakeInput(inputs[jj], sizes[kk]);
+                Bench_Run(bench_functions[ii].function, &in, bench_functions[ii].fn);
+                Bench_DeleteInput(&in);
+            }
+        }
+    }
+
+    if (bench_format == BENCH_TEXT) {
+        printf("\n");
+    }
+}
+
+/* ---- Comparing results ---- */
+
+typedef struct {
+    char key[192]; // function,input,size
+    double ns_per_op;
+} BenchRow;
+
+// Reads the rows of a CSV written by --csv, returns the number of rows read
+static size_t Bench_ReadCsv(const char* path, BenchRow** rows)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        exit(2);
+    }
+
+    size_t count = 0;
+    size_t cap = 0;
+    char line[512];
+    *rows = NULL;
+    while (fgets(line, sizeof(line), file)) {
+        char function[128];
+        char input[32];
+        size_t size;
+        double ns_per_op;
+        if (sscanf(line, "%127[^,],%31[^,],%zu,%lf", function, input, &size, &ns_per_op) != 4) {
+            continue; // header
+        }
+
+        if (count == cap) {
+            cap = cap ? 2 * cap : 256;
+            *rows = realloc(*rows, cap * sizeof(BenchRow));
+        }
+        snprintf((*rows)[count].key, sizeof((*rows)[count].key), "%s,%s,%zu", function, input, size);
+        (*rows)[count].ns_per_op = ns_per_op;
+        count += 1;
+    }
+
+    fclose(file);
+    return count;
+}
+
+// Prints the change in ns/op of every row of `new_path` that is also in `old_path`, returns 1 if any row slowed down
+// by more than `threshold` percent
+static int Bench_Compare(const char* old_path, const char* new_path, double threshold)
+{
+    BenchRow* old_rows;
+    BenchRow* new_rows;
+    size_t old_count = Bench_ReadCsv(old_path, &old_rows);
+    size_t new_count = Bench_ReadCsv(new_path, &new_rows);
+    size_t regressions = 0;
+
+    printf("%-60s %12s %12s %8s\n", "function,input,size", "old ns/op", "new ns/op", "change");
+    for (size_t ii = 0; ii < new_count; ii++) {
+        for (size_t jj = 0; jj < old_count; jj++) {
+            if (!strcmp(new_rows[ii].key, old_rows[jj].key)) {
+                double change = (new_rows[ii].ns_per_op / old_rows[jj].ns_per_op - 1) * 100;
+                bool regressed = change > threshold;
+                regressions += regressed;
+                printf(
+                    "%-60s %12.1f %12.1f %+7.1f%%%s\n",
+                    new_rows[ii].key,
+                    old_rows[jj].ns_per_op,
+                    new_rows[ii].ns_per_op,
+                    change,
+                    regressed ? "  REGRESSION" : "");
+                break;
+            }
+        }
+    }
+
+    printf("\n%zu regressions over %.0f%%\n", regressions, threshold);
+    free(old_rows);
+    free(new_rows);
+    return regressions ? 1 : 0;
+}
+
+static void Bench_Usage(const char* prog)
+{
+    fprintf(
+        stderr,
+        "usage: %s [--csv | --json] [--time MS] [--corpus FILE] [FILTER...]\n"
+        "       %s --compare OLD.csv NEW.csv [THRESHOLD_PERCENT]\n"
+        "Runs the benchmarks whose name contains any FILTER (all of them if there are none). --csv and --json only\n"
+        "run the function suite, with one row per function, input and size.\n",
+        prog,
+        prog);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct {
+        const char* name;
+        void (*fn)(void);
+    } sections[] = {
+        { "search", bench_search },       { "builder", bench_builder },
+        { "sso", bench_sso },             { "trim", bench_trim },
+        { "matcher", bench_matcher },     { "hash", bench_hash },
+        { "interning", bench_interning }, { "allocators", bench_allocators },
+        { "footprint", bench_footprint }, { "mapping", bench_mapping },
+        { "reader", bench_reader },       { "writev", bench_writev },
+        { "join", bench_join },           { "parallel", bench_parallel },
+        { "sort", bench_sort },           { "compare", bench_compare },
+        { "shared", bench_shared },       { "rope", bench_rope },
+        { "utf8", bench_utf8 },
+    };
+
+    if (argc >= 4 && !strcmp(argv[1], "--compare")) {
+        return Bench_Compare(argv[2], argv[3], argc >= 5 ? atof(argv[4]) : 10);
+    }
+
+    bench_filters = malloc(sizeof(char*) * (size_t)argc);
+    for (int ii = 1; ii < argc; ii++) {
+        if (!strcmp(argv[ii], "--csv")) {
+            bench_format = BENCH_CSV;
+        } else if (!strcmp(argv[ii], "--json")) {
+            bench_format = BENCH_JSON;
+        } else if (!strcmp(argv[ii], "--time") && ii + 1 < argc) {
+            bench_min_time = atof(argv[++ii]) * 1e6;
+        } else if (!strcmp(argv[ii], "--corpus") && ii + 1 < argc) {
+            FILE* file = fopen(argv[++ii], "rb");
+            if (!file) {
+                perror(argv[ii]);
+                return 2;
+            }
+            StringBuilder sb = StringBuilder_New(0);
+            char chunk[4096];
+            size_t read;
+            while ((read = fread(chunk, 1, sizeof(chunk), file))) {
+                StringBuilder_AppendCharArray(&sb, chunk, read);
+            }
+            fclose(file);
+            bench_corpus_file = StringBuilder_Finalize(&sb);
+        } else if (argv[ii][0] == '-') {
+            Bench_Usage(argv[0]);
+            return 2;
+        } else {
+            bench_filters[bench_filter_count++] = argv[ii];
+        }
+    }
+
+    bench_functions_suite();
+    if (bench_format == BENCH_TEXT) {
+        for (size_t ii = 0; ii < sizeof(sections) / sizeof(sections[0]); ii++) {
+            if (Bench_Selected(sections[ii].name)) {
+                sections[ii].fn();
+            }
+        }
+    }
+
+#ifdef STRLIB_STATS
+    StringStats stats = String_StatsSnapshot();
+    StringStats_Dump(&stats, stderr);
+#endif
+
+    free(bench_filters);
+    String_Delete(&bench_corpus_file);
+    return (int)(bench_sink & 0);
+}
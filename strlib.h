@@ -1,27 +1,112 @@
 #pragma once
 
 #include <assert.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined(__STDC_NO_THREADS__)
+#include <threads.h>
+#endif
+
+#if !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#endif
+
+// POSIX APIs (mmap, read) are used where available
+#if defined(__unix__) || defined(__APPLE__)
+#define STRLIB_POSIX 1
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#define STRLIB_POSIX 0
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define STRLIB_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define STRLIB_X86_SIMD 0
+#endif
+
+// Keeps slow paths out of line so the fast path around them can be inlined, forces small kernels inline at every
+// call site, and hints upcoming memory accesses
+#if defined(__GNUC__)
+#define STRLIB_NOINLINE __attribute__((noinline, unused))
+#define STRLIB_ALWAYS_INLINE __attribute__((always_inline))
+#define STRLIB_PREFETCH(addr) __builtin_prefetch((addr))
+#else
+#define STRLIB_NOINLINE
+#define STRLIB_ALWAYS_INLINE
+#define STRLIB_PREFETCH(addr) ((void)(addr))
+#endif
+
 /*
     Simple header only string library for C
     NOTE: all functions returning a String allocate memory and requires a corresponding call to String_Delete
 */
 
-// TODO: StringBuilder
-// TODO: SSO
+// Allocator used for all heap memory, may be overridden before including strlib.h
+#ifndef STRLIB_CALLOC
+#define STRLIB_CALLOC(count, size) calloc((count), (size))
+#endif
+
+#ifndef STRLIB_MALLOC
+#define STRLIB_MALLOC(size) malloc((size))
+#endif
+
+#ifndef STRLIB_REALLOC
+#define STRLIB_REALLOC(ptr, size) realloc((ptr), (size))
+#endif
+
+#ifndef STRLIB_FREE
+#define STRLIB_FREE(ptr) free((ptr))
+#endif
+
+// Type used to store the length of a String, may be overridden before including strlib.h
+// NOTE: a type narrower than a pointer (e.g. uint32_t) shrinks the String struct, on 64-bit targets from 24 to 16 bytes
+#ifndef STRLIB_LEN_TYPE
+#define STRLIB_LEN_TYPE size_t
+#endif
+
+// Largest length a String can have
+#define STRING_MAX_LEN ((size_t)(STRLIB_LEN_TYPE)-1 < SIZE_MAX ? (size_t)(STRLIB_LEN_TYPE)-1 : SIZE_MAX - 1)
+
+// Layout of a heap String, the chars of an inline String occupy everything after `kind`
+typedef struct {
+    STRLIB_LEN_TYPE len;
+    unsigned char kind;
+    char* buf;
+} StringHeader_;
+
+// Strings short enough to fit in the String struct are stored inline instead of on the heap (SSO), define
+// STRLIB_NO_SSO to disable
+#define STRING_SSO_SIZE (sizeof(StringHeader_) - sizeof(STRLIB_LEN_TYPE) - 1)
+#ifndef STRLIB_NO_SSO
+#define STRING_SSO_CAPACITY (STRING_SSO_SIZE - 1)
+#else
+#define STRING_SSO_CAPACITY 0
+#endif
 
 // Doesn't need to be free'd
 // NOTE: Calling String_CStr on it is invalid
 #define str(x) (&((const String) { .len = sizeof((x)) - 1, .buf = (x) }))
 
+// StringView 'literal' from a C-string literal, doesn't need to be free'd
+#define strview(x) ((StringView) { .len = sizeof((x)) - 1, .buf = (x) })
+
 // NOTE: can't print past null chars this way, string will be cut off at first null
 #define STRING_FMT "%.*s"
-#define STRING_ARG(str) ((int)(str)->len), ((str)->buf)
+#define STRING_ARG(str) ((int)(str)->len), (String_Buf((str)))
 
 #define STRING_OVERLOAD(arg0, arg1, arg2, ...) arg2
 
@@ -43,9 +128,34 @@
 // String(size_t len)          -> Uninitialized String of length = len
 #define String(...) STRING_OVERLOAD(__VA_ARGS__, String_FromCharArray, String_1)(__VA_ARGS__)
 
+// Storage kinds of a String
+enum {
+    STRING_KIND_BUF = 0, // chars are stored at `buf`
+    STRING_KIND_INLINE,  // chars are stored in `sso`, `buf` is invalid
+    STRING_KIND_MAPPED,  // chars are stored at `buf`, a read-only file mapping released by String_UnmapFile
+    STRING_KIND_SHARED,  // chars are stored at `buf`, inside a reference counted block shared by copies and slices
+};
+
+// Shared Strings keep the offset of `buf` into their block in the padding between `kind` and `buf`
+#define STRING_SHARED_OFFSET_SIZE (offsetof(StringHeader_, buf) - sizeof(STRLIB_LEN_TYPE) - 1)
+
+// NOTE: `buf` is only valid for Strings that aren't stored inline, use String_Buf to access the chars of any String
 typedef struct {
-    size_t len;
-    char* buf;
+    union {
+        struct {
+            STRLIB_LEN_TYPE len;
+            unsigned char kind;
+            char* buf;
+        };
+        struct {
+            char sso_prefix_[sizeof(STRLIB_LEN_TYPE) + 1];
+            char sso[STRING_SSO_SIZE];
+        };
+        struct {
+            char shared_prefix_[sizeof(STRLIB_LEN_TYPE) + 1];
+            unsigned char shared_offset[STRING_SHARED_OFFSET_SIZE];
+        };
+    };
 } String;
 
 typedef struct {
@@ -53,33 +163,395 @@ typedef struct {
     String* str;
 } StringList;
 
-// Frees a String
+// Borrowed window into the chars of a String (or any char array), never allocates and doesn't need to be free'd
+// NOTE: Only valid as long as the chars it points to are, for inline Strings that is the lifetime of the String struct
+typedef struct {
+    size_t len;
+    const char* buf;
+} StringView;
+
+// Instrumentation, define STRLIB_STATS to record per thread how often each function below is called, how many bytes
+// it allocates and scans, and how long it takes, see String_StatsSnapshot
+// NOTE: calls strlib makes internally (e.g. String_Replace calling String_New) are attributed to the outer function,
+// allocations made outside of these functions (e.g. by a growing StringBuilder) are attributed to "other"
+/* clang-format off */
+#define STRLIB_STATS_FUNCTIONS(X) \
+    X(String_NewHeap) X(String_New) X(String_FromCString) X(String_FromCharArray) X(String_FromView) X(String_Copy) \
+    X(String_Share) X(String_SliceShared) X(String_Join) X(String_FirstOccurrenceOf) X(String_LastOccurrenceOf) \
+    X(String_StartsWith) X(String_EndsWith) X(String_Compare) X(String_Equal) X(String_Trim) X(String_TrimLeft) \
+    X(String_TrimRight) X(String_TrimSet) X(String_DistinctInstancesOf) X(String_InstancesOf) X(String_FindAll) \
+    X(String_Replace) X(String_ReplaceMany) X(String_Split) X(String_JoinArray) X(String_JoinMany) X(String_Slice) \
+    X(String_Write) X(String_Hash) X(String_Pack) X(String_ValidateUtf8) X(String_FromUtf16) X(String_FromUtf32) \
+    X(StringBuilder_Reserve) X(other)
+/* clang-format on */
+
+#ifdef STRLIB_STATS
+#if !defined(__GNUC__)
+#error "STRLIB_STATS requires the cleanup attribute (GCC or Clang)"
+#endif
+
+#include <time.h>
+
+#define STRLIB_STATS_ENUM(fn) STRLIB_STATS_##fn,
+enum { STRLIB_STATS_FUNCTIONS(STRLIB_STATS_ENUM) STRLIB_STATS_COUNT };
+#undef STRLIB_STATS_ENUM
+
+typedef struct {
+    uint64_t calls;
+    uint64_t allocs;
+    uint64_t bytes_allocated;
+    uint64_t bytes_scanned; // length of the input, an upper bound for searches that stop at the first match
+    uint64_t ns;
+} StringStatsEntry;
+
+// Counters of each instrumented function, indexed by STRLIB_STATS_<function>
+typedef struct {
+    StringStatsEntry fn[STRLIB_STATS_COUNT];
+} StringStats;
+
+__attribute__((weak)) _Thread_local StringStats strlib_stats;
+__attribute__((weak)) _Thread_local unsigned strlib_stats_depth;
+__attribute__((weak)) _Thread_local unsigned strlib_stats_current = STRLIB_STATS_other;
+
+typedef struct {
+    unsigned fn;
+    uint64_t start;
+} StrLib_StatsScope;
+
+static inline uint64_t StrLib_StatsNow(void)
+{
+    struct timespec ts;
+#if defined(CLOCK_MONOTONIC)
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static inline StrLib_StatsScope StrLib_StatsEnter(unsigned fn, size_t scanned)
+{
+    if (strlib_stats_depth++) {
+        return (StrLib_StatsScope) { .fn = STRLIB_STATS_COUNT };
+    }
+
+    strlib_stats_current = fn;
+    strlib_stats.fn[fn].calls += 1;
+    strlib_stats.fn[fn].bytes_scanned += scanned;
+    return (StrLib_StatsScope) { .fn = fn, .start = StrLib_StatsNow() };
+}
+
+static inline void StrLib_StatsLeave(StrLib_StatsScope* scope)
+{
+    strlib_stats_depth -= 1;
+    if (scope->fn != STRLIB_STATS_COUNT) {
+        strlib_stats.fn[scope->fn].ns += StrLib_StatsNow() - scope->start;
+        strlib_stats_current = STRLIB_STATS_other;
+    }
+}
+
+// Records a call to `fn` scanning `scanned` bytes, lasting until the end of the enclosing block
+#define STRLIB_STATS_SCOPE(fn, scanned)                                            \
+    __attribute__((cleanup(StrLib_StatsLeave))) StrLib_StatsScope strlib_scope_ = \
+        StrLib_StatsEnter(STRLIB_STATS_##fn, (scanned))
+
+#define STRLIB_STATS_ALLOC(size)                                  \
+    do {                                                          \
+        strlib_stats.fn[strlib_stats_current].allocs += 1;        \
+        strlib_stats.fn[strlib_stats_current].bytes_allocated += (size); \
+    } while (0)
+
+// Returns a copy of the counters of this thread
+static inline StringStats String_StatsSnapshot(void)
+{
+    return strlib_stats;
+}
+
+// Zeroes the counters of this thread
+static inline void String_StatsReset(void)
+{
+    memset(&strlib_stats, 0, sizeof(strlib_stats));
+}
+
+// Adds the counters of `from` to `into`, e.g. to combine snapshots taken on several threads
+static inline void StringStats_Merge(StringStats* into, const StringStats* from)
+{
+    for (size_t ii = 0; ii < STRLIB_STATS_COUNT; ii++) {
+        into->fn[ii].calls += from->fn[ii].calls;
+        into->fn[ii].allocs += from->fn[ii].allocs;
+        into->fn[ii].bytes_allocated += from->fn[ii].bytes_allocated;
+        into->fn[ii].bytes_scanned += from->fn[ii].bytes_scanned;
+        into->fn[ii].ns += from->fn[ii].ns;
+    }
+}
+
+// Returns the name of the function counted at `index` of StringStats
+static inline const char* StringStats_Name(size_t index)
+{
+#define STRLIB_STATS_NAME(fn) #fn,
+    static const char* const names[] = { STRLIB_STATS_FUNCTIONS(STRLIB_STATS_NAME) };
+#undef STRLIB_STATS_NAME
+    return index < STRLIB_STATS_COUNT ? names[index] : NULL;
+}
+
+// Writes the functions that were called or allocated to `fd`, most allocated bytes first
+static inline void StringStats_Dump(const StringStats* stats, FILE* fd)
+{
+    size_t order[STRLIB_STATS_COUNT];
+    size_t count = 0;
+    for (size_t ii = 0; ii < STRLIB_STATS_COUNT; ii++) {
+        if (!stats->fn[ii].calls && !stats->fn[ii].allocs) {
+            continue;
+        }
+
+        size_t pos = count++;
+        for (; pos > 0 && stats->fn[order[pos - 1]].bytes_allocated < stats->fn[ii].bytes_allocated; pos--) {
+            order[pos] = order[pos - 1];
+        }
+        order[pos] = ii;
+    }
+
+    fprintf(fd, "%-28s %12s %12s %16s %16s %14s\n", "function", "calls", "allocs", "bytes allocated", "bytes scanned", "time (us)");
+    for (size_t ii = 0; ii < count; ii++) {
+        const StringStatsEntry* entry = &stats->fn[order[ii]];
+        fprintf(
+            fd,
+            "%-28s %12llu %12llu %16llu %16llu %14.1f\n",
+            StringStats_Name(order[ii]),
+            (unsigned long long)entry->calls,
+            (unsigned long long)entry->allocs,
+            (unsigned long long)entry->bytes_allocated,
+            (unsigned long long)entry->bytes_scanned,
+            (double)entry->ns / 1000);
+    }
+}
+#else
+#define STRLIB_STATS_SCOPE(fn, scanned) ((void)0)
+#define STRLIB_STATS_ALLOC(size) ((void)0)
+#endif
+
+// Interface for allocators that strlib functions can allocate from, see String_SetAllocator
+// `alloc` returns uninitialized memory, `realloc` is passed the current size of `ptr`
+// NOTE: `free` may be passed memory from the default allocator (STRLIB_MALLOC and friends), which it should forward
+// to STRLIB_FREE, so heap Strings created before switching allocators can still be deleted
+typedef struct StringAllocator StringAllocator;
+struct StringAllocator {
+    void* (*alloc)(StringAllocator* self, size_t size);
+    void* (*realloc)(StringAllocator* self, void* ptr, size_t old_size, size_t new_size);
+    void (*free)(StringAllocator* self, void* ptr);
+};
+
+// The allocator in use is tracked per thread, and shared between translation units where the compiler supports it
+#if defined(__GNUC__)
+__attribute__((weak)) _Thread_local StringAllocator* strlib_allocator;
+#else
+static _Thread_local StringAllocator* strlib_allocator;
+#endif
+
+// Makes all strlib functions called from this thread allocate from `allocator`, NULL restores the default allocator
+// returns the previous allocator
+// NOTE: Strings must be deleted while the allocator they were allocated from (or the default allocator) is in use
+static inline StringAllocator* String_SetAllocator(StringAllocator* allocator)
+{
+    StringAllocator* prev = strlib_allocator;
+    strlib_allocator = allocator;
+    return prev;
+}
+
+// Returns the allocator in use by this thread, NULL if it is the default allocator
+static inline StringAllocator* String_GetAllocator(void)
+{
+    return strlib_allocator;
+}
+
+static inline void* StrLib_Alloc(size_t size)
+{
+    STRLIB_STATS_ALLOC(size);
+    void* ptr = strlib_allocator ? strlib_allocator->alloc(strlib_allocator, size) : STRLIB_MALLOC(size);
+    assert(ptr);
+    return ptr;
+}
+
+static inline void* StrLib_Calloc(size_t count, size_t size)
+{
+    if (!strlib_allocator) {
+        STRLIB_STATS_ALLOC(count * size);
+        void* ptr = STRLIB_CALLOC(count, size);
+        assert(ptr);
+        return ptr;
+    }
+
+    return memset(StrLib_Alloc(count * size), 0, count * size);
+}
+
+static inline void* StrLib_Realloc(void* ptr, size_t old_size, size_t new_size)
+{
+    STRLIB_STATS_ALLOC(new_size);
+    void* ret = strlib_allocator ? strlib_allocator->realloc(strlib_allocator, ptr, old_size, new_size)
+                                 : STRLIB_REALLOC(ptr, new_size);
+    assert(ret);
+    return ret;
+}
+
+// Frees `ptr` through `allocator` (NULL for the default allocator), whichever allocator this thread is using
+static inline void StrLib_FreeFrom(StringAllocator* allocator, void* ptr)
+{
+    if (allocator) {
+        allocator->free(allocator, ptr);
+    } else {
+        STRLIB_FREE(ptr);
+    }
+}
+
+static inline void StrLib_Free(void* ptr)
+{
+    StrLib_FreeFrom(strlib_allocator, ptr);
+}
+
+// Returns a pointer to the chars of `str`
+// NOTE: for inline Strings this points into `str` itself, so it is invalidated when `str` goes out of scope
+static inline char* String_Buf(const String* str)
+{
+    return str->kind == STRING_KIND_INLINE ? (char*)str->sso : str->buf;
+}
+
+// Determines if the chars of `str` are stored inline (no heap allocation)
+static inline bool String_IsInline(const String* str)
+{
+    return str->kind == STRING_KIND_INLINE;
+}
+
+// Reference count of blocks shared between Strings (or rope nodes), atomic so they can be shared between threads
+#if !defined(__STDC_NO_ATOMICS__)
+typedef atomic_size_t StrLib_Refs;
+#else
+typedef size_t StrLib_Refs; // NOTE: without C11 atomics shared blocks can't be retained or released concurrently
+#endif
+
+static inline void StrLib_RefsInit(StrLib_Refs* refs)
+{
+#if !defined(__STDC_NO_ATOMICS__)
+    atomic_init(refs, 1);
+#else
+    *refs = 1;
+#endif
+}
+
+static inline void StrLib_RefsAcquire(StrLib_Refs* refs)
+{
+#if !defined(__STDC_NO_ATOMICS__)
+    atomic_fetch_add_explicit(refs, 1, memory_order_relaxed);
+#else
+    *refs += 1;
+#endif
+}
+
+// Drops a reference, returns true if it was the last one and the block should be freed
+static inline bool StrLib_RefsRelease(StrLib_Refs* refs)
+{
+#if !defined(__STDC_NO_ATOMICS__)
+    // release orders this thread's reads of the block before the free, acquire makes the last thread see all of them
+    return atomic_fetch_sub_explicit(refs, 1, memory_order_acq_rel) == 1;
+#else
+    return --*refs == 0;
+#endif
+}
+
+static inline size_t StrLib_RefsLoad(StrLib_Refs* refs)
+{
+#if !defined(__STDC_NO_ATOMICS__)
+    return atomic_load_explicit(refs, memory_order_relaxed);
+#else
+    return *refs;
+#endif
+}
+
+// Header of the block holding the chars of shared Strings, followed by the chars and a null terminator
+// The block is freed through the allocator it was allocated from, since its last reference may be dropped on any thread
+typedef struct {
+    StrLib_Refs refs;
+    StringAllocator* allocator;
+} StrLib_SharedBlock;
+
+// Largest offset into its block a shared slice can start at, slices starting further in are copied instead
+#define STRING_SHARED_MAX_OFFSET \
+    (STRING_SHARED_OFFSET_SIZE >= sizeof(size_t) ? SIZE_MAX : ((size_t)1 << (8 * STRING_SHARED_OFFSET_SIZE)) - 1)
+
+static inline size_t StrLib_SharedOffset(const String* str)
+{
+    size_t offset = 0;
+    for (size_t ii = STRING_SHARED_OFFSET_SIZE; ii-- > 0;) {
+        offset = offset << 8 | str->shared_offset[ii];
+    }
+    return offset;
+}
+
+// NOTE: must be called after `buf` is assigned, storing to a member may clobber the padding the offset lives in
+static inline void StrLib_SetSharedOffset(String* str, size_t offset)
+{
+    for (size_t ii = 0; ii < STRING_SHARED_OFFSET_SIZE; ii++) {
+        str->shared_offset[ii] = (unsigned char)offset;
+        offset >>= 8;
+    }
+}
+
+static inline StrLib_SharedBlock* StrLib_SharedBlockOf(const String* str)
+{
+    return (StrLib_SharedBlock*)(str->buf - StrLib_SharedOffset(str)) - 1;
+}
+
+// Frees a String, shared Strings only free their block once every copy and slice of it has been deleted
 static inline void String_Delete(String* str)
 {
-    free(str->buf);
+    if (str->kind == STRING_KIND_BUF) {
+        StrLib_Free(str->buf);
+    } else if (str->kind == STRING_KIND_SHARED) {
+        StrLib_SharedBlock* block = StrLib_SharedBlockOf(str);
+        if (StrLib_RefsRelease(&block->refs)) {
+            StrLib_FreeFrom(block->allocator, block);
+        }
+    }
 }
 
 // Frees a StringList
 static inline void StringList_Delete(StringList* str_list)
 {
-    free(str_list->str);
+    StrLib_Free(str_list->str);
+}
+
+// Allocates a String of some length `len` on the heap, regardless of its length
+// NOTE: Unlike inline Strings, the buffer address stays the same when the String is copied
+static inline String String_NewHeap(size_t len)
+{
+    STRLIB_STATS_SCOPE(String_NewHeap, 0);
+    assert(len <= STRING_MAX_LEN);
+    char* buf = StrLib_Calloc(1, len + 1);
+
+    return (String) { .len = len, .buf = buf };
 }
 
 // Allocates a String of some length `len`
+// NOTE: Strings of up to STRING_SSO_CAPACITY chars are stored inline and don't allocate
 static inline String String_New(size_t len)
 {
-    char* buf = calloc(1, len + 1);
-    assert(buf);
+    STRLIB_STATS_SCOPE(String_New, 0);
+    assert(len <= STRING_MAX_LEN);
+    if (len <= STRING_SSO_CAPACITY) {
+        String ret = { .len = len };
+        ret.kind = STRING_KIND_INLINE;
+        return ret;
+    }
 
-    return (String) { .len = len, .buf = buf };
+    return String_NewHeap(len);
 }
 
 // Creates a String from a C-string (null terminated char array)
 static inline String String_FromCString(const char* str)
 {
+    STRLIB_STATS_SCOPE(String_FromCString, 0);
     size_t len = strlen(str);
     String ret = String_New(len);
-    memcpy(ret.buf, str, len);
+    memcpy(String_Buf(&ret), str, len);
 
     return ret;
 }
@@ -87,8 +559,9 @@ static inline String String_FromCString(const char* str)
 // Creates a String from an array of characters of some length
 static inline String String_FromCharArray(const char* arr, size_t len)
 {
+    STRLIB_STATS_SCOPE(String_FromCharArray, len);
     String ret = String_New(len);
-    memcpy(ret.buf, arr, len);
+    memcpy(String_Buf(&ret), arr, len);
 
     return ret;
 }
@@ -96,8 +569,9 @@ static inline String String_FromCharArray(const char* arr, size_t len)
 // Makes a copy of `str`
 static inline String String_Copy(const String* str)
 {
+    STRLIB_STATS_SCOPE(String_Copy, str->len);
     String ret = String_New(str->len);
-    memcpy(ret.buf, str->buf, str->len);
+    memcpy(String_Buf(&ret), String_Buf(str), str->len);
 
     return ret;
 }
@@ -105,274 +579,5428 @@ static inline String String_Copy(const String* str)
 // Concatenates `left` and `right` in order
 static inline String String_Join(const String* left, const String* right)
 {
+    STRLIB_STATS_SCOPE(String_Join, left->len + right->len);
     String cat = String_New(left->len + right->len);
-    memcpy(cat.buf, left->buf, left->len);
-    memcpy(cat.buf + left->len, right->buf, right->len);
+    memcpy(String_Buf(&cat), String_Buf(left), left->len);
+    memcpy(String_Buf(&cat) + left->len, String_Buf(right), right->len);
 
     return cat;
 }
 
-// Finds the index of the first occurrence of `substr` in `str`
-// returns a negative value if no occurrence exists
-static inline ssize_t String_FirstOccurrenceOf(const String* str, const String* substr)
-{
-    if (substr->len > str->len) {
-        return -1;
-    }
-
-    for (size_t ii = 0; ii < str->len - substr->len + 1; ii++) {
-        bool found = !memcmp(&str->buf[ii], substr->buf, substr->len);
-        if (found) {
-            return (ssize_t)ii;
-        }
-    }
-
-    return -1;
-}
+/* ---- Shared Strings ---- */
 
-// Finds the index of the last occurrence of `substr` in `str`
-// returns a negative value if no occurrence exists
-static inline ssize_t String_LastOccurrenceOf(const String* str, const String* substr)
+// Returns a shared copy of `str`, whose buffer String_Retain and String_SliceShared reuse instead of copying
+// If `str` is already shared this only adds a reference, otherwise its chars are copied once into a reference counted
+// block, which is freed when the last String sharing it is deleted
+// NOTE: Strings of up to STRING_SSO_CAPACITY chars are copied inline instead, which is cheaper than sharing
+// NOTE: shared Strings must not be modified, since every copy and slice of them would see the change
+// NOTE: the block is freed through the allocator in use when it was shared, even if another thread (or this one, after
+// switching allocators) deletes the last String sharing it, so only share Strings that are passed to other threads
+// under a thread-safe allocator like the default one
+static inline String String_Share(const String* str)
 {
-    if (substr->len > str->len) {
-        return -1;
+    STRLIB_STATS_SCOPE(String_Share, str->len);
+    if (str->kind == STRING_KIND_SHARED) {
+        StrLib_RefsAcquire(&StrLib_SharedBlockOf(str)->refs);
+        return *str;
+    } else if (str->len <= STRING_SSO_CAPACITY) {
+        return String_FromCharArray(String_Buf(str), str->len);
     }
 
-    for (ssize_t ii = str->len - substr->len; ii >= 0; ii--) {
-        bool found = !memcmp(&str->buf[ii], substr->buf, substr->len);
-        if (found) {
-            return (ssize_t)ii;
-        }
-    }
+    StrLib_SharedBlock* block = StrLib_Alloc(sizeof(StrLib_SharedBlock) + str->len + 1);
+    StrLib_RefsInit(&block->refs);
+    block->allocator = strlib_allocator;
+    char* buf = (char*)(block + 1);
+    memcpy(buf, String_Buf(str), str->len);
+    buf[str->len] = '\0';
 
-    return -1;
+    String ret = { .len = str->len, .buf = buf };
+    ret.kind = STRING_KIND_SHARED;
+    StrLib_SetSharedOffset(&ret, 0);
+    return ret;
 }
 
-// Determines if `str` begins with the String `prefix`
-static inline bool String_StartsWith(const String* str, const String* prefix)
+// Returns a copy of `str` in O(1) by adding a reference to its buffer if `str` is shared, otherwise the same as
+// String_Copy
+static inline String String_Retain(const String* str)
 {
-    if (str->len < prefix->len) {
-        return false;
+    if (str->kind == STRING_KIND_SHARED) {
+        StrLib_RefsAcquire(&StrLib_SharedBlockOf(str)->refs);
+        return *str;
     }
 
-    return !memcmp(str->buf, prefix->buf, prefix->len);
+    return String_Copy(str);
 }
 
-// Determines if `str` begins with the String `suffix`
-static inline bool String_EndsWith(const String* str, const String* suffix)
+// Returns the index range [`start`, `end`) of `str`, which shares the buffer of `str` if it is shared, otherwise the
+// same as String_Slice
+// NOTE: slices of up to STRING_SSO_CAPACITY chars (and those starting past STRING_SHARED_MAX_OFFSET) are copied
+static inline String String_SliceShared(const String* str, size_t start, size_t end)
 {
-    if (str->len < suffix->len) {
-        return false;
+    STRLIB_STATS_SCOPE(String_SliceShared, 0);
+    assert(start <= end && end <= str->len);
+    size_t offset = str->kind == STRING_KIND_SHARED ? StrLib_SharedOffset(str) : 0;
+    if (str->kind != STRING_KIND_SHARED || end - start <= STRING_SSO_CAPACITY
+        || start > STRING_SHARED_MAX_OFFSET - offset) {
+        return String_FromCharArray(&String_Buf(str)[start], end - start);
     }
 
-    return !memcmp(&str->buf[str->len - suffix->len], suffix->buf, suffix->len);
+    StrLib_RefsAcquire(&StrLib_SharedBlockOf(str)->refs);
+    String ret = { .len = end - start, .buf = str->buf + start };
+    ret.kind = STRING_KIND_SHARED;
+    StrLib_SetSharedOffset(&ret, offset + start);
+    return ret;
 }
 
-// Determines if `str` contains `substr`
-static inline bool String_Contains(const String* str, const String* substr)
+// Determines if the chars of `str` are in a reference counted block shared with its copies and slices
+static inline bool String_IsShared(const String* str)
 {
-    return String_FirstOccurrenceOf(str, substr) >= 0;
+    return str->kind == STRING_KIND_SHARED;
 }
 
-// returns the lexicographic order of str_a and str_b
-// if negative, str_a would come before str_b
-// if positive, str_b would come before str_a
-// if zero the strings are identical
-static inline ssize_t String_Compare(const String* str_a, const String* str_b)
+// Returns the number of Strings sharing the buffer of `str`, 0 if it isn't shared
+// NOTE: other threads may change the count at any time, so it is only exact if `str` isn't shared between threads
+static inline size_t String_RefCount(const String* str)
 {
-    size_t min_len = str_a->len < str_b->len ? str_a->len : str_b->len;
-
-    int cmp = memcmp(str_a->buf, str_b->buf, min_len);
-    if (cmp == 0) {
-        return (ssize_t)str_a->len - (ssize_t)str_b->len;
-    } else {
-        return (ssize_t)cmp;
+    if (str->kind != STRING_KIND_SHARED) {
+        return 0;
     }
+
+    return StrLib_RefsLoad(&StrLib_SharedBlockOf(str)->refs);
 }
 
-// Determines if `str_a` is identical to `str_b`
-static inline ssize_t String_Equal(const String* str_a, const String* str_b)
+/* ---- Substring search engine ---- */
+
+// Candidates are filtered on the first and last byte of the needle (16 or 32 positions at a time with SSE2/AVX2)
+// and verified with memcmp. If verification costs more than STRLIB_SEARCH_BUDGET_FACTOR times the bytes scanned
+// (adversarial inputs like "aaaa...ab"), the search switches to Two-Way which is O(n + m) worst case.
+#ifndef STRLIB_SEARCH_BUDGET_FACTOR
+#define STRLIB_SEARCH_BUDGET_FACTOR 4
+#endif
+
+#define STRLIB_SEARCH_BUDGET_SLACK 4096
+
+// Computes the maximal suffix of `x` (or of its reversal if `rev`) under the normal (`tilde` == false) or reversed
+// alphabet order, returns the index preceding the suffix and stores its period in `period`
+static inline ssize_t StrLib_MaximalSuffix(const char* x, size_t m, bool rev, bool tilde, size_t* period)
 {
-    if (str_a->len != str_b->len) {
-        return false;
+#define STRLIB_X(i) ((unsigned char)x[rev ? m - 1 - (size_t)(i) : (size_t)(i)])
+    ssize_t ms = -1;
+    size_t jj = 0;
+    size_t kk = 1;
+    size_t pp = 1;
+
+    while (jj + kk < m) {
+        unsigned char a = STRLIB_X(jj + kk);
+        unsigned char b = STRLIB_X((size_t)(ms + (ssize_t)kk));
+        if (tilde ? a > b : a < b) {
+            jj += kk;
+            kk = 1;
+            pp = jj - (size_t)ms;
+        } else if (a == b) {
+            if (kk != pp) {
+                kk += 1;
+            } else {
+                jj += pp;
+                kk = 1;
+            }
+        } else {
+            ms = (ssize_t)jj;
+            jj = (size_t)ms + 1;
+            kk = pp = 1;
+        }
     }
+#undef STRLIB_X
 
-    return !memcmp(str_a->buf, str_b->buf, str_a->len);
+    *period = pp;
+    return ms;
 }
 
-// Determines if a char is whitespace
-static inline bool String_IsWhitespaceChar(char c)
+// Crochemore-Perrin Two-Way search, O(n + m) time and O(1) space
+// If `rev` is true, finds the last occurrence instead of the first
+static inline ssize_t StrLib_TwoWay(const char* hay, size_t n, const char* needle, size_t m, bool rev)
 {
-    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
-}
+#define STRLIB_Y(i) ((unsigned char)hay[rev ? n - 1 - (size_t)(i) : (size_t)(i)])
+#define STRLIB_X(i) ((unsigned char)needle[rev ? m - 1 - (size_t)(i) : (size_t)(i)])
+#define STRLIB_FOUND(j) return rev ? (ssize_t)(n - m - (j)) : (ssize_t)(j)
 
-// Removes whitespace from the beginning and end of `str`
-static inline String String_Trim(const String* str)
-{
-    size_t front = 0;
-    size_t back = 0;
+    if (m > n) {
+        return -1;
+    }
+
+    size_t per_a, per_b, per;
+    ssize_t suf_a = StrLib_MaximalSuffix(needle, m, rev, false, &per_a);
+    ssize_t suf_b = StrLib_MaximalSuffix(needle, m, rev, true, &per_b);
+    ssize_t ell = suf_a > suf_b ? suf_a : suf_b;
+    per = suf_a > suf_b ? per_a : per_b;
 
-    for (ssize_t ii = 0; ii < (ssize_t)str->len && String_IsWhitespaceChar(str->buf[ii]); ii++) {
-        front += 1;
+    bool periodic = true;
+    for (ssize_t ii = 0; ii <= ell; ii++) {
+        if (STRLIB_X(ii) != STRLIB_X(ii + per)) {
+            periodic = false;
+            break;
+        }
     }
 
-    for (ssize_t ii = (ssize_t)str->len - 1; ii >= (ssize_t)front && String_IsWhitespaceChar(str->buf[ii]); ii--) {
-        back += 1;
+    size_t jj = 0;
+    if (periodic) {
+        ssize_t memory = -1;
+        while (jj <= n - m) {
+            ssize_t ii = (ell > memory ? ell : memory) + 1;
+            while (ii < (ssize_t)m && STRLIB_X(ii) == STRLIB_Y(ii + jj)) {
+                ii += 1;
+            }
+
+            if (ii >= (ssize_t)m) {
+                ii = ell;
+                while (ii > memory && STRLIB_X(ii) == STRLIB_Y(ii + jj)) {
+                    ii -= 1;
+                }
+
+                if (ii <= memory) {
+                    STRLIB_FOUND(jj);
+                }
+
+                jj += per;
+                memory = (ssize_t)(m - per) - 1;
+            } else {
+                jj += (size_t)(ii - ell);
+                memory = -1;
+            }
+        }
+    } else {
+        size_t left = (size_t)(ell + 1);
+        size_t right = m - left;
+        per = (left > right ? left : right) + 1;
+        while (jj <= n - m) {
+            ssize_t ii = ell + 1;
+            while (ii < (ssize_t)m && STRLIB_X(ii) == STRLIB_Y(ii + jj)) {
+                ii += 1;
+            }
+
+            if (ii >= (ssize_t)m) {
+                ii = ell;
+                while (ii >= 0 && STRLIB_X(ii) == STRLIB_Y(ii + jj)) {
+                    ii -= 1;
+                }
+
+                if (ii < 0) {
+                    STRLIB_FOUND(jj);
+                }
+
+                jj += per;
+            } else {
+                jj += (size_t)(ii - ell);
+            }
+        }
     }
 
-    size_t trim_amt = front + back;
-    String ret = String_New(str->len - trim_amt);
-    memcpy(ret.buf, &str->buf[front], str->len - front - back);
+    return -1;
 
-    return ret;
+#undef STRLIB_FOUND
+#undef STRLIB_X
+#undef STRLIB_Y
 }
 
-// Returns the number of distinct (non-overlapping) instances of `substr` in `str`
-// e.g. String_DistinctInstancesOf("aaaa", "aaa") == 1
-static inline size_t String_DistinctInstancesOf(const String* str, const String* substr)
+// Continues a forward search in hay[start..n) with Two-Way once the candidate filter has exceeded its budget
+static inline ssize_t StrLib_FindFirstFallback(const char* hay, size_t n, const char* needle, size_t m, size_t start)
 {
-    if (str->len < substr->len) {
-        return 0;
-    }
+    ssize_t pos = StrLib_TwoWay(hay + start, n - start, needle, m, false);
+    return pos < 0 ? -1 : pos + (ssize_t)start;
+}
 
-    size_t instances = 0;
-    for (size_t ii = 0; ii < str->len - substr->len + 1;) {
-        bool found = !memcmp(&str->buf[ii], substr->buf, substr->len);
-        if (found) {
-            instances += 1;
-            ii += substr->len ? substr->len : 1;
-        } else {
-            ii += 1;
+// Continues a reverse search for matches starting before `end` with Two-Way once the candidate filter has exceeded
+// its budget
+static inline ssize_t StrLib_FindLastFallback(const char* hay, const char* needle, size_t m, size_t end)
+{
+    return StrLib_TwoWay(hay, end + m - 1, needle, m, true);
+}
+
+#define STRLIB_OVER_BUDGET(work, scanned) ((work) > STRLIB_SEARCH_BUDGET_FACTOR * (scanned) + STRLIB_SEARCH_BUDGET_SLACK)
+
+// Scalar candidate filter, used for the tail of the SIMD kernels and on targets without SIMD support
+// Searches match positions [start, end) where end = n - m + 1
+static inline ssize_t StrLib_FindFirstScalar(const char* hay, size_t n, const char* needle, size_t m, size_t start)
+{
+    size_t end = n - m + 1;
+    size_t work = 0;
+
+    for (size_t ii = start; ii < end; ii++) {
+        // memchr only pays off over longer stretches, short tails (of the SIMD kernels) are checked byte by byte
+        if (end - ii >= 32) {
+            const char* cand = memchr(&hay[ii], needle[0], end - ii);
+            if (!cand) {
+                return -1;
+            }
+            ii = (size_t)(cand - hay);
+        } else if (hay[ii] != needle[0]) {
+            continue;
+        }
+
+        if (hay[ii + m - 1] == needle[m - 1]) {
+            if (m <= 2 || !memcmp(&hay[ii + 1], needle + 1, m - 2)) {
+                return (ssize_t)ii;
+            }
+
+            work += m;
+            if (STRLIB_OVER_BUDGET(work, ii - start)) {
+                return StrLib_FindFirstFallback(hay, n, needle, m, ii + 1);
+            }
         }
     }
 
-    return instances;
+    return -1;
 }
 
-// Returns the number of instances of `substr` in `str`
-// e.g. String_InstancesOf("aaaa", "aaa") == 2
-static inline size_t String_InstancesOf(const String* str, const String* substr)
+// Reverse counterpart of StrLib_FindFirstScalar, searches match positions [0, end)
+static inline ssize_t StrLib_FindLastScalar(const char* hay, const char* needle, size_t m, size_t end)
 {
-    if (str->len < substr->len) {
-        return 0;
-    }
+    size_t work = 0;
 
-    size_t instances = 0;
-    for (size_t ii = 0; ii < str->len - substr->len + 1; ii++) {
-        bool found = !memcmp(&str->buf[ii], substr->buf, substr->len);
-        if (found) {
-            instances += 1;
+    for (size_t ii = end; ii-- > 0;) {
+        if (hay[ii] == needle[0] && hay[ii + m - 1] == needle[m - 1]) {
+            if (m <= 2 || !memcmp(&hay[ii + 1], needle + 1, m - 2)) {
+                return (ssize_t)ii;
+            }
+
+            work += m;
+            if (STRLIB_OVER_BUDGET(work, end - ii)) {
+                return StrLib_FindLastFallback(hay, needle, m, ii);
+            }
         }
     }
 
-    return instances;
+    return -1;
 }
 
-// Replaces all instances of `old` with `new` in `str`
-// NOTE: Calling String_Replace with old == "" produces the original string
-static inline String String_Replace(const String* str, const String* old, const String* new)
+#if STRLIB_X86_SIMD
+static inline ssize_t StrLib_FindFirstSSE2(const char* hay, size_t n, const char* needle, size_t m)
 {
-    if (str->len < old->len || old->len == 0) {
-        return String_Copy(str);
-    }
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[m - 1]);
+    size_t end = n - m + 1;
+    size_t work = 0;
+    size_t ii = 0;
 
-    size_t old_count = String_DistinctInstancesOf(str, old);
-    ssize_t ret_len = (ssize_t)str->len + (ssize_t)old_count * ((ssize_t) new->len - (ssize_t)old->len);
-    String ret = String_New(ret_len);
+    for (; ii + 16 <= end; ii += 16) {
+        __m128i blk_first = _mm_loadu_si128((const __m128i*)&hay[ii]);
+        __m128i blk_last = _mm_loadu_si128((const __m128i*)&hay[ii + m - 1]);
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(blk_first, first), _mm_cmpeq_epi8(blk_last, last)));
 
-    size_t ret_pos = 0;
-    size_t str_pos = 0;
-    for (str_pos = 0; str_pos < str->len - old->len + 1;) {
-        bool found = !memcmp(&str->buf[str_pos], old->buf, old->len);
-        if (found) {
-            memcpy(&ret.buf[ret_pos], new->buf, new->len);
-            ret_pos += new->len;
-            str_pos += old->len;
-        } else {
-            ret.buf[ret_pos] = str->buf[str_pos];
-            ret_pos += 1;
-            str_pos += 1;
+        while (mask) {
+            size_t pos = ii + (size_t)__builtin_ctz(mask);
+            if (m <= 2 || !memcmp(&hay[pos + 1], needle + 1, m - 2)) {
+                return (ssize_t)pos;
+            }
+
+            work += m;
+            mask &= mask - 1;
         }
-    }
 
-    if (str_pos != str->len) {
-        memcpy(&ret.buf[ret_pos], &str->buf[str_pos], str->len - str_pos);
+        if (STRLIB_OVER_BUDGET(work, ii)) {
+            return StrLib_FindFirstFallback(hay, n, needle, m, ii + 16);
+        }
     }
 
+    return StrLib_FindFirstScalar(hay, n, needle, m, ii);
+}
+
+static inline ssize_t StrLib_FindLastSSE2(const char* hay, size_t n, const char* needle, size_t m)
+{
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[m - 1]);
+    size_t end = n - m + 1;
+    size_t work = 0;
+
+    for (; end >= 16; end -= 16) {
+        size_t base = end - 16;
+        __m128i blk_first = _mm_loadu_si128((const __m128i*)&hay[base]);
+        __m128i blk_last = _mm_loadu_si128((const __m128i*)&hay[base + m - 1]);
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(blk_first, first), _mm_cmpeq_epi8(blk_last, last)));
+
+        while (mask) {
+            unsigned bit = 31 - (unsigned)__builtin_clz(mask);
+            size_t pos = base + bit;
+            if (m <= 2 || !memcmp(&hay[pos + 1], needle + 1, m - 2)) {
+                return (ssize_t)pos;
+            }
+
+            work += m;
+            mask &= ~(1u << bit);
+        }
+
+        if (STRLIB_OVER_BUDGET(work, n - m + 1 - base)) {
+            return StrLib_FindLastFallback(hay, needle, m, base);
+        }
+    }
+
+    return StrLib_FindLastScalar(hay, needle, m, end);
+}
+
+__attribute__((target("avx2"))) static inline ssize_t
+StrLib_FindFirstAVX2(const char* hay, size_t n, const char* needle, size_t m)
+{
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+    size_t end = n - m + 1;
+    size_t work = 0;
+    size_t ii = 0;
+
+    for (; ii + 32 <= end; ii += 32) {
+        __m256i blk_first = _mm256_loadu_si256((const __m256i*)&hay[ii]);
+        __m256i blk_last = _mm256_loadu_si256((const __m256i*)&hay[ii + m - 1]);
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(blk_first, first), _mm256_cmpeq_epi8(blk_last, last)));
+
+        while (mask) {
+            size_t pos = ii + (size_t)__builtin_ctz(mask);
+            if (m <= 2 || !memcmp(&hay[pos + 1], needle + 1, m - 2)) {
+                return (ssize_t)pos;
+            }
+
+            work += m;
+            mask &= mask - 1;
+        }
+
+        if (STRLIB_OVER_BUDGET(work, ii)) {
+            return StrLib_FindFirstFallback(hay, n, needle, m, ii + 32);
+        }
+    }
+
+    return StrLib_FindFirstScalar(hay, n, needle, m, ii);
+}
+
+__attribute__((target("avx2"))) static inline ssize_t
+StrLib_FindLastAVX2(const char* hay, size_t n, const char* needle, size_t m)
+{
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+    size_t end = n - m + 1;
+    size_t work = 0;
+
+    for (; end >= 32; end -= 32) {
+        size_t base = end - 32;
+        __m256i blk_first = _mm256_loadu_si256((const __m256i*)&hay[base]);
+        __m256i blk_last = _mm256_loadu_si256((const __m256i*)&hay[base + m - 1]);
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(blk_first, first), _mm256_cmpeq_epi8(blk_last, last)));
+
+        while (mask) {
+            unsigned bit = 31 - (unsigned)__builtin_clz(mask);
+            size_t pos = base + bit;
+            if (m <= 2 || !memcmp(&hay[pos + 1], needle + 1, m - 2)) {
+                return (ssize_t)pos;
+            }
+
+            work += m;
+            mask &= ~(1u << bit);
+        }
+
+        if (STRLIB_OVER_BUDGET(work, n - m + 1 - base)) {
+            return StrLib_FindLastFallback(hay, needle, m, base);
+        }
+    }
+
+    return StrLib_FindLastScalar(hay, needle, m, end);
+}
+
+static inline bool StrLib_HasAVX2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+// Finds the index of the first occurrence of `needle` in `hay`, returns -1 if there is none
+static inline ssize_t StrLib_FindFirst(const char* hay, size_t n, const char* needle, size_t m)
+{
+    if (m > n) {
+        return -1;
+    } else if (m == 0) {
+        return 0;
+    } else if (m == 1) {
+        const char* pos = memchr(hay, needle[0], n);
+        return pos ? pos - hay : -1;
+    }
+
+#if STRLIB_X86_SIMD
+    if (StrLib_HasAVX2()) {
+        return StrLib_FindFirstAVX2(hay, n, needle, m);
+    } else {
+        return StrLib_FindFirstSSE2(hay, n, needle, m);
+    }
+#else
+    return StrLib_FindFirstScalar(hay, n, needle, m, 0);
+#endif
+}
+
+// Finds the index of the last occurrence of `needle` in `hay`, returns -1 if there is none
+static inline ssize_t StrLib_FindLast(const char* hay, size_t n, const char* needle, size_t m)
+{
+    if (m > n) {
+        return -1;
+    } else if (m == 0) {
+        return (ssize_t)n;
+    }
+
+#if STRLIB_X86_SIMD
+    if (StrLib_HasAVX2()) {
+        return StrLib_FindLastAVX2(hay, n, needle, m);
+    } else {
+        return StrLib_FindLastSSE2(hay, n, needle, m);
+    }
+#else
+    return StrLib_FindLastScalar(hay, needle, m, n - m + 1);
+#endif
+}
+
+/* ---- Character classes ---- */
+
+// Set of bytes, e.g. the delimiters to split on
+// NOTE: `rows` holds the set transposed for SIMD lookups (bit hi & 7 of rows[hi >> 3][lo] is set for each byte
+// hi << 4 | lo in the set), so use StringCharSet_Add rather than setting `bits` directly
+typedef struct {
+    uint64_t bits[4];
+    uint8_t rows[2][16];
+} StringCharSet;
+
+// Adds `c` to `set`
+static inline void StringCharSet_Add(StringCharSet* set, char c)
+{
+    unsigned char uc = (unsigned char)c;
+    set->bits[uc >> 6] |= 1ull << (uc & 63);
+    set->rows[uc >> 7][uc & 15] |= (uint8_t)(1u << ((uc >> 4) & 7));
+}
+
+// Creates a StringCharSet containing every char in `chars`
+static inline StringCharSet StringCharSet_FromView(StringView chars)
+{
+    StringCharSet set = { 0 };
+    for (size_t ii = 0; ii < chars.len; ii++) {
+        StringCharSet_Add(&set, chars.buf[ii]);
+    }
+
+    return set;
+}
+
+// Determines if `c` is in `set`
+static inline bool StringCharSet_Contains(const StringCharSet* set, char c)
+{
+    unsigned char uc = (unsigned char)c;
+    return (set->bits[uc >> 6] >> (uc & 63)) & 1;
+}
+
+// The whitespace chars, see String_IsWhitespaceChar
+static const StringCharSet strlib_whitespace = {
+    .bits = { (1ull << ' ') | (1ull << '\t') | (1ull << '\n') | (1ull << '\v') | (1ull << '\f') | (1ull << '\r') },
+    .rows = { { [0] = 1 << 2, [9] = 1, [10] = 1, [11] = 1, [12] = 1, [13] = 1 } },
+};
+
+// Finds the first (last if `rev`) index in [`start`, `end`) whose char is in `set` (not in `set` if `!in`)
+static inline ssize_t
+StrLib_ScanSetScalar(const char* buf, size_t start, size_t end, const StringCharSet* set, bool in, bool rev)
+{
+    if (rev) {
+        for (size_t ii = end; ii-- > start;) {
+            if (StringCharSet_Contains(set, buf[ii]) == in) {
+                return (ssize_t)ii;
+            }
+        }
+    } else {
+        for (size_t ii = start; ii < end; ii++) {
+            if (StringCharSet_Contains(set, buf[ii]) == in) {
+                return (ssize_t)ii;
+            }
+        }
+    }
+
+    return -1;
+}
+
+#if STRLIB_X86_SIMD
+// Set membership of 16 (32 with AVX2) bytes at a time: the low nibble of each byte selects a byte of both rows with
+// pshufb, the high nibble selects the row and the bit within it
+
+// Returns a bitmask of the bytes of `blk` that are in the set with rows `row0` and `row1`
+__attribute__((target("ssse3"))) static inline unsigned StrLib_SetMaskSSSE3(__m128i blk, __m128i row0, __m128i row1)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i bit_of = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    __m128i lo = _mm_and_si128(blk, nibble);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(blk, 4), nibble);
+    __m128i upper = _mm_cmpgt_epi8(hi, _mm_set1_epi8(7));
+    __m128i row = _mm_or_si128(
+        _mm_andnot_si128(upper, _mm_shuffle_epi8(row0, lo)), _mm_and_si128(upper, _mm_shuffle_epi8(row1, lo)));
+    __m128i hit = _mm_and_si128(row, _mm_shuffle_epi8(bit_of, hi));
+
+    return ~(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(hit, _mm_setzero_si128())) & 0xFFFF;
+}
+
+__attribute__((target("ssse3"))) static inline ssize_t
+StrLib_ScanSetSSSE3(const char* buf, size_t len, const StringCharSet* set, bool in, bool rev)
+{
+    const __m128i row0 = _mm_loadu_si128((const __m128i*)set->rows[0]);
+    const __m128i row1 = _mm_loadu_si128((const __m128i*)set->rows[1]);
+    const unsigned flip = in ? 0 : 0xFFFF;
+
+    if (rev) {
+        size_t end = len;
+        for (; end >= 16; end -= 16) {
+            unsigned mask = StrLib_SetMaskSSSE3(_mm_loadu_si128((const __m128i*)&buf[end - 16]), row0, row1) ^ flip;
+            if (mask) {
+                return (ssize_t)(end - 16 + 31 - (size_t)__builtin_clz(mask));
+            }
+        }
+
+        return StrLib_ScanSetScalar(buf, 0, end, set, in, true);
+    }
+
+    size_t ii = 0;
+    for (; ii + 16 <= len; ii += 16) {
+        unsigned mask = StrLib_SetMaskSSSE3(_mm_loadu_si128((const __m128i*)&buf[ii]), row0, row1) ^ flip;
+        if (mask) {
+            return (ssize_t)(ii + (size_t)__builtin_ctz(mask));
+        }
+    }
+
+    return StrLib_ScanSetScalar(buf, ii, len, set, in, false);
+}
+
+__attribute__((target("avx2"))) static inline unsigned StrLib_SetMaskAVX2(__m256i blk, __m256i row0, __m256i row1)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i bit_of = _mm256_setr_epi8(
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    __m256i lo = _mm256_and_si256(blk, nibble);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(blk, 4), nibble);
+    __m256i row = _mm256_blendv_epi8(
+        _mm256_shuffle_epi8(row0, lo), _mm256_shuffle_epi8(row1, lo), _mm256_cmpgt_epi8(hi, _mm256_set1_epi8(7)));
+    __m256i hit = _mm256_and_si256(row, _mm256_shuffle_epi8(bit_of, hi));
+
+    return ~(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hit, _mm256_setzero_si256()));
+}
+
+__attribute__((target("avx2"))) static inline ssize_t
+StrLib_ScanSetAVX2(const char* buf, size_t len, const StringCharSet* set, bool in, bool rev)
+{
+    const __m256i row0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->rows[0]));
+    const __m256i row1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->rows[1]));
+    const unsigned flip = in ? 0 : 0xFFFFFFFF;
+
+    if (rev) {
+        size_t end = len;
+        for (; end >= 32; end -= 32) {
+            unsigned mask = StrLib_SetMaskAVX2(_mm256_loadu_si256((const __m256i*)&buf[end - 32]), row0, row1) ^ flip;
+            if (mask) {
+                return (ssize_t)(end - 32 + 31 - (size_t)__builtin_clz(mask));
+            }
+        }
+
+        return StrLib_ScanSetScalar(buf, 0, end, set, in, true);
+    }
+
+    size_t ii = 0;
+    for (; ii + 32 <= len; ii += 32) {
+        unsigned mask = StrLib_SetMaskAVX2(_mm256_loadu_si256((const __m256i*)&buf[ii]), row0, row1) ^ flip;
+        if (mask) {
+            return (ssize_t)(ii + (size_t)__builtin_ctz(mask));
+        }
+    }
+
+    return StrLib_ScanSetScalar(buf, ii, len, set, in, false);
+}
+
+static inline bool StrLib_HasSSSE3(void)
+{
+    return __builtin_cpu_supports("ssse3");
+}
+#endif
+
+STRLIB_NOINLINE static ssize_t
+StrLib_ScanSetLong(const char* buf, size_t len, const StringCharSet* set, bool in, bool rev)
+{
+#if STRLIB_X86_SIMD
+    if (len >= 32 && StrLib_HasAVX2()) {
+        return StrLib_ScanSetAVX2(buf, len, set, in, rev);
+    } else if (len >= 16 && StrLib_HasSSSE3()) {
+        return StrLib_ScanSetSSSE3(buf, len, set, in, rev);
+    }
+#endif
+    return StrLib_ScanSetScalar(buf, 0, len, set, in, rev);
+}
+
+// Finds the index of the first (last if `rev`) char of `buf` that is in `set` (not in `set` if `!in`), or -1
+static inline ssize_t StrLib_ScanSet(const char* buf, size_t len, const StringCharSet* set, bool in, bool rev)
+{
+    // most scans end at the first char (e.g. trimming text without padding), which is checked before anything else
+    if (len == 0) {
+        return -1;
+    }
+
+    size_t edge = rev ? len - 1 : 0;
+    if (StringCharSet_Contains(set, buf[edge]) == in) {
+        return (ssize_t)edge;
+    }
+
+    return StrLib_ScanSetLong(buf, len, set, in, rev);
+}
+
+// Finds the index of the first char of `view` that is in `set`, returns -1 if there is none
+static inline ssize_t StringView_FindFirstOf(StringView view, const StringCharSet* set)
+{
+    return StrLib_ScanSet(view.buf, view.len, set, true, false);
+}
+
+// Finds the index of the first char of `view` that is not in `set`, returns -1 if there is none
+static inline ssize_t StringView_FindFirstNotOf(StringView view, const StringCharSet* set)
+{
+    return StrLib_ScanSet(view.buf, view.len, set, false, false);
+}
+
+// Finds the index of the last char of `view` that is in `set`, returns -1 if there is none
+static inline ssize_t StringView_FindLastOf(StringView view, const StringCharSet* set)
+{
+    return StrLib_ScanSet(view.buf, view.len, set, true, true);
+}
+
+// Finds the index of the last char of `view` that is not in `set`, returns -1 if there is none
+static inline ssize_t StringView_FindLastNotOf(StringView view, const StringCharSet* set)
+{
+    return StrLib_ScanSet(view.buf, view.len, set, false, true);
+}
+
+/* ---- Comparison kernels ---- */
+
+static inline uint64_t StrLib_Read8(const unsigned char* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t StrLib_Read4(const unsigned char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Converts a word loaded from memory into one that orders like memcmp orders the bytes it was loaded from
+static inline uint64_t StrLib_ByteOrder64(uint64_t v)
+{
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return __builtin_bswap64(v);
+#elif defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return v;
+#else
+    unsigned char bytes[8];
+    memcpy(bytes, &v, sizeof(v));
+    uint64_t ret = 0;
+    for (size_t ii = 0; ii < 8; ii++) {
+        ret = ret << 8 | bytes[ii];
+    }
+    return ret;
+#endif
+}
+
+// Converts the word returned by StrLib_Read4 into one that orders like memcmp orders the bytes it was loaded from
+static inline uint64_t StrLib_ByteOrder32(uint64_t v)
+{
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return __builtin_bswap32((uint32_t)v);
+#elif defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return v;
+#else
+    uint32_t word = (uint32_t)v;
+    unsigned char bytes[4];
+    memcpy(bytes, &word, sizeof(word));
+    uint64_t ret = 0;
+    for (size_t ii = 0; ii < 4; ii++) {
+        ret = ret << 8 | bytes[ii];
+    }
+    return ret;
+#endif
+}
+
+// Returns the first 8 bytes of `buf` (zero padded if `len` is shorter) as a word that orders like memcmp
+static inline uint64_t StrLib_PrefixWord(const char* buf, size_t len)
+{
+    const unsigned char* bytes = (const unsigned char*)buf;
+    if (len >= 8) {
+        return StrLib_ByteOrder64(StrLib_Read8(bytes));
+    }
+
+    uint64_t word = 0;
+    for (size_t ii = 0; ii < len; ii++) {
+        word |= (uint64_t)bytes[ii] << (56 - 8 * ii);
+    }
+    return word;
+}
+
+#if STRLIB_X86_SIMD
+// Returns a mask of the bytes that differ between the 16 bytes at `a` and `b`
+static inline unsigned StrLib_DiffMask16(const char* a, const char* b)
+{
+    __m128i va = _mm_loadu_si128((const __m128i*)a);
+    __m128i vb = _mm_loadu_si128((const __m128i*)b);
+    return ~(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) & 0xFFFF;
+}
+#endif
+
+// Determines if the `len` bytes at `a` and `b` are identical, lengths up to 32 use a few overlapping fixed-width
+// loads instead of a call to memcmp, which is as fast beyond that and uses the widest vectors available
+STRLIB_ALWAYS_INLINE static inline bool StrLib_EqualBytes(const char* a, const char* b, size_t len)
+{
+    const unsigned char* x = (const unsigned char*)a;
+    const unsigned char* y = (const unsigned char*)b;
+    if (len > 32) {
+        return !memcmp(a, b, len);
+    } else if (len >= 8) {
+        if (len <= 16) {
+            uint64_t head = StrLib_Read8(x) ^ StrLib_Read8(y);
+            uint64_t tail = StrLib_Read8(&x[len - 8]) ^ StrLib_Read8(&y[len - 8]);
+            return !(head | tail);
+        }
+#if STRLIB_X86_SIMD
+        return !(StrLib_DiffMask16(a, b) | StrLib_DiffMask16(&a[len - 16], &b[len - 16]));
+#else
+        uint64_t head = (StrLib_Read8(x) ^ StrLib_Read8(y)) | (StrLib_Read8(&x[8]) ^ StrLib_Read8(&y[8]));
+        uint64_t tail = (StrLib_Read8(&x[len - 16]) ^ StrLib_Read8(&y[len - 16]))
+                      | (StrLib_Read8(&x[len - 8]) ^ StrLib_Read8(&y[len - 8]));
+        return !(head | tail);
+#endif
+    } else if (len >= 4) {
+        uint64_t head = StrLib_Read4(x) ^ StrLib_Read4(y);
+        uint64_t tail = StrLib_Read4(&x[len - 4]) ^ StrLib_Read4(&y[len - 4]);
+        return !(head | tail);
+    } else if (len == 0) {
+        return true;
+    }
+
+    // the first, middle and last bytes cover lengths 1 to 3
+    return x[0] == y[0] && x[len / 2] == y[len / 2] && x[len - 1] == y[len - 1];
+}
+
+// Orders the `len` bytes at `a` and `b` like memcmp, lengths up to 16 compare one or two words that order like the
+// bytes they were loaded from and lengths up to 32 locate the first difference with two overlapping vector compares
+STRLIB_ALWAYS_INLINE static inline int StrLib_CompareBytes(const char* a, const char* b, size_t len)
+{
+    const unsigned char* x = (const unsigned char*)a;
+    const unsigned char* y = (const unsigned char*)b;
+    uint64_t wx;
+    uint64_t wy;
+    if (len > 32) {
+        return memcmp(a, b, len);
+    } else if (len > 16) {
+#if STRLIB_X86_SIMD
+        // the second block overlaps the first, whose bytes are known to be equal if it is reached
+        size_t block = 0;
+        unsigned diff = StrLib_DiffMask16(a, b);
+        if (!diff) {
+            block = len - 16;
+            diff = StrLib_DiffMask16(&a[block], &b[block]);
+            if (!diff) {
+                return 0;
+            }
+        }
+        size_t at = block + (size_t)__builtin_ctz(diff);
+        return (int)x[at] - (int)y[at];
+#else
+        return memcmp(a, b, len);
+#endif
+    } else if (len >= 8) {
+        // the last word overlaps the first, it only decides the order if the first words are equal
+        uint64_t head_x = StrLib_ByteOrder64(StrLib_Read8(x));
+        uint64_t head_y = StrLib_ByteOrder64(StrLib_Read8(y));
+        uint64_t tail_x = StrLib_ByteOrder64(StrLib_Read8(&x[len - 8]));
+        uint64_t tail_y = StrLib_ByteOrder64(StrLib_Read8(&y[len - 8]));
+        wx = head_x == head_y ? tail_x : head_x;
+        wy = head_x == head_y ? tail_y : head_y;
+    } else if (len >= 4) {
+        // the first and last 4 bytes overlap for lengths below 8, which cannot change the order
+        wx = StrLib_ByteOrder32(StrLib_Read4(x)) << 32 | StrLib_ByteOrder32(StrLib_Read4(&x[len - 4]));
+        wy = StrLib_ByteOrder32(StrLib_Read4(y)) << 32 | StrLib_ByteOrder32(StrLib_Read4(&y[len - 4]));
+    } else if (len) {
+        wx = (uint64_t)x[0] << 16 | (uint64_t)x[len / 2] << 8 | x[len - 1];
+        wy = (uint64_t)y[0] << 16 | (uint64_t)y[len / 2] << 8 | y[len - 1];
+    } else {
+        return 0;
+    }
+
+    return (wx > wy) - (wx < wy);
+}
+
+/* ---- StringView ---- */
+
+// Creates a StringView of all of `str`
+static inline StringView String_View(const String* str)
+{
+    return (StringView) { .len = str->len, .buf = String_Buf(str) };
+}
+
+// Creates a StringView of a C-string (null terminated char array)
+static inline StringView StringView_FromCString(const char* str)
+{
+    return (StringView) { .len = strlen(str), .buf = str };
+}
+
+// Creates a StringView of an array of characters of some length
+static inline StringView StringView_FromCharArray(const char* arr, size_t len)
+{
+    return (StringView) { .len = len, .buf = arr };
+}
+
+// Returns a String aliasing the chars of `view`, for use with functions that take a String
+// NOTE: Like str(x), it doesn't need to be free'd and calling String_CStr on it is invalid
+static inline String StringView_AsString(StringView view)
+{
+    assert(view.len <= STRING_MAX_LEN);
+    return (String) { .len = view.len, .buf = (char*)view.buf };
+}
+
+// Makes a String copy of `view`
+static inline String String_FromView(StringView view)
+{
+    STRLIB_STATS_SCOPE(String_FromView, view.len);
+    return String_FromCharArray(view.buf, view.len);
+}
+
+// Return a view of the index range [`start`, `end`) of `view`
+static inline StringView StringView_Slice(StringView view, size_t start, size_t end)
+{
+    assert(start <= end);
+    assert(end <= view.len);
+    return (StringView) { .len = end - start, .buf = view.buf + start };
+}
+
+// Return a view of the index range [`start`, `end`) of `str`
+static inline StringView String_SliceView(const String* str, size_t start, size_t end)
+{
+    return StringView_Slice(String_View(str), start, end);
+}
+
+// Finds the index of the first occurrence of `substr` in `view`
+// returns a negative value if no occurrence exists
+static inline ssize_t StringView_FirstOccurrenceOf(StringView view, StringView substr)
+{
+    return StrLib_FindFirst(view.buf, view.len, substr.buf, substr.len);
+}
+
+// Finds the index of the last occurrence of `substr` in `view`
+// returns a negative value if no occurrence exists
+static inline ssize_t StringView_LastOccurrenceOf(StringView view, StringView substr)
+{
+    return StrLib_FindLast(view.buf, view.len, substr.buf, substr.len);
+}
+
+// Determines if `view` contains `substr`
+static inline bool StringView_Contains(StringView view, StringView substr)
+{
+    return StringView_FirstOccurrenceOf(view, substr) >= 0;
+}
+
+// Determines if `view` begins with `prefix`
+static inline bool StringView_StartsWith(StringView view, StringView prefix)
+{
+    if (view.len < prefix.len) {
+        return false;
+    }
+
+    return StrLib_EqualBytes(view.buf, prefix.buf, prefix.len);
+}
+
+// Determines if `view` ends with `suffix`
+static inline bool StringView_EndsWith(StringView view, StringView suffix)
+{
+    if (view.len < suffix.len) {
+        return false;
+    }
+
+    return StrLib_EqualBytes(&view.buf[view.len - suffix.len], suffix.buf, suffix.len);
+}
+
+// returns the lexicographic order of view_a and view_b, same as String_Compare
+STRLIB_ALWAYS_INLINE static inline ssize_t StringView_Compare(StringView view_a, StringView view_b)
+{
+    size_t min_len = view_a.len < view_b.len ? view_a.len : view_b.len;
+
+    int cmp = StrLib_CompareBytes(view_a.buf, view_b.buf, min_len);
+    if (cmp == 0) {
+        return (ssize_t)view_a.len - (ssize_t)view_b.len;
+    } else {
+        return (ssize_t)cmp;
+    }
+}
+
+// Determines if `view_a` is identical to `view_b`
+STRLIB_ALWAYS_INLINE static inline bool StringView_Equal(StringView view_a, StringView view_b)
+{
+    if (view_a.len != view_b.len) {
+        return false;
+    }
+
+    return StrLib_EqualBytes(view_a.buf, view_b.buf, view_a.len);
+}
+
+// A view with its first 8 bytes cached as a word that orders like memcmp, so comparisons between views that differ
+// early (typical of sorting and lookups) are decided without touching either buffer
+typedef struct {
+    uint64_t   prefix;
+    StringView view;
+} StringPrefixView;
+
+// Returns `view` with its prefix word cached
+static inline StringPrefixView StringPrefixView_FromView(StringView view)
+{
+    return (StringPrefixView) { .prefix = StrLib_PrefixWord(view.buf, view.len), .view = view };
+}
+
+// Returns a view of `str` with its prefix word cached, the view is invalidated by any modification to `str`
+static inline StringPrefixView String_PrefixView(const String* str)
+{
+    return StringPrefixView_FromView(String_View(str));
+}
+
+// Returns the lexicographic order of `view_a` and `view_b`, same as StringView_Compare
+static inline ssize_t StringPrefixView_Compare(const StringPrefixView* view_a, const StringPrefixView* view_b)
+{
+    if (view_a->prefix != view_b->prefix) {
+        return view_a->prefix < view_b->prefix ? -1 : 1;
+    }
+
+    // the prefixes only cover real bytes up to the shorter length, the zero padding can match a real '\0'
+    size_t skip = view_a->view.len < view_b->view.len ? view_a->view.len : view_b->view.len;
+    skip = skip < 8 ? skip : 8;
+    return StringView_Compare(
+        StringView_Slice(view_a->view, skip, view_a->view.len),
+        StringView_Slice(view_b->view, skip, view_b->view.len));
+}
+
+// Determines if `view_a` is identical to `view_b`
+static inline bool StringPrefixView_Equal(const StringPrefixView* view_a, const StringPrefixView* view_b)
+{
+    if (view_a->prefix != view_b->prefix || view_a->view.len != view_b->view.len) {
+        return false;
+    } else if (view_a->view.len <= 8) {
+        return true;
+    }
+
+    return StrLib_EqualBytes(&view_a->view.buf[8], &view_b->view.buf[8], view_a->view.len - 8);
+}
+
+// Determines if a char is whitespace
+static inline bool String_IsWhitespaceChar(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+}
+
+// Returns a view of `view` without chars in `set` at the beginning
+static inline StringView StringView_TrimLeftSet(StringView view, const StringCharSet* set)
+{
+    ssize_t front = StringView_FindFirstNotOf(view, set);
+    return StringView_Slice(view, front < 0 ? view.len : (size_t)front, view.len);
+}
+
+// Returns a view of `view` without chars in `set` at the end
+static inline StringView StringView_TrimRightSet(StringView view, const StringCharSet* set)
+{
+    ssize_t back = StringView_FindLastNotOf(view, set);
+    return StringView_Slice(view, 0, (size_t)(back + 1));
+}
+
+// Returns a view of `view` without chars in `set` at the beginning and end
+static inline StringView StringView_TrimSet(StringView view, const StringCharSet* set)
+{
+    return StringView_TrimRightSet(StringView_TrimLeftSet(view, set), set);
+}
+
+// Returns a view of `view` without whitespace at the beginning and end
+static inline StringView StringView_Trim(StringView view)
+{
+    return StringView_TrimSet(view, &strlib_whitespace);
+}
+
+// Returns a view of `view` without whitespace at the beginning
+static inline StringView StringView_TrimLeft(StringView view)
+{
+    return StringView_TrimLeftSet(view, &strlib_whitespace);
+}
+
+// Returns a view of `view` without whitespace at the end
+static inline StringView StringView_TrimRight(StringView view)
+{
+    return StringView_TrimRightSet(view, &strlib_whitespace);
+}
+
+// Returns a view of `str` without whitespace at the beginning and end
+static inline StringView String_TrimView(const String* str)
+{
+    return StringView_Trim(String_View(str));
+}
+
+// Splits `view` around the first occurrence of `delim`, storing the parts before and after it in `before` and `after`
+// returns false (with `before` = `view` and `after` empty) if `delim` doesn't occur in `view`
+static inline bool StringView_Cut(StringView view, StringView delim, StringView* before, StringView* after)
+{
+    ssize_t pos = StringView_FirstOccurrenceOf(view, delim);
+    if (pos < 0) {
+        *before = view;
+        *after = (StringView) { .len = 0, .buf = view.buf + view.len };
+        return false;
+    }
+
+    *before = (StringView) { .len = (size_t)pos, .buf = view.buf };
+    *after = StringView_Slice(view, (size_t)pos + delim.len, view.len);
+    return true;
+}
+
+// Splits `view` wherever `delim` occurs, storing at most `max_pieces` views of the substrings in `pieces`
+// If there are more than `max_pieces` substrings, the last piece holds the rest of `view` unsplit
+// returns the number of pieces stored
+// NOTE: Calling StringView_Split with delim == "" is invalid
+static inline size_t StringView_Split(StringView view, StringView delim, StringView* pieces, size_t max_pieces)
+{
+    assert(delim.len > 0);
+
+    size_t count = 0;
+    StringView rest = view;
+    while (count + 1 < max_pieces) {
+        StringView after;
+        if (!StringView_Cut(rest, delim, &pieces[count], &after)) {
+            break;
+        }
+
+        rest = after;
+        count += 1;
+    }
+
+    if (count < max_pieces) {
+        pieces[count] = rest;
+        count += 1;
+    }
+
+    return count;
+}
+
+/* ---- Split iterator ---- */
+
+// Passing STRING_SPLIT_ALL as `max_splits` splits at every delimiter
+#define STRING_SPLIT_ALL SIZE_MAX
+
+// Lazily splits a view, yielding one piece at a time without allocating
+// NOTE: produces the same pieces as String_Split, e.g. "a;b;" -> "a", "b", ""
+typedef struct {
+    StringView rest;
+    StringView delim;
+    size_t splits_left;
+    bool any;
+    bool done;
+    StringCharSet delim_set;
+} StringSplitIterator;
+
+// Creates an iterator over the substrings of `view` separated by `delim`
+// After `max_splits` splits the rest of `view` is yielded unsplit as the last piece
+// NOTE: Calling StringView_SplitIter with delim == "" is invalid
+static inline StringSplitIterator StringView_SplitIter(StringView view, StringView delim, size_t max_splits)
+{
+    assert(delim.len > 0);
+
+    return (StringSplitIterator) {
+        .rest = view,
+        .delim = delim,
+        .splits_left = max_splits,
+    };
+}
+
+// Creates an iterator over the substrings of `view` separated by any one of the chars in `delims`
+// After `max_splits` splits the rest of `view` is yielded unsplit as the last piece
+// NOTE: Calling StringView_SplitAnyIter with delims == "" is invalid
+static inline StringSplitIterator StringView_SplitAnyIter(StringView view, StringView delims, size_t max_splits)
+{
+    assert(delims.len > 0);
+
+    return (StringSplitIterator) {
+        .rest = view,
+        .splits_left = max_splits,
+        .any = true,
+        .delim_set = StringCharSet_FromView(delims),
+    };
+}
+
+// Creates an iterator over the substrings of `str` separated by `delim`
+// NOTE: The iterator points into `str`, which must outlive it
+static inline StringSplitIterator String_SplitIter(const String* str, const String* delim)
+{
+    return StringView_SplitIter(String_View(str), String_View(delim), STRING_SPLIT_ALL);
+}
+
+// Stores the next piece in `piece`, returns false once all pieces have been yielded
+static inline bool StringSplitIterator_Next(StringSplitIterator* it, StringView* piece)
+{
+    if (it->done) {
+        return false;
+    }
+
+    ssize_t pos = -1;
+    size_t delim_len = 1;
+    if (it->splits_left > 0) {
+        if (it->any) {
+            pos = StringView_FindFirstOf(it->rest, &it->delim_set);
+        } else {
+            pos = StringView_FirstOccurrenceOf(it->rest, it->delim);
+            delim_len = it->delim.len;
+        }
+    }
+
+    if (pos < 0) {
+        *piece = it->rest;
+        it->done = true;
+        return true;
+    }
+
+    *piece = StringView_Slice(it->rest, 0, (size_t)pos);
+    it->rest = StringView_Slice(it->rest, (size_t)pos + delim_len, it->rest.len);
+    it->splits_left -= 1;
+    return true;
+}
+
+/* ---- Match iterator ---- */
+
+// Lazily finds the positions of a substring in a view, yielding one at a time without allocating
+// Distinct matches resume after the end of the previous match, overlapping matches one byte after its start
+// NOTE: an empty substring matches at every position, including the end of the view
+typedef struct {
+    StringView view;
+    StringView substr;
+    size_t pos;
+    bool overlapping;
+} StringFindIterator;
+
+// Creates an iterator over the positions of `substr` in `view`
+static inline StringFindIterator StringView_FindIter(StringView view, StringView substr, bool overlapping)
+{
+    return (StringFindIterator) {
+        .view = view,
+        .substr = substr,
+        .overlapping = overlapping,
+    };
+}
+
+// Creates an iterator over the positions of `substr` in `str`
+// NOTE: The iterator points into `str` and `substr`, which must outlive it
+static inline StringFindIterator String_FindIter(const String* str, const String* substr, bool overlapping)
+{
+    return StringView_FindIter(String_View(str), String_View(substr), overlapping);
+}
+
+// Stores the position of the next match in `pos`, returns false once all matches have been yielded
+static inline bool StringFindIterator_Next(StringFindIterator* it, size_t* pos)
+{
+    if (it->pos > it->view.len) {
+        return false;
+    }
+
+    ssize_t found = StrLib_FindFirst(&it->view.buf[it->pos], it->view.len - it->pos, it->substr.buf, it->substr.len);
+    if (found < 0) {
+        it->pos = it->view.len + 1;
+        return false;
+    }
+
+    *pos = it->pos + (size_t)found;
+    it->pos = *pos + (it->overlapping || !it->substr.len ? 1 : it->substr.len);
+    return true;
+}
+
+// Stores the positions of up to `max_positions` matches of `substr` in `view` in `positions`, in order
+// returns the total number of matches, which may be more than `max_positions`
+static inline size_t StringView_FindAll(
+    StringView view,
+    StringView substr,
+    bool overlapping,
+    size_t* positions,
+    size_t max_positions)
+{
+    StringFindIterator it = StringView_FindIter(view, substr, overlapping);
+    size_t count = 0;
+    size_t pos;
+    while (StringFindIterator_Next(&it, &pos)) {
+        if (count < max_positions) {
+            positions[count] = pos;
+        }
+        count += 1;
+    }
+
+    return count;
+}
+
+/* ---- String operations ---- */
+
+// Finds the index of the first occurrence of `substr` in `str`
+// returns a negative value if no occurrence exists
+static inline ssize_t String_FirstOccurrenceOf(const String* str, const String* substr)
+{
+    STRLIB_STATS_SCOPE(String_FirstOccurrenceOf, str->len);
+    return StrLib_FindFirst(String_Buf(str), str->len, String_Buf(substr), substr->len);
+}
+
+// Finds the index of the last occurrence of `substr` in `str`
+// returns a negative value if no occurrence exists
+static inline ssize_t String_LastOccurrenceOf(const String* str, const String* substr)
+{
+    STRLIB_STATS_SCOPE(String_LastOccurrenceOf, str->len);
+    return StrLib_FindLast(String_Buf(str), str->len, String_Buf(substr), substr->len);
+}
+
+// Determines if `str` begins with the String `prefix`
+static inline bool String_StartsWith(const String* str, const String* prefix)
+{
+    STRLIB_STATS_SCOPE(String_StartsWith, prefix->len);
+    return StringView_StartsWith(String_View(str), String_View(prefix));
+}
+
+// Determines if `str` begins with the String `suffix`
+static inline bool String_EndsWith(const String* str, const String* suffix)
+{
+    STRLIB_STATS_SCOPE(String_EndsWith, suffix->len);
+    return StringView_EndsWith(String_View(str), String_View(suffix));
+}
+
+// Determines if `str` contains `substr`
+static inline bool String_Contains(const String* str, const String* substr)
+{
+    return String_FirstOccurrenceOf(str, substr) >= 0;
+}
+
+// returns the lexicographic order of str_a and str_b
+// if negative, str_a would come before str_b
+// if positive, str_b would come before str_a
+// if zero the strings are identical
+static inline ssize_t String_Compare(const String* str_a, const String* str_b)
+{
+    STRLIB_STATS_SCOPE(String_Compare, str_a->len);
+    return StringView_Compare(String_View(str_a), String_View(str_b));
+}
+
+// Determines if `str_a` is identical to `str_b`
+static inline ssize_t String_Equal(const String* str_a, const String* str_b)
+{
+    STRLIB_STATS_SCOPE(String_Equal, str_a->len);
+    return StringView_Equal(String_View(str_a), String_View(str_b));
+}
+
+// Removes whitespace from the beginning and end of `str`
+static inline String String_Trim(const String* str)
+{
+    STRLIB_STATS_SCOPE(String_Trim, str->len);
+    return String_FromView(String_TrimView(str));
+}
+
+// Removes whitespace from the beginning of `str`
+static inline String String_TrimLeft(const String* str)
+{
+    STRLIB_STATS_SCOPE(String_TrimLeft, str->len);
+    return String_FromView(StringView_TrimLeft(String_View(str)));
+}
+
+// Removes whitespace from the end of `str`
+static inline String String_TrimRight(const String* str)
+{
+    STRLIB_STATS_SCOPE(String_TrimRight, str->len);
+    return String_FromView(StringView_TrimRight(String_View(str)));
+}
+
+// Removes chars in `set` from the beginning and end of `str`
+static inline String String_TrimSet(const String* str, const StringCharSet* set)
+{
+    STRLIB_STATS_SCOPE(String_TrimSet, str->len);
+    return String_FromView(StringView_TrimSet(String_View(str), set));
+}
+
+// Returns the number of distinct (non-overlapping) instances of `substr` in `str`
+// e.g. String_DistinctInstancesOf("aaaa", "aaa") == 1
+static inline size_t String_DistinctInstancesOf(const String* str, const String* substr)
+{
+    STRLIB_STATS_SCOPE(String_DistinctInstancesOf, str->len);
+    return StringView_FindAll(String_View(str), String_View(substr), false, NULL, 0);
+}
+
+// Returns the number of instances of `substr` in `str`
+// e.g. String_InstancesOf("aaaa", "aaa") == 2
+static inline size_t String_InstancesOf(const String* str, const String* substr)
+{
+    STRLIB_STATS_SCOPE(String_InstancesOf, str->len);
+    return StringView_FindAll(String_View(str), String_View(substr), true, NULL, 0);
+}
+
+// Stores the positions of up to `max_positions` instances of `substr` in `str` in `positions`, in order
+// returns the total number of instances (like String_InstancesOf if `overlapping`, else String_DistinctInstancesOf)
+// e.g. String_FindAll("abab", "ab", false, positions, 8) == 2 with positions = { 0, 2 }
+static inline size_t
+String_FindAll(const String* str, const String* substr, bool overlapping, size_t* positions, size_t max_positions)
+{
+    STRLIB_STATS_SCOPE(String_FindAll, str->len);
+    return StringView_FindAll(String_View(str), String_View(substr), overlapping, positions, max_positions);
+}
+
+// Number of match positions String_Replace, String_ReplaceMany and String_Split record while measuring the result,
+// matches past this many are searched for again while copying so the result is still the only allocation
+#define STRLIB_MATCH_BATCH 256
+
+// Copies the unmatched gap src[*src_pos, match) followed by `new` into `dst`, then skips over the match in `src`
+static inline void StrLib_EmitReplacement(
+    char* dst,
+    size_t* dst_pos,
+    const char* src,
+    size_t* src_pos,
+    size_t match,
+    size_t old_len,
+    const String* new)
+{
+    memcpy(&dst[*dst_pos], &src[*src_pos], match - *src_pos);
+    *dst_pos += match - *src_pos;
+    memcpy(&dst[*dst_pos], String_Buf(new), new->len);
+    *dst_pos += new->len;
+    *src_pos = match + old_len;
+}
+
+// Replaces all instances of `old` with `new` in `str`
+// NOTE: Calling String_Replace with old == "" produces the original string
+static inline String String_Replace(const String* str, const String* old, const String* new)
+{
+    STRLIB_STATS_SCOPE(String_Replace, str->len);
+    if (str->len < old->len || old->len == 0) {
+        return String_Copy(str);
+    }
+
+    const char* src = String_Buf(str);
+    size_t matches[STRLIB_MATCH_BATCH];
+    size_t old_count = StringView_FindAll(String_View(str), String_View(old), false, matches, STRLIB_MATCH_BATCH);
+    size_t recorded = old_count < STRLIB_MATCH_BATCH ? old_count : STRLIB_MATCH_BATCH;
+
+    String ret = String_New(str->len - old_count * old->len + old_count * new->len);
+    char* dst = String_Buf(&ret);
+    size_t dst_pos = 0;
+    size_t src_pos = 0;
+
+    for (size_t ii = 0; ii < recorded; ii++) {
+        StrLib_EmitReplacement(dst, &dst_pos, src, &src_pos, matches[ii], old->len, new);
+    }
+
+    if (old_count > recorded) {
+        StringFindIterator it = String_FindIter(str, old, false);
+        it.pos = src_pos;
+        size_t match;
+        while (StringFindIterator_Next(&it, &match)) {
+            StrLib_EmitReplacement(dst, &dst_pos, src, &src_pos, match, old->len, new);
+        }
+    }
+
+    memcpy(&dst[dst_pos], &src[src_pos], str->len - src_pos);
+
+    return ret;
+}
+
+// A substitution for String_ReplaceMany
+typedef struct {
+    const String* old;
+    const String* new;
+} StringReplacement;
+
+// Finds the leftmost match at or after `pos` of the `old` Strings of `reps`, ties go to the first one in `reps`
+// returns the index of the match and stores the index of the matching replacement in `which`, or -1 if there is none
+static inline ssize_t StrLib_FindFirstReplacement(
+    StringView view,
+    size_t pos,
+    const StringReplacement* reps,
+    size_t count,
+    const StringCharSet* firsts,
+    size_t* which)
+{
+    while (pos < view.len) {
+        ssize_t cand = StringView_FindFirstOf(StringView_Slice(view, pos, view.len), firsts);
+        if (cand < 0) {
+            return -1;
+        }
+
+        pos += (size_t)cand;
+        for (size_t ii = 0; ii < count; ii++) {
+            const String* old = reps[ii].old;
+            if (old->len && old->len <= view.len - pos && !memcmp(&view.buf[pos], String_Buf(old), old->len)) {
+                *which = ii;
+                return (ssize_t)pos;
+            }
+        }
+
+        pos += 1;
+    }
+
+    return -1;
+}
+
+// Replaces all instances of each `old` in `reps` with the corresponding `new` in a single pass over `str`
+// Matches are replaced from the left, if several `old` Strings match at the same index the first one in `reps` is used
+// NOTE: `old` Strings which are empty are ignored
+static inline String String_ReplaceMany(const String* str, const StringReplacement* reps, size_t count)
+{
+    STRLIB_STATS_SCOPE(String_ReplaceMany, str->len);
+    StringView src = String_View(str);
+    StringCharSet firsts = { 0 };
+    for (size_t ii = 0; ii < count; ii++) {
+        if (reps[ii].old->len) {
+            StringCharSet_Add(&firsts, String_Buf(reps[ii].old)[0]);
+        }
+    }
+
+    struct {
+        size_t pos;
+        size_t which;
+    } matches[STRLIB_MATCH_BATCH];
+    size_t recorded = 0;
+    size_t match_count = 0;
+    size_t ret_len = str->len;
+
+    ssize_t found;
+    size_t which;
+    for (size_t pos = 0; (found = StrLib_FindFirstReplacement(src, pos, reps, count, &firsts, &which)) >= 0;) {
+        if (recorded < STRLIB_MATCH_BATCH) {
+            matches[recorded].pos = (size_t)found;
+            matches[recorded].which = which;
+            recorded += 1;
+        }
+
+        match_count += 1;
+        ret_len = ret_len - reps[which].old->len + reps[which].new->len;
+        pos = (size_t)found + reps[which].old->len;
+    }
+
+    String ret = String_New(ret_len);
+    char* dst = String_Buf(&ret);
+    size_t dst_pos = 0;
+    size_t src_pos = 0;
+
+    for (size_t ii = 0; ii < recorded; ii++) {
+        const StringReplacement* rep = &reps[matches[ii].which];
+        StrLib_EmitReplacement(dst, &dst_pos, src.buf, &src_pos, matches[ii].pos, rep->old->len, rep->new);
+    }
+
+    if (match_count > recorded) {
+        while ((found = StrLib_FindFirstReplacement(src, src_pos, reps, count, &firsts, &which)) >= 0) {
+            const StringReplacement* rep = &reps[which];
+            StrLib_EmitReplacement(dst, &dst_pos, src.buf, &src_pos, (size_t)found, rep->old->len, rep->new);
+        }
+    }
+
+    memcpy(&dst[dst_pos], &src.buf[src_pos], src.len - src_pos);
+
+    return ret;
+}
+
+// Returns a StringList which contains all the substrings formed by splitting `str` wherever `delim` occurs
+// NOTE: Calling String_Split with delim == "" is invalid
+static inline StringList String_Split(const String* str, const String* delim)
+{
+    STRLIB_STATS_SCOPE(String_Split, str->len);
+    assert(delim->len > 0);
+
+    size_t matches[STRLIB_MATCH_BATCH];
+    size_t delim_count = StringView_FindAll(String_View(str), String_View(delim), false, matches, STRLIB_MATCH_BATCH);
+    size_t recorded = delim_count < STRLIB_MATCH_BATCH ? delim_count : STRLIB_MATCH_BATCH;
+    size_t substr_count = delim_count + 1;
+    size_t char_count = str->len - delim_count * delim->len;
+    size_t char_buf_size = char_count + substr_count; // need 1 extra byte per substring for null terminator insertion
+    size_t str_header_size = sizeof(String) * substr_count;
+
+    char* mem = StrLib_Alloc(char_buf_size + str_header_size);
+    String* strs = (String*)mem;
+    char* data = mem + str_header_size;
+
+    const char* src = String_Buf(str);
+    StringFindIterator it = String_FindIter(str, delim, false);
+    size_t str_pos = 0;
+    for (size_t ii = 0; ii < substr_count; ii++) {
+        // the last substring ends at the end of `str`, matches past the recorded ones are searched for again
+        size_t end = str->len;
+        if (ii < recorded) {
+            end = matches[ii];
+        } else if (ii < delim_count) {
+            it.pos = str_pos;
+            StringFindIterator_Next(&it, &end);
+        }
+
+        strs[ii] = (String) { .len = end - str_pos, .buf = data };
+        memcpy(data, &src[str_pos], end - str_pos);
+        data += end - str_pos + 1;
+        str_pos = end + delim->len;
+    }
+
+    return (StringList) {
+        .len = substr_count,
+        .str = (String*)mem,
+    };
+}
+
+// Concatenates `count` Strings in order, separated by `sep` unless it is NULL
+static inline String String_JoinArray(const String* strs, size_t count, const String* sep)
+{
+    size_t sep_len = sep && count ? sep->len : 0;
+    size_t len = count ? sep_len * (count - 1) : 0;
+    for (size_t ii = 0; ii < count; ii++) {
+        len += strs[ii].len;
+    }
+
+    STRLIB_STATS_SCOPE(String_JoinArray, len);
+    String ret = String_New(len);
+    char* dst = String_Buf(&ret);
+    for (size_t ii = 0; ii < count; ii++) {
+        if (ii && sep_len) {
+            memcpy(dst, String_Buf(sep), sep_len);
+            dst += sep_len;
+        }
+        memcpy(dst, String_Buf(&strs[ii]), strs[ii].len);
+        dst += strs[ii].len;
+    }
+
+    return ret;
+}
+
+// Concatenates the Strings of `list` in order, separated by `sep` unless it is NULL
+// e.g. StringList_Join(String_Split("a,b,c", ","), "-") == "a-b-c"
+static inline String StringList_Join(const StringList* list, const String* sep)
+{
+    return String_JoinArray(list->str, list->len, sep);
+}
+
+// Concatenates the `count` Strings (const String*) that follow in order, separated by `sep` unless it is NULL
+// e.g. String_JoinMany(str(", "), 3, &a, &b, &c)
+static inline String String_JoinMany(const String* sep, size_t count, ...)
+{
+    va_list args;
+    va_start(args, count);
+    va_list args_copy;
+    va_copy(args_copy, args);
+
+    size_t sep_len = sep && count ? sep->len : 0;
+    size_t len = count ? sep_len * (count - 1) : 0;
+    for (size_t ii = 0; ii < count; ii++) {
+        len += va_arg(args, const String*)->len;
+    }
+    va_end(args);
+
+    STRLIB_STATS_SCOPE(String_JoinMany, len);
+    String ret = String_New(len);
+    char* dst = String_Buf(&ret);
+    for (size_t ii = 0; ii < count; ii++) {
+        const String* str = va_arg(args_copy, const String*);
+        if (ii && sep_len) {
+            memcpy(dst, String_Buf(sep), sep_len);
+            dst += sep_len;
+        }
+        memcpy(dst, String_Buf(str), str->len);
+        dst += str->len;
+    }
+    va_end(args_copy);
+
+    return ret;
+}
+
+// Returns a C-style string given a String
+// NOTE: Does not allocate memory, lifetime of the return value is tied to that of the supplied String
+// intended to be used to interface with C-style APIs efficiently
+// NOTE: Mapped Strings (see String_MapFile) are already null-terminated and are not written to
+// NOTE: Shared slices (see String_SliceShared) that don't end where their block does are replaced by a copy, which
+// allocates if they are longer than STRING_SSO_CAPACITY
+static inline const char* String_CStr(String* str)
+{
+    char* buf = String_Buf(str);
+    if (str->kind == STRING_KIND_SHARED) {
+        // slices ending where the block (or an embedded \0) does are already terminated, the chars after other slices
+        // belong to the Strings sharing them, so those slices get a private copy of their chars instead
+        if (buf[str->len] != '\0') {
+            String copy = String_New(str->len);
+            memcpy(String_Buf(&copy), buf, str->len);
+            String_Delete(str);
+            *str = copy;
+            buf = String_Buf(str);
+            buf[str->len] = '\0';
+        }
+    } else if (str->kind != STRING_KIND_MAPPED) {
+        buf[str->len] = '\0';
+    }
+    return buf;
+}
+
+// Return a slice from a string from index range [`start`, `end`) from `str`
+static inline String String_Slice(const String* str, size_t start, size_t end)
+{
+    STRLIB_STATS_SCOPE(String_Slice, end - start);
+    assert(0 <= start && start < str->len);
+    assert(0 <= end && end <= str->len);
+    assert(end >= start);
+    return String_FromCharArray(&String_Buf(str)[start], end - start);
+}
+
+// Write a string to a FILE*
+static inline void String_Write(const String* str, FILE* fd)
+{
+    STRLIB_STATS_SCOPE(String_Write, str->len);
+    fwrite(String_Buf(str), sizeof(char), str->len, fd);
+}
+
+// Print a string to stdout
+// NOTE: Capable of printing past null chars
+static inline void String_Print(const String* str)
+{
+    String_Write(str, stdout);
+}
+
+/* ---- Memory-mapped files ---- */
+
+#if STRLIB_POSIX
+// Size of the mapping of a `len` byte file, which has room for a null terminator after the file's contents
+static inline size_t StrLib_MapSize(size_t len)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (len + page) / page * page;
+}
+
+// Maps the file at `path` read-only into memory as `str`, without copying it into the heap
+// returns false (with errno set) if the file can't be opened, mapped or is longer than STRING_MAX_LEN
+// NOTE: `str` must be released with String_UnmapFile rather than String_Delete, and is only valid until then
+// NOTE: The chars of `str` must not be written to. They are followed by a null terminator, so String_CStr works on
+// `str` without writing to it. Truncating the file while it is mapped makes accesses past the new end fault (SIGBUS)
+static inline bool String_MapFile(const char* path, String* str)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return false;
+    }
+
+    size_t len = (size_t)st.st_size;
+    if ((uint64_t)st.st_size > STRING_MAX_LEN) {
+        close(fd);
+        errno = EFBIG;
+        return false;
+    }
+
+    // reserve zeroed pages for the file and its terminator, then map the file over them, so the terminator exists
+    // even if the file ends on a page boundary (the rest of the file's last page is zero filled)
+    size_t size = StrLib_MapSize(len);
+    char* mem = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    if (len && mmap(mem, len, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        int err = errno;
+        munmap(mem, size);
+        close(fd);
+        errno = err;
+        return false;
+    }
+
+    close(fd);
+    madvise(mem, size, MADV_SEQUENTIAL);
+
+    *str = (String) { .len = len, .buf = mem };
+    str->kind = STRING_KIND_MAPPED;
+    return true;
+}
+
+// Maps the file at `path` read-only into memory like String_MapFile, returns a view of its contents in `view`
+// NOTE: Release it with StringView_UnmapFile
+static inline bool StringView_MapFile(const char* path, StringView* view)
+{
+    String str;
+    if (!String_MapFile(path, &str)) {
+        return false;
+    }
+
+    *view = String_View(&str);
+    return true;
+}
+
+// Releases a String created by String_MapFile
+static inline void String_UnmapFile(String* str)
+{
+    assert(str->kind == STRING_KIND_MAPPED);
+    munmap(str->buf, StrLib_MapSize(str->len));
+}
+
+// Releases a view created by StringView_MapFile
+static inline void StringView_UnmapFile(StringView view)
+{
+    munmap((void*)view.buf, StrLib_MapSize(view.len));
+}
+#endif
+
+/* ---- Vectored output ---- */
+
+#if STRLIB_POSIX
+// Number of buffers passed to each writev call
+#if defined(IOV_MAX) && IOV_MAX < 1024
+#define STRLIB_IOV_BATCH IOV_MAX
+#else
+#define STRLIB_IOV_BATCH 1024
+#endif
+
+// Writes all of `iov` to `fd`, continuing after short writes and interrupts
+static inline bool StrLib_WriteAll(int fd, struct iovec* iov, int count, size_t* written)
+{
+    while (count > 0) {
+        ssize_t ret = writev(fd, iov, count);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        *written += (size_t)ret;
+        size_t left = (size_t)ret;
+        for (; count > 0 && left >= iov->iov_len; iov++, count--) {
+            left -= iov->iov_len;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+
+    return true;
+}
+
+// Pieces shorter than this are copied together into a staging buffer instead of being written as separate buffers,
+// since the kernel handles many tiny buffers slower than copying them
+#define STRLIB_WRITEV_SMALL 64
+#define STRLIB_WRITEV_STAGE 4096
+
+typedef struct {
+    int fd;
+    int count;
+    size_t written;
+    size_t staged;
+    struct iovec iov[STRLIB_IOV_BATCH];
+    char stage[STRLIB_WRITEV_STAGE];
+} StrLib_WriteVState;
+
+static inline bool StrLib_WriteVFlush(StrLib_WriteVState* state)
+{
+    int count = state->count;
+    state->count = 0;
+    state->staged = 0;
+    return StrLib_WriteAll(state->fd, state->iov, count, &state->written);
+}
+
+// Adds `len` chars at `buf` to the pending buffers, writing them out once the batch is full
+static inline bool StrLib_WriteVPush(StrLib_WriteVState* state, const char* buf, size_t len)
+{
+    if (!len) {
+        return true;
+    }
+
+    if (len < STRLIB_WRITEV_SMALL) {
+        if (state->staged + len > STRLIB_WRITEV_STAGE && !StrLib_WriteVFlush(state)) {
+            return false;
+        }
+
+        char* dst = &state->stage[state->staged];
+        memcpy(dst, buf, len);
+        state->staged += len;
+
+        // extend the previous buffer if it ends where this piece was staged
+        struct iovec* last = state->count ? &state->iov[state->count - 1] : NULL;
+        if (last && (char*)last->iov_base + last->iov_len == dst) {
+            last->iov_len += len;
+            return true;
+        }
+        buf = dst;
+    }
+
+    state->iov[state->count++] = (struct iovec) { .iov_base = (void*)buf, .iov_len = len };
+    return state->count < STRLIB_IOV_BATCH || StrLib_WriteVFlush(state);
+}
+
+// Writes `count` Strings to the file descriptor `fd` with as few writev calls as possible, separated by `sep` unless
+// it is NULL
+// returns the number of bytes written, or a negative value (with errno set) if writing fails
+// NOTE: Doesn't go through stdio, flush any FILE* writing to the same file descriptor first
+static inline ssize_t String_WriteV(int fd, const String* strs, size_t count, const String* sep)
+{
+    StrLib_WriteVState state;
+    state.fd = fd;
+    state.count = 0;
+    state.written = 0;
+    state.staged = 0;
+    for (size_t ii = 0; ii < count; ii++) {
+        if (ii && sep && !StrLib_WriteVPush(&state, String_Buf(sep), sep->len)) {
+            return -1;
+        }
+        if (!StrLib_WriteVPush(&state, String_Buf(&strs[ii]), strs[ii].len)) {
+            return -1;
+        }
+    }
+
+    return StrLib_WriteVFlush(&state) ? (ssize_t)state.written : -1;
+}
+
+// Writes the Strings of `list` to the file descriptor `fd`, see String_WriteV
+static inline ssize_t StringList_WriteV(int fd, const StringList* list, const String* sep)
+{
+    return String_WriteV(fd, list->str, list->len, sep);
+}
+#endif
+
+/* ---- Streaming reader ---- */
+
+#ifndef STRLIB_READER_BUFFER_SIZE
+#define STRLIB_READER_BUFFER_SIZE (64 * 1024)
+#endif
+
+// Buffered reader splitting a FILE* or file descriptor into records separated by a delimiter char
+// NOTE: Records are views into `buf`, which is refilled by the next call to StringReader_Next, so a record is only
+// valid until then
+typedef struct {
+    FILE* file;  // source, unless NULL
+    int fd;      // source if `file` is NULL
+    char delim;  // char separating records
+    bool eof;    // the source has been read to the end
+    bool error;  // reading from the source failed, treated as the end of it
+    char* buf;   // buffered chars, the current record starts at `start` and the buffered data ends at `end`
+    size_t cap;
+    size_t start;
+    size_t scan; // chars before `scan` are known not to be delimiters
+    size_t end;
+} StringReader;
+
+// Creates a reader of records separated by `delim` from `file`, buffering `buf_size` bytes at a time (0 for
+// STRLIB_READER_BUFFER_SIZE)
+// NOTE: The buffer grows to fit records longer than it
+static inline StringReader StringReader_New(FILE* file, char delim, size_t buf_size)
+{
+    size_t cap = buf_size ? buf_size : STRLIB_READER_BUFFER_SIZE;
+
+    return (StringReader) { .file = file, .fd = -1, .delim = delim, .buf = StrLib_Alloc(cap), .cap = cap };
+}
+
+#if STRLIB_POSIX
+// Creates a reader of records separated by `delim` from the file descriptor `fd`, see StringReader_New
+// NOTE: Unlike a FILE*, records are returned as soon as they have been received, e.g. from a pipe or socket
+static inline StringReader StringReader_FromFd(int fd, char delim, size_t buf_size)
+{
+    StringReader reader = StringReader_New(NULL, delim, buf_size);
+    reader.fd = fd;
+    return reader;
+}
+#endif
+
+// Frees the buffer of `reader`, doesn't close its source
+static inline void StringReader_Delete(StringReader* reader)
+{
+    StrLib_Free(reader->buf);
+}
+
+// Reads more data into the buffer of `reader`, making room for it first
+static inline void StrLib_ReaderFill(StringReader* reader)
+{
+    if (reader->start) {
+        memmove(reader->buf, &reader->buf[reader->start], reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->scan -= reader->start;
+        reader->start = 0;
+    }
+
+    if (reader->end == reader->cap) {
+        reader->buf = StrLib_Realloc(reader->buf, reader->cap, 2 * reader->cap);
+        reader->cap *= 2;
+    }
+
+    size_t read_len = 0;
+    if (reader->file) {
+        read_len = fread(&reader->buf[reader->end], 1, reader->cap - reader->end, reader->file);
+        reader->error = !read_len && ferror(reader->file);
+    }
+#if STRLIB_POSIX
+    else {
+        ssize_t ret;
+        do {
+            ret = read(reader->fd, &reader->buf[reader->end], reader->cap - reader->end);
+        } while (ret < 0 && errno == EINTR);
+        reader->error = ret < 0;
+        read_len = ret > 0 ? (size_t)ret : 0;
+    }
+#endif
+
+    reader->eof = !read_len;
+    reader->end += read_len;
+}
+
+// Reads the next record from `reader` into `record` (without its delimiter)
+// returns false once the source has been read to the end, the last record doesn't need to end with a delimiter
+static inline bool StringReader_Next(StringReader* reader, StringView* record)
+{
+    while (true) {
+        const char* found = memchr(&reader->buf[reader->scan], reader->delim, reader->end - reader->scan);
+        if (found) {
+            size_t pos = (size_t)(found - reader->buf);
+            *record = (StringView) { .len = pos - reader->start, .buf = &reader->buf[reader->start] };
+            reader->start = reader->scan = pos + 1;
+            return true;
+        }
+
+        reader->scan = reader->end;
+        if (reader->eof) {
+            if (reader->start == reader->end) {
+                return false;
+            }
+
+            *record = (StringView) { .len = reader->end - reader->start, .buf = &reader->buf[reader->start] };
+            reader->start = reader->end;
+            return true;
+        }
+
+        StrLib_ReaderFill(reader);
+    }
+}
+
+/* ---- StringBuilder ---- */
+
+// Growable buffer for efficiently constructing a String from many pieces
+// NOTE: `buf` always has room for a null terminator past `len`, so the finalized String supports String_CStr
+typedef struct {
+    size_t len;
+    size_t cap;
+    char* buf;
+} StringBuilder;
+
+// Creates a StringBuilder with space for at least `cap` chars
+static inline StringBuilder StringBuilder_New(size_t cap)
+{
+    char* buf = StrLib_Alloc(cap + 1);
+
+    return (StringBuilder) { .len = 0, .cap = cap + 1, .buf = buf };
+}
+
+// Frees a StringBuilder
+static inline void StringBuilder_Delete(StringBuilder* sb)
+{
+    if (sb->buf) {
+        StrLib_Free(sb->buf);
+    }
+    *sb = (StringBuilder) { 0 };
+}
+
+// Ensures `sb` can hold `additional` more chars without reallocating
+// NOTE: capacity grows geometrically so a sequence of appends is amortized O(1) per char
+static inline void StringBuilder_Reserve(StringBuilder* sb, size_t additional)
+{
+    size_t needed = sb->len + additional + 1;
+    if (needed <= sb->cap) {
+        return;
+    }
+
+    STRLIB_STATS_SCOPE(StringBuilder_Reserve, 0);
+    size_t cap = sb->cap < 16 ? 16 : sb->cap;
+    while (cap < needed) {
+        cap *= 2;
+    }
+
+    char* buf = sb->buf ? StrLib_Realloc(sb->buf, sb->cap, cap) : StrLib_Alloc(cap);
+
+    sb->buf = buf;
+    sb->cap = cap;
+}
+
+// Empties `sb` while keeping its buffer for reuse
+static inline void StringBuilder_Clear(StringBuilder* sb)
+{
+    sb->len = 0;
+}
+
+// Appends an array of characters of some length to `sb`
+static inline void StringBuilder_AppendCharArray(StringBuilder* sb, const char* arr, size_t len)
+{
+    StringBuilder_Reserve(sb, len);
+    memcpy(&sb->buf[sb->len], arr, len);
+    sb->len += len;
+}
+
+// Appends `str` to `sb`
+static inline void StringBuilder_Append(StringBuilder* sb, const String* str)
+{
+    StringBuilder_AppendCharArray(sb, String_Buf(str), str->len);
+}
+
+// Appends `view` to `sb`
+static inline void StringBuilder_AppendView(StringBuilder* sb, StringView view)
+{
+    StringBuilder_AppendCharArray(sb, view.buf, view.len);
+}
+
+// Appends a C-string (null terminated char array) to `sb`
+static inline void StringBuilder_AppendCString(StringBuilder* sb, const char* str)
+{
+    StringBuilder_AppendCharArray(sb, str, strlen(str));
+}
+
+// Appends a single char to `sb`
+static inline void StringBuilder_AppendChar(StringBuilder* sb, char c)
+{
+    StringBuilder_Reserve(sb, 1);
+    sb->buf[sb->len] = c;
+    sb->len += 1;
+}
+
+// Appends the decimal representation of `val` to `sb`
+static inline void StringBuilder_AppendUInt(StringBuilder* sb, unsigned long long val)
+{
+    char digits[20];
+    size_t pos = sizeof(digits);
+
+    do {
+        digits[--pos] = (char)('0' + val % 10);
+        val /= 10;
+    } while (val);
+
+    StringBuilder_AppendCharArray(sb, &digits[pos], sizeof(digits) - pos);
+}
+
+// Appends the decimal representation of `val` to `sb`
+static inline void StringBuilder_AppendInt(StringBuilder* sb, long long val)
+{
+    if (val < 0) {
+        StringBuilder_AppendChar(sb, '-');
+        StringBuilder_AppendUInt(sb, 0ull - (unsigned long long)val);
+    } else {
+        StringBuilder_AppendUInt(sb, (unsigned long long)val);
+    }
+}
+
+// Appends printf style formatted output to `sb`
+__attribute__((format(printf, 2, 3))) static inline void StringBuilder_AppendFormat(StringBuilder* sb, const char* fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    size_t avail = sb->buf ? sb->cap - sb->len : 0;
+    int len = vsnprintf(avail ? &sb->buf[sb->len] : NULL, avail, fmt, args);
+    va_end(args);
+    assert(len >= 0);
+
+    if ((size_t)len >= avail) {
+        StringBuilder_Reserve(sb, (size_t)len);
+
+        va_start(args, fmt);
+        vsnprintf(&sb->buf[sb->len], (size_t)len + 1, fmt, args);
+        va_end(args);
+    }
+
+    sb->len += (size_t)len;
+}
+
+// Returns the contents of `sb` as a String and resets `sb` to empty
+// NOTE: Does not copy, the String takes ownership of the buffer and requires a corresponding call to String_Delete
+static inline String StringBuilder_Finalize(StringBuilder* sb)
+{
+    if (!sb->buf) {
+        return String_New(0);
+    }
+
+    assert(sb->len <= STRING_MAX_LEN);
+    String ret = { .len = sb->len, .buf = sb->buf };
+    *sb = (StringBuilder) { 0 };
+
+    return ret;
+}
+
+/* ---- Multi-pattern matcher ---- */
+
+// Aho-Corasick automaton compiled from a set of patterns, searches for all of them in a single pass
+// The automaton is a dense DFA over byte equivalence classes (every byte that doesn't occur in a pattern shares a
+// class), so each row is only as wide as the number of distinct bytes in the patterns
+// Pattern sets whose table would be larger than STRLIB_MATCHER_DENSE_MAX entries (many long patterns over a large
+// alphabet) are compiled to a sparse automaton instead, which only stores the trie edges (plus a dense row for the root)
+// and follows failure links while scanning
+typedef struct {
+    size_t pattern_count;
+    size_t max_len;
+    size_t class_count;
+    uint32_t state_count;
+    bool sparse;
+    uint8_t byte_class[256];
+    uint32_t* trans;       // trans[state * class_count + class], premultiplied by class_count, see STRLIB_MATCHER_OUT
+                           // sparse automatons only have the row of the root
+    uint32_t* match;       // pattern id + 1 of a pattern ending at this state, 0 if none
+    uint32_t* dict_link;   // (premultiplied) nearest proper suffix state with a match, 0 if none
+    uint32_t* same_next;   // pattern id + 1 of the next duplicate of a pattern, 0 if none
+    size_t* pattern_len;
+    uint32_t* fail;        // sparse: longest proper suffix state of each state
+    uint32_t* first_child; // sparse: first trie child of each state, 0 if none
+    uint32_t* next_sibling; // sparse: next trie child of the same parent, 0 if none
+    uint8_t* child_class;  // sparse: class of the trie edge into each state
+} StringMatcher;
+
+// Set on transitions into states where a pattern ends, so the scan loop only checks the output tables when needed
+#define STRLIB_MATCHER_OUT 0x80000000u
+
+// Largest dense transition table (in 4 byte entries) StringMatcher_New builds, larger automatons are sparse
+#ifndef STRLIB_MATCHER_DENSE_MAX
+#define STRLIB_MATCHER_DENSE_MAX (1 << 22)
+#endif
+
+_Static_assert(STRLIB_MATCHER_DENSE_MAX < STRLIB_MATCHER_OUT, "premultiplied dense states must not overlap the OUT bit");
+
+// A match found by a StringMatcher, `pattern` is the index of the matching pattern
+typedef struct {
+    size_t pos;
+    size_t pattern;
+} StringMatch;
+
+// Returns the trie child of `state` for byte class `cc`, 0 if there is none (before the failure transitions are added)
+static inline uint32_t StrLib_MatcherChild(const StringMatcher* m, uint32_t state, uint8_t cc)
+{
+    if (!m->sparse || state == 0) {
+        return m->trans[state + cc];
+    }
+
+    for (uint32_t child = m->first_child[state]; child; child = m->next_sibling[child]) {
+        if (m->child_class[child] == cc) {
+            return child;
+        }
+    }
+
+    return 0;
+}
+
+static inline void StrLib_MatcherAddChild(StringMatcher* m, uint32_t state, uint8_t cc, uint32_t child)
+{
+    if (!m->sparse || state == 0) {
+        m->trans[state + cc] = child;
+        return;
+    }
+
+    m->child_class[child] = cc;
+    m->next_sibling[child] = m->first_child[state];
+    m->first_child[state] = child;
+}
+
+// Returns the state a sparse automaton moves to from `state` on byte class `cc`
+static inline uint32_t StrLib_MatcherSparseNext(const StringMatcher* m, uint32_t state, uint8_t cc)
+{
+    for (; state; state = m->fail[state]) {
+        uint32_t child = StrLib_MatcherChild(m, state, cc);
+        if (child) {
+            return child;
+        }
+    }
+
+    return m->trans[cc];
+}
+
+// Compiles a StringMatcher which searches for all of `patterns`
+// NOTE: empty patterns never match, requires a corresponding call to StringMatcher_Delete
+// NOTE: aborts if the patterns total 2 GiB or more, since states are numbered with 31 bits
+static inline StringMatcher StringMatcher_New(const String* patterns, size_t count)
+{
+    StringMatcher m = { .pattern_count = count };
+
+    size_t total_len = 0;
+    bool used[256] = { 0 };
+    for (size_t ii = 0; ii < count; ii++) {
+        const char* buf = String_Buf(&patterns[ii]);
+        for (size_t jj = 0; jj < patterns[ii].len; jj++) {
+            used[(unsigned char)buf[jj]] = true;
+        }
+
+        total_len += patterns[ii].len;
+        m.max_len = patterns[ii].len > m.max_len ? patterns[ii].len : m.max_len;
+    }
+
+    m.class_count = 1;
+    for (size_t cc = 0; cc < 256; cc++) {
+        m.byte_class[cc] = used[cc] ? (uint8_t)m.class_count++ : 0;
+    }
+
+    // this isn't an assert, wrapped state ids would silently give wrong matches in release builds
+    size_t max_states = total_len + 1;
+    if (max_states >= STRLIB_MATCHER_OUT) {
+        abort();
+    }
+
+    m.sparse = max_states * m.class_count > STRLIB_MATCHER_DENSE_MAX;
+    m.trans = StrLib_Calloc((m.sparse ? 1 : max_states) * m.class_count, sizeof(uint32_t));
+    m.match = StrLib_Calloc(max_states, sizeof(uint32_t));
+    m.dict_link = StrLib_Calloc(max_states, sizeof(uint32_t));
+    m.same_next = StrLib_Calloc(count ? count : 1, sizeof(uint32_t));
+    m.pattern_len = StrLib_Calloc(count ? count : 1, sizeof(size_t));
+    uint32_t* fail = StrLib_Calloc(max_states, sizeof(uint32_t));
+    uint32_t* queue = StrLib_Calloc(max_states, sizeof(uint32_t));
+    if (m.sparse) {
+        m.fail = fail;
+        m.first_child = StrLib_Calloc(max_states, sizeof(uint32_t));
+        m.next_sibling = StrLib_Calloc(max_states, sizeof(uint32_t));
+        m.child_class = StrLib_Calloc(max_states, sizeof(uint8_t));
+    }
+
+    // build the trie, dense states are premultiplied by class_count and 0 (the root) doubles as 'no transition'
+    uint32_t nc = (uint32_t)m.class_count;
+    uint32_t scale = m.sparse ? 1 : nc;
+    m.state_count = 1;
+    for (size_t ii = 0; ii < count; ii++) {
+        const char* buf = String_Buf(&patterns[ii]);
+        m.pattern_len[ii] = patterns[ii].len;
+        if (patterns[ii].len == 0) {
+            continue;
+        }
+
+        uint32_t state = 0;
+        for (size_t jj = 0; jj < patterns[ii].len; jj++) {
+            uint8_t cc = m.byte_class[(unsigned char)buf[jj]];
+            uint32_t next = StrLib_MatcherChild(&m, state, cc);
+            if (!next) {
+                next = m.state_count++ * scale;
+                StrLib_MatcherAddChild(&m, state, cc, next);
+            }
+            state = next;
+        }
+
+        m.same_next[ii] = m.match[state / scale];
+        m.match[state / scale] = (uint32_t)ii + 1;
+    }
+
+    // breadth first computation of the failure links, which the dense automaton folds into its transitions to
+    // become a complete DFA
+    size_t head = 0;
+    size_t tail = 0;
+    for (uint32_t cc = 0; cc < nc; cc++) {
+        if (m.trans[cc]) {
+            queue[tail++] = m.trans[cc];
+        }
+    }
+
+    while (head < tail) {
+        uint32_t state = queue[head++];
+        uint32_t link = fail[state / scale];
+        m.dict_link[state / scale] = m.match[link / scale] ? link : m.dict_link[link / scale];
+
+        if (m.sparse) {
+            for (uint32_t child = m.first_child[state]; child; child = m.next_sibling[child]) {
+                fail[child] = StrLib_MatcherSparseNext(&m, link, m.child_class[child]);
+                queue[tail++] = child;
+            }
+            continue;
+        }
+
+        for (uint32_t cc = 0; cc < nc; cc++) {
+            uint32_t* next = &m.trans[state + cc];
+            if (*next) {
+                fail[*next / nc] = m.trans[link + cc];
+                queue[tail++] = *next;
+            } else {
+                *next = m.trans[link + cc];
+            }
+        }
+    }
+
+    if (!m.sparse) {
+        for (size_t ii = 0; ii < (size_t)m.state_count * nc; ii++) {
+            uint32_t next = m.trans[ii] / nc;
+            if (m.match[next] || m.dict_link[next]) {
+                m.trans[ii] |= STRLIB_MATCHER_OUT;
+            }
+        }
+
+        StrLib_Free(fail);
+    }
+    StrLib_Free(queue);
+
+    return m;
+}
+
+// Frees a StringMatcher
+static inline void StringMatcher_Delete(StringMatcher* m)
+{
+    StrLib_Free(m->trans);
+    StrLib_Free(m->match);
+    StrLib_Free(m->dict_link);
+    StrLib_Free(m->same_next);
+    StrLib_Free(m->pattern_len);
+    if (m->sparse) {
+        StrLib_Free(m->fail);
+        StrLib_Free(m->first_child);
+        StrLib_Free(m->next_sibling);
+        StrLib_Free(m->child_class);
+    }
+}
+
+// Calls `on_match` for every pattern ending at (unscaled) `state`, which ends at index `end` - 1
+// returns false if `on_match` did
+static inline bool StrLib_MatcherReport(
+    const StringMatcher* m,
+    uint32_t state,
+    uint32_t scale,
+    size_t end,
+    bool (*on_match)(void* ctx, size_t end, size_t pattern),
+    void* ctx)
+{
+    for (uint32_t out = m->match[state / scale] ? state : m->dict_link[state / scale]; out;
+         out = m->dict_link[out / scale]) {
+        for (uint32_t id = m->match[out / scale]; id; id = m->same_next[id - 1]) {
+            if (!on_match(ctx, end, id - 1)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Runs `m` over `str`, calling `on_match` for every match (ending at index `end` - 1) until it returns false
+// returns false if the scan was stopped by `on_match`
+static inline bool StrLib_MatcherScan(
+    const StringMatcher* m,
+    const String* str,
+    bool (*on_match)(void* ctx, size_t end, size_t pattern),
+    void* ctx)
+{
+    const unsigned char* buf = (const unsigned char*)String_Buf(str);
+    uint32_t state = 0;
+
+    if (m->sparse) {
+        for (size_t ii = 0; ii < str->len; ii++) {
+            state = StrLib_MatcherSparseNext(m, state, m->byte_class[buf[ii]]);
+            if ((m->match[state] || m->dict_link[state]) && !StrLib_MatcherReport(m, state, 1, ii + 1, on_match, ctx)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    for (size_t ii = 0; ii < str->len; ii++) {
+        state = m->trans[state + m->byte_class[buf[ii]]];
+        if (!(state & STRLIB_MATCHER_OUT)) {
+            continue;
+        }
+
+        state &= ~STRLIB_MATCHER_OUT;
+        if (!StrLib_MatcherReport(m, state, (uint32_t)m->class_count, ii + 1, on_match, ctx)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+typedef struct {
+    const StringMatcher* m;
+    StringMatch best;
+    bool found;
+} StrLib_FirstMatchCtx;
+
+static inline bool StrLib_OnFirstMatch(void* ctx, size_t end, size_t pattern)
+{
+    StrLib_FirstMatchCtx* first = ctx;
+    size_t pos = end - first->m->pattern_len[pattern];
+
+    // matches ending later than best.pos + max_len can't start before best.pos
+    if (first->found && end > first->best.pos + first->m->max_len) {
+        return false;
+    }
+
+    if (!first->found || pos < first->best.pos || (pos == first->best.pos && pattern < first->best.pattern)) {
+        first->best = (StringMatch) { .pos = pos, .pattern = pattern };
+        first->found = true;
+    }
+
+    return true;
+}
+
+// Finds the leftmost match of any pattern of `m` in `str`, ties go to the lowest pattern index
+// returns false if there are no matches
+static inline bool StringMatcher_FindFirst(const StringMatcher* m, const String* str, StringMatch* match)
+{
+    StrLib_FirstMatchCtx first = { .m = m };
+    StrLib_MatcherScan(m, str, StrLib_OnFirstMatch, &first);
+
+    if (first.found) {
+        *match = first.best;
+    }
+
+    return first.found;
+}
+
+typedef struct {
+    const StringMatcher* m;
+    StringMatch* matches;
+    size_t max_matches;
+    size_t count;
+} StrLib_AllMatchesCtx;
+
+static inline bool StrLib_OnAnyMatch(void* ctx, size_t end, size_t pattern)
+{
+    StrLib_AllMatchesCtx* all = ctx;
+    if (all->count < all->max_matches) {
+        all->matches[all->count] = (StringMatch) { .pos = end - all->m->pattern_len[pattern], .pattern = pattern };
+    }
+
+    all->count += 1;
+    return true;
+}
+
+// Stores up to `max_matches` (possibly overlapping) matches of the patterns of `m` in `str` into `matches`, ordered by
+// the index they end at
+// returns the total number of matches, which may be more than `max_matches`
+static inline size_t StringMatcher_FindAll(const StringMatcher* m, const String* str, StringMatch* matches, size_t max_matches)
+{
+    StrLib_AllMatchesCtx all = { .m = m, .matches = matches, .max_matches = max_matches };
+    StrLib_MatcherScan(m, str, StrLib_OnAnyMatch, &all);
+
+    return all.count;
+}
+
+// Returns the total number of (possibly overlapping) matches of the patterns of `m` in `str`
+// NOTE: equal to the sum of String_InstancesOf over every non-empty pattern
+static inline size_t StringMatcher_Count(const StringMatcher* m, const String* str)
+{
+    return StringMatcher_FindAll(m, str, NULL, 0);
+}
+
+static inline bool StrLib_OnAnyMatchStop(void* ctx, size_t end, size_t pattern)
+{
+    (void)ctx;
+    (void)end;
+    (void)pattern;
+    return false;
+}
+
+// Determines if any pattern of `m` occurs in `str`
+static inline bool StringMatcher_Contains(const StringMatcher* m, const String* str)
+{
+    return !StrLib_MatcherScan(m, str, StrLib_OnAnyMatchStop, NULL);
+}
+
+/* ---- Allocators ---- */
+
+#define STRLIB_ARENA_ALIGN (_Alignof(max_align_t))
+
+typedef struct StringArenaBlock {
+    struct StringArenaBlock* next;
+    size_t size;
+    size_t used;
+    size_t last; // offset of the most recent allocation, so it can be grown or freed in place
+    _Alignas(max_align_t) char data[];
+} StringArenaBlock;
+
+// Bump allocator, allocations are carved out of large blocks and are all released at once by StringArena_Reset
+// Use with String_SetAllocator(&arena.base)
+// NOTE: Not thread-safe, String_Delete on arena allocated Strings is allowed but only reclaims the most recent allocation
+typedef struct {
+    StringAllocator base;
+    StringArenaBlock* blocks;
+    size_t block_size;
+    // every block sorted by address, so frees of pointers outside the head block find their owner in O(log n)
+    StringArenaBlock** index;
+    size_t index_len;
+    size_t index_cap;
+} StringArena;
+
+static inline size_t StrLib_AlignUp(size_t size, size_t align)
+{
+    return (size + align - 1) & ~(align - 1);
+}
+
+static inline bool StrLib_ArenaBlockOwns(const StringArenaBlock* block, const void* ptr)
+{
+    return (const char*)ptr >= block->data && (const char*)ptr < block->data + block->size;
+}
+
+// Returns the number of indexed blocks that start at or before `ptr`
+static inline size_t StrLib_ArenaIndexUpper(const StringArena* arena, const void* ptr)
+{
+    size_t lo = 0;
+    size_t hi = arena->index_len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((const char*)arena->index[mid] <= (const char*)ptr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static inline bool StrLib_ArenaIndexAdd(StringArena* arena, StringArenaBlock* block)
+{
+    if (arena->index_len == arena->index_cap) {
+        size_t cap = arena->index_cap ? arena->index_cap * 2 : 8;
+        StringArenaBlock** index = STRLIB_REALLOC(arena->index, cap * sizeof(*index));
+        if (!index) {
+            return false;
+        }
+
+        arena->index = index;
+        arena->index_cap = cap;
+    }
+
+    size_t pos = StrLib_ArenaIndexUpper(arena, block);
+    memmove(&arena->index[pos + 1], &arena->index[pos], (arena->index_len - pos) * sizeof(*arena->index));
+    arena->index[pos] = block;
+    arena->index_len++;
+    return true;
+}
+
+// Returns the block `ptr` was allocated from, or NULL if it wasn't allocated from `arena`
+static inline StringArenaBlock* StrLib_ArenaOwner(const StringArena* arena, const void* ptr)
+{
+    // most frees and reallocs are of recent allocations
+    StringArenaBlock* head = arena->blocks;
+    if (head && StrLib_ArenaBlockOwns(head, ptr)) {
+        return head;
+    }
+
+    size_t upper = StrLib_ArenaIndexUpper(arena, ptr);
+    if (upper == 0 || !StrLib_ArenaBlockOwns(arena->index[upper - 1], ptr)) {
+        return NULL;
+    }
+
+    return arena->index[upper - 1];
+}
+
+static inline void* StrLib_ArenaAlloc(StringAllocator* self, size_t size)
+{
+    StringArena* arena = (StringArena*)self;
+    size_t aligned = StrLib_AlignUp(size ? size : 1, STRLIB_ARENA_ALIGN);
+    StringArenaBlock* head = arena->blocks;
+
+    if (!head || head->size - head->used < aligned) {
+        // oversized allocations get a block of their own, behind the current one so its free space isn't wasted
+        size_t block_size = aligned > arena->block_size ? aligned : arena->block_size;
+        StringArenaBlock* block = STRLIB_MALLOC(sizeof(StringArenaBlock) + block_size);
+        if (!block) {
+            return NULL;
+        }
+
+        *block = (StringArenaBlock) { .size = block_size };
+        if (!StrLib_ArenaIndexAdd(arena, block)) {
+            STRLIB_FREE(block);
+            return NULL;
+        }
+
+        if (head && block_size > arena->block_size && head->size - head->used >= arena->block_size / 4) {
+            block->next = head->next;
+            head->next = block;
+            block->used = aligned;
+            return block->data;
+        }
+
+        block->next = head;
+        arena->blocks = head = block;
+    }
+
+    head->last = head->used;
+    head->used += aligned;
+    return &head->data[head->last];
+}
+
+static inline void StrLib_ArenaFree(StringAllocator* self, void* ptr)
+{
+    StringArena* arena = (StringArena*)self;
+    if (!ptr) {
+        return;
+    }
+
+    StringArenaBlock* block = StrLib_ArenaOwner(arena, ptr);
+    if (!block) {
+        STRLIB_FREE(ptr);
+    } else if (block == arena->blocks && (char*)ptr == &block->data[block->last]) {
+        block->used = block->last;
+    }
+}
+
+static inline void* StrLib_ArenaRealloc(StringAllocator* self, void* ptr, size_t old_size, size_t new_size)
+{
+    StringArena* arena = (StringArena*)self;
+    StringArenaBlock* head = arena->blocks;
+
+    // the most recent allocation can grow in place
+    if (head && (char*)ptr == &head->data[head->last]) {
+        size_t aligned = StrLib_AlignUp(new_size ? new_size : 1, STRLIB_ARENA_ALIGN);
+        if (head->size - head->last >= aligned) {
+            head->used = head->last + aligned;
+            return ptr;
+        }
+    }
+
+    if (!StrLib_ArenaOwner(arena, ptr)) {
+        return STRLIB_REALLOC(ptr, new_size);
+    }
+
+    void* ret = StrLib_ArenaAlloc(self, new_size);
+    if (ret) {
+        memcpy(ret, ptr, old_size < new_size ? old_size : new_size);
+    }
+
+    return ret;
+}
+
+// Creates an empty StringArena which allocates blocks of `block_size` bytes as needed
+static inline StringArena StringArena_New(size_t block_size)
+{
+    return (StringArena) {
+        .base = { .alloc = StrLib_ArenaAlloc, .realloc = StrLib_ArenaRealloc, .free = StrLib_ArenaFree },
+        .block_size = StrLib_AlignUp(block_size ? block_size : 1, STRLIB_ARENA_ALIGN),
+    };
+}
+
+// Releases everything allocated from `arena` at once, keeping one block for reuse
+// NOTE: invalidates every String allocated from `arena`
+static inline void StringArena_Reset(StringArena* arena)
+{
+    StringArenaBlock* keep = NULL;
+    StringArenaBlock* block = arena->blocks;
+    while (block) {
+        StringArenaBlock* next = block->next;
+        if (!keep && block->size == arena->block_size) {
+            keep = block;
+        } else {
+            STRLIB_FREE(block);
+        }
+        block = next;
+    }
+
+    arena->index_len = 0;
+    if (keep) {
+        *keep = (StringArenaBlock) { .size = keep->size };
+        arena->index[arena->index_len++] = keep;
+    }
+
+    arena->blocks = keep;
+}
+
+// Frees all memory owned by `arena`
+static inline void StringArena_Delete(StringArena* arena)
+{
+    StringArena_Reset(arena);
+    STRLIB_FREE(arena->blocks);
+    STRLIB_FREE(arena->index);
+    arena->blocks = NULL;
+    arena->index = NULL;
+    arena->index_len = 0;
+    arena->index_cap = 0;
+}
+
+// Allocator that serves allocations of up to `block_size` bytes from a fixed number of preallocated blocks, larger
+// allocations or allocations made once all blocks are in use fall back to the default allocator
+// Use with String_SetAllocator(&pool.base)
+// NOTE: Not thread-safe
+typedef struct {
+    StringAllocator base;
+    size_t block_size;
+    size_t block_count;
+    char* slab;
+    void* free_list;
+} StringPool;
+
+static inline bool StrLib_PoolOwns(const StringPool* pool, const void* ptr)
+{
+    return (const char*)ptr >= pool->slab && (const char*)ptr < pool->slab + pool->block_size * pool->block_count;
+}
+
+static inline void* StrLib_PoolAlloc(StringAllocator* self, size_t size)
+{
+    StringPool* pool = (StringPool*)self;
+    if (size > pool->block_size || !pool->free_list) {
+        return STRLIB_MALLOC(size);
+    }
+
+    void* ptr = pool->free_list;
+    memcpy(&pool->free_list, ptr, sizeof(void*));
+    return ptr;
+}
+
+static inline void StrLib_PoolFree(StringAllocator* self, void* ptr)
+{
+    StringPool* pool = (StringPool*)self;
+    if (!StrLib_PoolOwns(pool, ptr)) {
+        STRLIB_FREE(ptr);
+        return;
+    }
+
+    memcpy(ptr, &pool->free_list, sizeof(void*));
+    pool->free_list = ptr;
+}
+
+static inline void* StrLib_PoolRealloc(StringAllocator* self, void* ptr, size_t old_size, size_t new_size)
+{
+    StringPool* pool = (StringPool*)self;
+    if (!StrLib_PoolOwns(pool, ptr)) {
+        return STRLIB_REALLOC(ptr, new_size);
+    } else if (new_size <= pool->block_size) {
+        return ptr;
+    }
+
+    void* ret = STRLIB_MALLOC(new_size);
+    if (ret) {
+        memcpy(ret, ptr, old_size < new_size ? old_size : new_size);
+        StrLib_PoolFree(self, ptr);
+    }
+
+    return ret;
+}
+
+// Makes every block of `pool` available again
+// NOTE: invalidates every String allocated from the blocks of `pool`
+static inline void StringPool_Reset(StringPool* pool)
+{
+    pool->free_list = NULL;
+    for (size_t ii = pool->block_count; ii-- > 0;) {
+        void* block = &pool->slab[ii * pool->block_size];
+        memcpy(block, &pool->free_list, sizeof(void*));
+        pool->free_list = block;
+    }
+}
+
+// Creates a StringPool of `block_count` blocks that each serve allocations of up to `block_size` bytes
+// NOTE: requires a corresponding call to StringPool_Delete
+static inline StringPool StringPool_New(size_t block_size, size_t block_count)
+{
+    StringPool pool = {
+        .base = { .alloc = StrLib_PoolAlloc, .realloc = StrLib_PoolRealloc, .free = StrLib_PoolFree },
+        .block_size = StrLib_AlignUp(block_size < sizeof(void*) ? sizeof(void*) : block_size, _Alignof(max_align_t)),
+        .block_count = block_count,
+    };
+
+    pool.slab = STRLIB_MALLOC(pool.block_size * block_count);
+    assert(pool.slab);
+    StringPool_Reset(&pool);
+
+    return pool;
+}
+
+// Frees all memory owned by `pool`
+static inline void StringPool_Delete(StringPool* pool)
+{
+    STRLIB_FREE(pool->slab);
+    *pool = (StringPool) { 0 };
+}
+
+/* ---- Packed strings ---- */
+
+// Compact String representation for holding large numbers of strings: a single pointer to one allocation holding
+// the length (as a varint, 1 byte for lengths below 128) followed by the chars and a null terminator
+// NOTE: Zero-initialized StringPacked is a valid empty string, use StringPacked_View to pass it to the StringView
+// functions
+typedef struct {
+    unsigned char* mem;
+} StringPacked;
+
+// Creates a StringPacked copy of `view`
+// NOTE: requires a corresponding call to StringPacked_Delete, empty strings don't allocate
+static inline StringPacked StringPacked_FromView(StringView view)
+{
+    assert(view.len <= STRING_MAX_LEN);
+    if (view.len == 0) {
+        return (StringPacked) { 0 };
+    }
+
+    size_t header = 1;
+    while (7 * header < 8 * sizeof(size_t) && view.len >> (7 * header)) {
+        header += 1;
+    }
+
+    unsigned char* mem = StrLib_Alloc(header + view.len + 1);
+    for (size_t ii = 0; ii < header; ii++) {
+        mem[ii] = (unsigned char)((view.len >> (7 * ii)) & 0x7F) | (ii + 1 < header ? 0x80 : 0);
+    }
+    memcpy(mem + header, view.buf, view.len);
+    mem[header + view.len] = '\0';
+
+    return (StringPacked) { .mem = mem };
+}
+
+// Creates a StringPacked copy of `str`
+static inline StringPacked String_Pack(const String* str)
+{
+    STRLIB_STATS_SCOPE(String_Pack, str->len);
+    return StringPacked_FromView(String_View(str));
+}
+
+// Returns a StringView of the chars of `packed`
+static inline StringView StringPacked_View(StringPacked packed)
+{
+    if (!packed.mem) {
+        return (StringView) { .len = 0, .buf = "" };
+    }
+
+    size_t len = packed.mem[0] & 0x7F;
+    size_t header = 1;
+    while (packed.mem[header - 1] & 0x80) {
+        len |= (size_t)(packed.mem[header] & 0x7F) << (7 * header);
+        header += 1;
+    }
+
+    return (StringView) { .len = len, .buf = (const char*)packed.mem + header };
+}
+
+// Returns the length of `packed`
+static inline size_t StringPacked_Len(StringPacked packed)
+{
+    return StringPacked_View(packed).len;
+}
+
+// Returns the null-terminated chars of `packed`, valid until it is deleted
+static inline const char* StringPacked_CStr(StringPacked packed)
+{
+    return StringPacked_View(packed).buf;
+}
+
+// Makes a String copy of `packed`
+static inline String StringPacked_Unpack(StringPacked packed)
+{
+    return String_FromView(StringPacked_View(packed));
+}
+
+// Frees a StringPacked
+static inline void StringPacked_Delete(StringPacked* packed)
+{
+    StrLib_Free(packed->mem);
+    *packed = (StringPacked) { 0 };
+}
+
+/* ---- Hashing ---- */
+
+// wyhash (https://github.com/wangyi-fudan/wyhash), hashes 48 bytes per iteration with 64x64 -> 128 bit multiplies
+// NOTE: hash values depend on the byte order of the target, so they shouldn't be stored or sent between machines
+
+static const uint64_t strlib_hash_secret[4] = {
+    0x2d358dccaa6c78a5ull,
+    0x8bb84b93962eacc9ull,
+    0x4b33a62ed433d4a3ull,
+    0x4d5a2da51de1aa47ull,
+};
+
+// Replaces `a` and `b` with the low and high halves of their 128 bit product
+static inline void StrLib_HashMum(uint64_t* a, uint64_t* b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t StrLib_HashMix(uint64_t a, uint64_t b)
+{
+    StrLib_HashMum(&a, &b);
+    return a ^ b;
+}
+
+// Hashes `len` bytes at `data`, different seeds give independent hash functions
+static inline uint64_t StrLib_Hash(const void* data, size_t len, uint64_t seed)
+{
+    const uint64_t* s = strlib_hash_secret;
+    const unsigned char* p = data;
+    uint64_t a, b;
+
+    seed ^= StrLib_HashMix(seed ^ s[0], s[1]);
+    if (len <= 16) {
+        if (len >= 4) {
+            size_t mid = (len >> 3) << 2;
+            a = (StrLib_Read4(p) << 32) | StrLib_Read4(p + mid);
+            b = (StrLib_Read4(p + len - 4) << 32) | StrLib_Read4(p + len - 4 - mid);
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t left = len;
+        if (left > 48) {
+            uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed = StrLib_HashMix(StrLib_Read8(p) ^ s[1], StrLib_Read8(p + 8) ^ seed);
+                seed1 = StrLib_HashMix(StrLib_Read8(p + 16) ^ s[2], StrLib_Read8(p + 24) ^ seed1);
+                seed2 = StrLib_HashMix(StrLib_Read8(p + 32) ^ s[3], StrLib_Read8(p + 40) ^ seed2);
+                p += 48;
+                left -= 48;
+            } while (left > 48);
+            seed ^= seed1 ^ seed2;
+        }
+
+        while (left > 16) {
+            seed = StrLib_HashMix(StrLib_Read8(p) ^ s[1], StrLib_Read8(p + 8) ^ seed);
+            p += 16;
+            left -= 16;
+        }
+
+        a = StrLib_Read8(p + left - 16);
+        b = StrLib_Read8(p + left - 8);
+    }
+
+    a ^= s[1];
+    b ^= seed;
+    StrLib_HashMum(&a, &b);
+    return StrLib_HashMix(a ^ s[0] ^ len, b ^ s[1]);
+}
+
+// Hashes the chars of `view`, different seeds give independent hash functions
+static inline uint64_t StringView_Hash(StringView view, uint64_t seed)
+{
+    return StrLib_Hash(view.buf, view.len, seed);
+}
+
+// Hashes the chars of `str`, equal Strings have equal hashes
+static inline uint64_t String_Hash(const String* str, uint64_t seed)
+{
+    STRLIB_STATS_SCOPE(String_Hash, str->len);
+    return StrLib_Hash(String_Buf(str), str->len, seed);
+}
+
+/* ---- Hash map ---- */
+
+// Open-addressing hash map from String keys to pointers, laid out like SwissTable: each slot has a control byte
+// holding 7 bits of its key's hash (or marking it empty/deleted), lookups check a group of STRLIB_MAP_GROUP control
+// bytes at a time (with a single SSE2 compare) and only compare keys whose control byte matches
+// Groups are probed quadratically, and the table grows once 7/8 of its slots are in use
+#define STRLIB_MAP_GROUP 16
+#define STRLIB_MAP_EMPTY 0x80
+#define STRLIB_MAP_DELETED 0xFE
+
+typedef struct {
+    String key;
+    void* value;
+} StringMapEntry;
+
+// NOTE: Zero-initialized StringMap is a valid empty map (with seed 0), use it as a set by leaving values NULL
+typedef struct {
+    StringMapEntry* entries;
+    unsigned char* ctrl;
+    size_t capacity;    // 0 or a power of two multiple of STRLIB_MAP_GROUP
+    size_t len;         // number of entries
+    size_t growth_left; // number of empty slots that can be filled before the table has to grow
+    uint64_t seed;
+} StringMap;
+
+static inline unsigned StrLib_LowestBit(unsigned mask)
+{
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctz(mask);
+#else
+    unsigned bit = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        bit += 1;
+    }
+    return bit;
+#endif
+}
+
+// Returns a bitmask of the control bytes of the group at `ctrl` equal to `byte`
+static inline unsigned StrLib_MapMatch(const unsigned char* ctrl, unsigned char byte)
+{
+#if STRLIB_X86_SIMD
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)byte)));
+#else
+    unsigned mask = 0;
+    for (unsigned ii = 0; ii < STRLIB_MAP_GROUP; ii++) {
+        mask |= (unsigned)(ctrl[ii] == byte) << ii;
+    }
+    return mask;
+#endif
+}
+
+// Returns a bitmask of the empty or deleted slots of the group at `ctrl`
+static inline unsigned StrLib_MapMatchFree(const unsigned char* ctrl)
+{
+#if STRLIB_X86_SIMD
+    return (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+    unsigned mask = 0;
+    for (unsigned ii = 0; ii < STRLIB_MAP_GROUP; ii++) {
+        mask |= (unsigned)(ctrl[ii] >> 7) << ii;
+    }
+    return mask;
+#endif
+}
+
+static inline size_t StrLib_MapFirstGroup(const StringMap* map, uint64_t hash)
+{
+    return (size_t)(hash >> 7) & (map->capacity - 1) & ~(size_t)(STRLIB_MAP_GROUP - 1);
+}
+
+// Finds the slot holding `key`, returns -1 if there is none
+static inline ssize_t StrLib_MapFind(const StringMap* map, StringView key, uint64_t hash)
+{
+    if (!map->capacity) {
+        return -1;
+    }
+
+    size_t group = StrLib_MapFirstGroup(map, hash);
+    for (size_t step = STRLIB_MAP_GROUP;; step += STRLIB_MAP_GROUP) {
+        unsigned match = StrLib_MapMatch(&map->ctrl[group], (unsigned char)(hash & 0x7F));
+        while (match) {
+            size_t slot = group + StrLib_LowestBit(match);
+            if (StringView_Equal(String_View(&map->entries[slot].key), key)) {
+                return (ssize_t)slot;
+            }
+            match &= match - 1;
+        }
+
+        // keys are inserted in the first group with room, so they can't be past a group with an empty slot
+        if (StrLib_MapMatch(&map->ctrl[group], STRLIB_MAP_EMPTY)) {
+            return -1;
+        }
+
+        group = (group + step) & (map->capacity - 1);
+    }
+}
+
+// Finds the first empty or deleted slot in the probe sequence of `hash`
+static inline size_t StrLib_MapFindFree(const StringMap* map, uint64_t hash)
+{
+    size_t group = StrLib_MapFirstGroup(map, hash);
+    for (size_t step = STRLIB_MAP_GROUP;; step += STRLIB_MAP_GROUP) {
+        unsigned avail = StrLib_MapMatchFree(&map->ctrl[group]);
+        if (avail) {
+            return group + StrLib_LowestBit(avail);
+        }
+
+        group = (group + step) & (map->capacity - 1);
+    }
+}
+
+// Allocates empty slots for `capacity` entries (a power of two multiple of STRLIB_MAP_GROUP)
+static inline void StrLib_MapAlloc(StringMap* map, size_t capacity)
+{
+    char* mem = StrLib_Alloc(capacity * sizeof(StringMapEntry) + capacity);
+    map->entries = (StringMapEntry*)mem;
+    map->ctrl = (unsigned char*)mem + capacity * sizeof(StringMapEntry);
+    memset(map->ctrl, STRLIB_MAP_EMPTY, capacity);
+    map->capacity = capacity;
+    map->growth_left = capacity - capacity / 8 - map->len;
+}
+
+// Moves the entries of `map` to new slots, doubling the capacity unless deleted slots take up most of the space
+STRLIB_NOINLINE static void StrLib_MapRehash(StringMap* map)
+{
+    StringMap old = *map;
+    size_t capacity = old.capacity ? old.capacity : STRLIB_MAP_GROUP;
+    if (old.len >= capacity / 2 - capacity / 16) {
+        capacity *= 2;
+    }
+
+    StrLib_MapAlloc(map, capacity);
+    for (size_t ii = 0; ii < old.capacity; ii++) {
+        if (!(old.ctrl[ii] & 0x80)) {
+            uint64_t hash = String_Hash(&old.entries[ii].key, map->seed);
+            size_t slot = StrLib_MapFindFree(map, hash);
+            map->ctrl[slot] = (unsigned char)(hash & 0x7F);
+            map->entries[slot] = old.entries[ii];
+        }
+    }
+
+    if (old.capacity) {
+        StrLib_Free(old.entries);
+    }
+}
+
+// Inserts an entry for `key` (which isn't in `map`) with a NULL value, `map` takes ownership of `key`
+static inline StringMapEntry* StrLib_MapInsert(StringMap* map, String key, uint64_t hash)
+{
+    size_t slot = map->capacity ? StrLib_MapFindFree(map, hash) : 0;
+    if (!map->capacity || (map->growth_left == 0 && map->ctrl[slot] == STRLIB_MAP_EMPTY)) {
+        StrLib_MapRehash(map);
+        slot = StrLib_MapFindFree(map, hash);
+    }
+
+    map->growth_left -= map->ctrl[slot] == STRLIB_MAP_EMPTY;
+    map->ctrl[slot] = (unsigned char)(hash & 0x7F);
+    map->entries[slot] = (StringMapEntry) { .key = key, .value = NULL };
+    map->len += 1;
+
+    return &map->entries[slot];
+}
+
+// Creates a StringMap with room for `capacity` entries before it has to grow, hashing keys with `seed`
+// NOTE: requires a corresponding call to StringMap_Delete, seeding with a random value guards against inputs crafted to
+// collide
+static inline StringMap StringMap_New(size_t capacity, uint64_t seed)
+{
+    StringMap map = { .seed = seed };
+    if (capacity) {
+        size_t slots = STRLIB_MAP_GROUP;
+        while (slots - slots / 8 < capacity) {
+            slots *= 2;
+        }
+        StrLib_MapAlloc(&map, slots);
+    }
+
+    return map;
+}
+
+// Returns the entry for `key`, or NULL if there is none
+// NOTE: Entry pointers are invalidated by inserting into or removing from the map
+static inline StringMapEntry* StringMap_Find(const StringMap* map, StringView key)
+{
+    ssize_t slot = StrLib_MapFind(map, key, StringView_Hash(key, map->seed));
+    return slot < 0 ? NULL : &map->entries[slot];
+}
+
+// Returns the value for `key`, or NULL if there is none
+static inline void* StringMap_Get(const StringMap* map, StringView key)
+{
+    StringMapEntry* entry = StringMap_Find(map, key);
+    return entry ? entry->value : NULL;
+}
+
+// Determines if `map` has an entry for `key`
+static inline bool StringMap_Contains(const StringMap* map, StringView key)
+{
+    return StringMap_Find(map, key) != NULL;
+}
+
+// Returns the entry for `key`, first inserting one with a copy of `key` and a NULL value if there is none
+// `inserted` (if not NULL) is set to whether the entry was inserted
+// NOTE: Entry pointers are invalidated by inserting into or removing from the map
+static inline StringMapEntry* StringMap_Upsert(StringMap* map, StringView key, bool* inserted)
+{
+    uint64_t hash = StringView_Hash(key, map->seed);
+    ssize_t found = StrLib_MapFind(map, key, hash);
+    if (inserted) {
+        *inserted = found < 0;
+    }
+    if (found >= 0) {
+        return &map->entries[found];
+    }
+
+    return StrLib_MapInsert(map, String_FromView(key), hash);
+}
+
+// Sets the value for `key` to `value`, returns true if `key` wasn't in `map` before
+static inline bool StringMap_Set(StringMap* map, StringView key, void* value)
+{
+    bool inserted;
+    StringMap_Upsert(map, key, &inserted)->value = value;
+    return inserted;
+}
+
+// Removes the entry for `key`, returns false if there is none
+static inline bool StringMap_Remove(StringMap* map, StringView key)
+{
+    ssize_t found = StrLib_MapFind(map, key, StringView_Hash(key, map->seed));
+    if (found < 0) {
+        return false;
+    }
+
+    size_t slot = (size_t)found;
+    String_Delete(&map->entries[slot].key);
+    // probes stop at a group with an empty slot, so the slot can only be marked empty if its group already has one
+    if (StrLib_MapMatch(&map->ctrl[slot & ~(size_t)(STRLIB_MAP_GROUP - 1)], STRLIB_MAP_EMPTY)) {
+        map->ctrl[slot] = STRLIB_MAP_EMPTY;
+        map->growth_left += 1;
+    } else {
+        map->ctrl[slot] = STRLIB_MAP_DELETED;
+    }
+    map->len -= 1;
+
+    return true;
+}
+
+// Returns the next entry of `map` at or after index `*pos` and advances `*pos` past it, NULL once there are no more
+// Start iterating with `*pos` = 0, the order is unspecified
+static inline StringMapEntry* StringMap_Next(const StringMap* map, size_t* pos)
+{
+    for (; *pos < map->capacity; *pos += 1) {
+        if (!(map->ctrl[*pos] & 0x80)) {
+            *pos += 1;
+            return &map->entries[*pos - 1];
+        }
+    }
+
+    return NULL;
+}
+
+// Removes every entry of `map`, keeping its capacity
+static inline void StringMap_Clear(StringMap* map)
+{
+    for (size_t ii = 0; ii < map->capacity; ii++) {
+        if (!(map->ctrl[ii] & 0x80)) {
+            String_Delete(&map->entries[ii].key);
+        }
+    }
+
+    if (map->capacity) {
+        memset(map->ctrl, STRLIB_MAP_EMPTY, map->capacity);
+    }
+    map->len = 0;
+    map->growth_left = map->capacity - map->capacity / 8;
+}
+
+// Frees a StringMap and its keys
+// NOTE: values aren't freed, iterate over the map with StringMap_Next first if they need to be
+static inline void StringMap_Delete(StringMap* map)
+{
+    StringMap_Clear(map);
+    if (map->capacity) {
+        StrLib_Free(map->entries);
+    }
+    *map = (StringMap) { 0 };
+}
+
+/* ---- Interning ---- */
+
+// Interns Strings: every distinct content is stored once, as a canonical String that all equal Strings map to, so
+// interned Strings can be compared by pointer. Canonical Strings are stored in chunks of STRLIB_INTERN_CHUNK, so they
+// never move, and are looked up through a StringMap whose keys alias them
+#define STRLIB_INTERN_CHUNK 1024
+
+// Number of Strings StringInterner_InternList hashes ahead of looking them up
+#define STRLIB_INTERN_BATCH 16
+
+// NOTE: Interned Strings are valid until StringInterner_Delete and must not be deleted by the caller
+typedef struct {
+    StringMap map; // keys alias the canonical Strings, values point to them
+    String** chunks;
+    size_t chunk_count;
+    size_t len; // number of distinct Strings
+#if !defined(__STDC_NO_THREADS__)
+    mtx_t* lock; // NULL unless thread-safe
+#endif
+} StringInterner;
+
+// Creates a StringInterner, hashing with `seed`. If `thread_safe`, it may be used from several threads at once
+// NOTE: requires a corresponding call to StringInterner_Delete, in thread-safe mode every thread using it must use the
+// same allocator (see String_SetAllocator)
+static inline StringInterner StringInterner_New(uint64_t seed, bool thread_safe)
+{
+    StringInterner in = { .map = StringMap_New(0, seed) };
+#if !defined(__STDC_NO_THREADS__)
+    if (thread_safe) {
+        in.lock = StrLib_Alloc(sizeof(mtx_t));
+        int ok = mtx_init(in.lock, mtx_plain);
+        assert(ok == thrd_success);
+        (void)ok;
+    }
+#else
+    assert(!thread_safe);
+    (void)thread_safe;
+#endif
+
+    return in;
+}
+
+static inline void StrLib_InternLock(StringInterner* in)
+{
+#if !defined(__STDC_NO_THREADS__)
+    if (in->lock) {
+        mtx_lock(in->lock);
+    }
+#else
+    (void)in;
+#endif
+}
+
+static inline void StrLib_InternUnlock(StringInterner* in)
+{
+#if !defined(__STDC_NO_THREADS__)
+    if (in->lock) {
+        mtx_unlock(in->lock);
+    }
+#else
+    (void)in;
+#endif
+}
+
+// Returns the canonical String for `view` with hash `hash`, creating it if `insert`, or NULL
+static inline const String* StrLib_Intern(StringInterner* in, StringView view, uint64_t hash, bool insert)
+{
+    ssize_t slot = StrLib_MapFind(&in->map, view, hash);
+    if (slot >= 0) {
+        return in->map.entries[slot].value;
+    } else if (!insert) {
+        return NULL;
+    }
+
+    if (in->len == in->chunk_count * STRLIB_INTERN_CHUNK) {
+        if ((in->chunk_count & (in->chunk_count - 1)) == 0) {
+            size_t cap = in->chunk_count ? 2 * in->chunk_count : 1;
+            String** chunks = StrLib_Alloc(cap * sizeof(String*));
+            if (in->chunks) {
+                memcpy(chunks, in->chunks, in->chunk_count * sizeof(String*));
+                StrLib_Free(in->chunks);
+            }
+            in->chunks = chunks;
+        }
+        in->chunks[in->chunk_count] = StrLib_Alloc(STRLIB_INTERN_CHUNK * sizeof(String));
+        in->chunk_count += 1;
+    }
+
+    String* canon = &in->chunks[in->len / STRLIB_INTERN_CHUNK][in->len % STRLIB_INTERN_CHUNK];
+    *canon = String_FromView(view);
+    in->len += 1;
+    StrLib_MapInsert(&in->map, StringView_AsString(String_View(canon)), hash)->value = canon;
+
+    return canon;
+}
+
+// Returns the canonical String equal to `view`, creating it if there is none yet
+// NOTE: Interned Strings are equal exactly when their pointers are
+static inline const String* StringInterner_Intern(StringInterner* in, StringView view)
+{
+    uint64_t hash = StringView_Hash(view, in->map.seed);
+    StrLib_InternLock(in);
+    const String* canon = StrLib_Intern(in, view, hash, true);
+    StrLib_InternUnlock(in);
+
+    return canon;
+}
+
+// Returns the canonical String equal to `view`, or NULL if it hasn't been interned
+static inline const String* StringInterner_Find(StringInterner* in, StringView view)
+{
+    uint64_t hash = StringView_Hash(view, in->map.seed);
+    StrLib_InternLock(in);
+    const String* canon = StrLib_Intern(in, view, hash, false);
+    StrLib_InternUnlock(in);
+
+    return canon;
+}
+
+// Interns every String of `list`, storing the canonical Strings in `out` (which has room for `list->len`)
+// Hashes are computed in batches ahead of the lookups so the table memory they touch can be prefetched, and the lock is
+// only taken once
+static inline void StringInterner_InternList(StringInterner* in, const StringList* list, const String** out)
+{
+    uint64_t hashes[STRLIB_INTERN_BATCH];
+
+    StrLib_InternLock(in);
+    for (size_t base = 0; base < list->len; base += STRLIB_INTERN_BATCH) {
+        size_t count = list->len - base < STRLIB_INTERN_BATCH ? list->len - base : STRLIB_INTERN_BATCH;
+        for (size_t ii = 0; ii < count; ii++) {
+            hashes[ii] = String_Hash(&list->str[base + ii], in->map.seed);
+            if (in->map.capacity) {
+                STRLIB_PREFETCH(&in->map.ctrl[StrLib_MapFirstGroup(&in->map, hashes[ii])]);
+            }
+        }
+
+        for (size_t ii = 0; ii < count; ii++) {
+            out[base + ii] = StrLib_Intern(in, String_View(&list->str[base + ii]), hashes[ii], true);
+        }
+    }
+    StrLib_InternUnlock(in);
+}
+
+// Frees a StringInterner and all of its Strings
+static inline void StringInterner_Delete(StringInterner* in)
+{
+    // the map's keys alias the canonical Strings, so only its slots are freed
+    if (in->map.capacity) {
+        StrLib_Free(in->map.entries);
+    }
+
+    for (size_t ii = 0; ii < in->len; ii++) {
+        String_Delete(&in->chunks[ii / STRLIB_INTERN_CHUNK][ii % STRLIB_INTERN_CHUNK]);
+    }
+    for (size_t ii = 0; ii < in->chunk_count; ii++) {
+        StrLib_Free(in->chunks[ii]);
+    }
+    StrLib_Free(in->chunks);
+
+#if !defined(__STDC_NO_THREADS__)
+    if (in->lock) {
+        mtx_destroy(in->lock);
+        StrLib_Free(in->lock);
+    }
+#endif
+    *in = (StringInterner) { 0 };
+}
+
+/* ---- Parallel operations ---- */
+
+#if !defined(__STDC_NO_THREADS__) && !defined(__STDC_NO_ATOMICS__)
+// Number of bytes searched per task by the parallel String operations, inputs shorter than two chunks are searched
+// on the calling thread
+#ifndef STRLIB_PARALLEL_CHUNK
+#define STRLIB_PARALLEL_CHUNK (1 << 20)
+#endif
+
+// Number of elements handled per task by the parallel StringList operations
+#ifndef STRLIB_PARALLEL_BLOCK
+#define STRLIB_PARALLEL_BLOCK 4096
+#endif
+
+typedef void StrLib_TaskFn(void* ctx, size_t task);
+
+typedef struct {
+    mtx_t lock;
+    cnd_t wake; // signaled when a job is posted or the pool stops
+    cnd_t done; // signaled when the last worker finishes a job
+    StrLib_TaskFn* fn;
+    void* ctx;
+    size_t tasks;
+    atomic_size_t next; // next task to be claimed
+    size_t active;      // workers still working on the current job
+    uint64_t job;       // incremented for each job
+    bool stop;
+    size_t worker_count;
+    thrd_t workers[];
+} StrLib_ThreadPoolShared;
+
+// Threads that parallel operations split their work across, the calling thread takes part as well
+// NOTE: Runs one operation at a time, and workers allocate from the default allocator, not String_SetAllocator's
+typedef struct {
+    StrLib_ThreadPoolShared* shared; // NULL if the pool has no workers, everything then runs on the calling thread
+} StringThreadPool;
+
+// Runs tasks of the current job until none are left
+static inline void StrLib_PoolWork(StrLib_ThreadPoolShared* shared, StrLib_TaskFn* fn, void* ctx, size_t tasks)
+{
+    for (size_t task; (task = atomic_fetch_add_explicit(&shared->next, 1, memory_order_relaxed)) < tasks;) {
+        fn(ctx, task);
+    }
+}
+
+static inline int StrLib_PoolWorker(void* arg)
+{
+    StrLib_ThreadPoolShared* shared = arg;
+    uint64_t seen = 0;
+
+    mtx_lock(&shared->lock);
+    while (true) {
+        while (!shared->stop && shared->job == seen) {
+            cnd_wait(&shared->wake, &shared->lock);
+        }
+        if (shared->stop) {
+            break;
+        }
+
+        seen = shared->job;
+        StrLib_TaskFn* fn = shared->fn;
+        void* ctx = shared->ctx;
+        size_t tasks = shared->tasks;
+        mtx_unlock(&shared->lock);
+
+        StrLib_PoolWork(shared, fn, ctx, tasks);
+
+        mtx_lock(&shared->lock);
+        if (--shared->active == 0) {
+            cnd_signal(&shared->done);
+        }
+    }
+    mtx_unlock(&shared->lock);
+
+    return 0;
+}
+
+// Runs fn(ctx, task) for every task in [0, `tasks`) across the pool, returns once all of them have finished
+static inline void StrLib_PoolRun(const StringThreadPool* pool, size_t tasks, StrLib_TaskFn* fn, void* ctx)
+{
+    StrLib_ThreadPoolShared* shared = pool ? pool->shared : NULL;
+    if (!shared || tasks <= 1) {
+        for (size_t ii = 0; ii < tasks; ii++) {
+            fn(ctx, ii);
+        }
+        return;
+    }
+
+    mtx_lock(&shared->lock);
+    shared->fn = fn;
+    shared->ctx = ctx;
+    shared->tasks = tasks;
+    atomic_store_explicit(&shared->next, 0, memory_order_relaxed);
+    shared->active = shared->worker_count;
+    shared->job += 1;
+    cnd_broadcast(&shared->wake);
+    mtx_unlock(&shared->lock);
+
+    StrLib_PoolWork(shared, fn, ctx, tasks);
+
+    mtx_lock(&shared->lock);
+    while (shared->active) {
+        cnd_wait(&shared->done, &shared->lock);
+    }
+    mtx_unlock(&shared->lock);
+}
+
+// Creates a pool of `threads` threads (including the calling thread), 0 uses one thread per online CPU
+static inline StringThreadPool StringThreadPool_New(size_t threads)
+{
+    if (!threads) {
+#if STRLIB_POSIX
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+#else
+        threads = 1;
+#endif
+    }
+
+    if (threads <= 1) {
+        return (StringThreadPool) { 0 };
+    }
+
+    StrLib_ThreadPoolShared* shared = StrLib_Alloc(sizeof(StrLib_ThreadPoolShared) + (threads - 1) * sizeof(thrd_t));
+    int ok = mtx_init(&shared->lock, mtx_plain);
+    ok |= cnd_init(&shared->wake);
+    ok |= cnd_init(&shared->done);
+    assert(ok == thrd_success);
+    atomic_init(&shared->next, 0);
+    shared->job = 0;
+    shared->active = 0;
+    shared->stop = false;
+    shared->worker_count = 0;
+
+    for (size_t ii = 0; ii < threads - 1; ii++) {
+        if (thrd_create(&shared->workers[ii], StrLib_PoolWorker, shared) != thrd_success) {
+            break;
+        }
+        shared->worker_count += 1;
+    }
+
+    return (StringThreadPool) { .shared = shared };
+}
+
+// Returns the number of threads work is split across, including the calling thread
+static inline size_t StringThreadPool_Threads(const StringThreadPool* pool)
+{
+    return pool->shared ? pool->shared->worker_count + 1 : 1;
+}
+
+// Stops and joins the threads of `pool`
+static inline void StringThreadPool_Delete(StringThreadPool* pool)
+{
+    StrLib_ThreadPoolShared* shared = pool->shared;
+    if (!shared) {
+        return;
+    }
+
+    mtx_lock(&shared->lock);
+    shared->stop = true;
+    cnd_broadcast(&shared->wake);
+    mtx_unlock(&shared->lock);
+
+    for (size_t ii = 0; ii < shared->worker_count; ii++) {
+        thrd_join(shared->workers[ii], NULL);
+    }
+
+    mtx_destroy(&shared->lock);
+    cnd_destroy(&shared->wake);
+    cnd_destroy(&shared->done);
+    StrLib_Free(shared);
+    *pool = (StringThreadPool) { 0 };
+}
+
+// Matches of a substring starting within one chunk of the input
+typedef struct {
+    size_t count;
+    size_t first;  // start of the first match, SIZE_MAX if there is none
+    size_t second; // start of the second match, SIZE_MAX if there is none
+    size_t resume; // position after the last match
+} StrLib_ChunkMatches;
+
+// Finds the matches of `needle` starting in hay[from, end), overlapping or leftmost non-overlapping ones starting
+// from `from`
+static inline StrLib_ChunkMatches
+StrLib_ScanChunk(const char* hay, size_t n, const char* needle, size_t m, size_t from, size_t end, bool overlapping)
+{
+    StrLib_ChunkMatches ret = { .first = SIZE_MAX, .second = SIZE_MAX, .resume = from };
+    size_t limit = end + m - 1 < n ? end + m - 1 : n;
+
+    ssize_t found;
+    for (size_t pos = from; pos < end && (found = StrLib_FindFirst(&hay[pos], limit - pos, needle, m)) >= 0;) {
+        pos += (size_t)found;
+        if (ret.count == 0) {
+            ret.first = pos;
+        } else if (ret.count == 1) {
+            ret.second = pos;
+        }
+
+        ret.count += 1;
+        pos += overlapping ? 1 : m;
+        ret.resume = pos;
+    }
+
+    return ret;
+}
+
+typedef struct {
+    const char* hay;
+    size_t n;
+    const char* needle;
+    size_t m;
+    bool overlapping;
+    StrLib_ChunkMatches* chunks;
+    atomic_size_t first;    // leftmost match found so far, for String_ParallelFirstOccurrenceOf
+    size_t* starts;         // where the leftmost non-overlapping matches of each chunk start from
+    size_t* before;         // number of matches before each chunk
+    const String* new;      // replacement, for String_ParallelReplace
+    char* dst;
+} StrLib_ParallelSearch;
+
+static inline size_t StrLib_ChunkEnd(const StrLib_ParallelSearch* search, size_t task)
+{
+    size_t end = (task + 1) * STRLIB_PARALLEL_CHUNK;
+    return end < search->n ? end : search->n;
+}
+
+static inline void StrLib_CountTask(void* ctx, size_t task)
+{
+    StrLib_ParallelSearch* search = ctx;
+    search->chunks[task] = StrLib_ScanChunk(
+        search->hay,
+        search->n,
+        search->needle,
+        search->m,
+        task * STRLIB_PARALLEL_CHUNK,
+        StrLib_ChunkEnd(search, task),
+        search->overlapping);
+}
+
+// Counts matches in every chunk in parallel, for non-overlapping matches each chunk starts from its beginning and
+// is then corrected serially for the match that may straddle into it from the previous chunk
+// returns the total number of matches, records where each chunk's matches start from and the matches before it
+static inline size_t StrLib_ParallelCount(const StringThreadPool* pool, StrLib_ParallelSearch* search)
+{
+    size_t tasks = (search->n + STRLIB_PARALLEL_CHUNK - 1) / STRLIB_PARALLEL_CHUNK;
+    StrLib_PoolRun(pool, tasks, StrLib_CountTask, search);
+
+    size_t total = 0;
+    size_t resume = 0;
+    for (size_t ii = 0; ii < tasks; ii++) {
+        size_t start = ii * STRLIB_PARALLEL_CHUNK;
+        StrLib_ChunkMatches* chunk = &search->chunks[ii];
+        if (!search->overlapping && resume > start) {
+            start = resume;
+            if (chunk->first < resume) {
+                // the first match overlaps the previous chunk's last match, the rest of the chunk is unaffected if
+                // the next match from `resume` on is the chunk's second one (always true unless matches overlap)
+                size_t end = StrLib_ChunkEnd(search, ii);
+                size_t limit = end + search->m - 1 < search->n ? end + search->m - 1 : search->n;
+                ssize_t found = StrLib_FindFirst(&search->hay[resume], limit - resume, search->needle, search->m);
+                size_t next = found >= 0 && resume + (size_t)found < end ? resume + (size_t)found : SIZE_MAX;
+                if (next == chunk->second) {
+                    chunk->count -= 1;
+                } else {
+                    *chunk = StrLib_ScanChunk(search->hay, search->n, search->needle, search->m, resume, end, false);
+                }
+            }
+        }
+
+        if (search->starts) {
+            search->starts[ii] = start;
+            search->before[ii] = total;
+        }
+        total += chunk->count;
+        resume = chunk->count ? chunk->resume : start;
+    }
+
+    return total;
+}
+
+// Counts the instances of `substr` in `str` like String_InstancesOf, splitting the search across `pool`
+static inline size_t String_ParallelInstancesOf(const StringThreadPool* pool, const String* str, const String* substr)
+{
+    if (str->len < 2 * STRLIB_PARALLEL_CHUNK || substr->len == 0 || substr->len > STRLIB_PARALLEL_CHUNK) {
+        return String_InstancesOf(str, substr);
+    }
+
+    size_t tasks = (str->len + STRLIB_PARALLEL_CHUNK - 1) / STRLIB_PARALLEL_CHUNK;
+    StrLib_ParallelSearch search = {
+        .hay = String_Buf(str),
+        .n = str->len,
+        .needle = String_Buf(substr),
+        .m = substr->len,
+        .overlapping = true,
+        .chunks = StrLib_Alloc(tasks * sizeof(StrLib_ChunkMatches)),
+    };
+    size_t count = StrLib_ParallelCount(pool, &search);
+    StrLib_Free(search.chunks);
+
+    return count;
+}
+
+// Counts the distinct instances of `substr` in `str` like String_DistinctInstancesOf, splitting the search across
+// `pool`
+// NOTE: Chunks are corrected serially when a match straddles their start, which rescans a chunk if matches overlap
+// each other across it (e.g. "aa" in "aaaa...")
+static inline size_t String_ParallelDistinctInstancesOf(const StringThreadPool* pool, const String* str, const String* substr)
+{
+    if (str->len < 2 * STRLIB_PARALLEL_CHUNK || substr->len == 0 || substr->len > STRLIB_PARALLEL_CHUNK) {
+        return String_DistinctInstancesOf(str, substr);
+    }
+
+    size_t tasks = (str->len + STRLIB_PARALLEL_CHUNK - 1) / STRLIB_PARALLEL_CHUNK;
+    StrLib_ParallelSearch search = {
+        .hay = String_Buf(str),
+        .n = str->len,
+        .needle = String_Buf(substr),
+        .m = substr->len,
+        .chunks = StrLib_Alloc(tasks * sizeof(StrLib_ChunkMatches)),
+    };
+    size_t count = StrLib_ParallelCount(pool, &search);
+    StrLib_Free(search.chunks);
+
+    return count;
+}
+
+static inline void StrLib_FirstTask(void* ctx, size_t task)
+{
+    StrLib_ParallelSearch* search = ctx;
+    size_t start = task * STRLIB_PARALLEL_CHUNK;
+    size_t best = atomic_load_explicit(&search->first, memory_order_relaxed);
+    if (best < start) {
+        return;
+    }
+
+    size_t end = StrLib_ChunkEnd(search, task);
+    size_t limit = end + search->m - 1 < search->n ? end + search->m - 1 : search->n;
+    ssize_t found = StrLib_FindFirst(&search->hay[start], limit - start, search->needle, search->m);
+    if (found < 0) {
+        return;
+    }
+
+    size_t pos = start + (size_t)found;
+    while (pos < best && !atomic_compare_exchange_weak(&search->first, &best, pos)) {
+    }
+}
+
+// Finds the index of the first occurrence of `substr` in `str` like String_FirstOccurrenceOf, splitting the search
+// across `pool`, chunks after the first match found are skipped
+static inline ssize_t String_ParallelFirstOccurrenceOf(const StringThreadPool* pool, const String* str, const String* substr)
+{
+    if (str->len < 2 * STRLIB_PARALLEL_CHUNK || substr->len == 0 || substr->len > STRLIB_PARALLEL_CHUNK) {
+        return String_FirstOccurrenceOf(str, substr);
+    }
+
+    StrLib_ParallelSearch search = {
+        .hay = String_Buf(str),
+        .n = str->len,
+        .needle = String_Buf(substr),
+        .m = substr->len,
+    };
+    atomic_init(&search.first, SIZE_MAX);
+    StrLib_PoolRun(pool, (str->len + STRLIB_PARALLEL_CHUNK - 1) / STRLIB_PARALLEL_CHUNK, StrLib_FirstTask, &search);
+
+    size_t first = atomic_load(&search.first);
+    return first == SIZE_MAX ? -1 : (ssize_t)first;
+}
+
+// Writes the replaced chars of one chunk, from where its matches start up to where the next chunk's start
+static inline void StrLib_ReplaceTask(void* ctx, size_t task)
+{
+    StrLib_ParallelSearch* search = ctx;
+    size_t tasks = (search->n + STRLIB_PARALLEL_CHUNK - 1) / STRLIB_PARALLEL_CHUNK;
+    size_t src_pos = search->starts[task];
+    size_t region_end = task + 1 < tasks ? search->starts[task + 1] : search->n;
+    size_t end = StrLib_ChunkEnd(search, task);
+    size_t limit = end + search->m - 1 < search->n ? end + search->m - 1 : search->n;
+    size_t dst_pos = src_pos - search->before[task] * search->m + search->before[task] * search->new->len;
+
+    ssize_t found;
+    while (src_pos < end && (found = StrLib_FindFirst(&search->hay[src_pos], limit - src_pos, search->needle, search->m)) >= 0) {
+        StrLib_EmitReplacement(search->dst, &dst_pos, search->hay, &src_pos, src_pos + (size_t)found, search->m, search->new);
+    }
+
+    memcpy(&search->dst[dst_pos], &search->hay[src_pos], region_end - src_pos);
+}
+
+// Replaces all instances of `old` with `new` in `str` like String_Replace, splitting the work across `pool`: matches
+// are counted per chunk, then each chunk is written to its offset in the result
+static inline String String_ParallelReplace(const StringThreadPool* pool, const String* str, const String* old, const String* new)
+{
+    if (str->len < 2 * STRLIB_PARALLEL_CHUNK || old->len == 0 || old->len > STRLIB_PARALLEL_CHUNK) {
+        return String_Replace(str, old, new);
+    }
+
+    size_t tasks = (str->len + STRLIB_PARALLEL_CHUNK - 1) / STRLIB_PARALLEL_CHUNK;
+    size_t* offsets = StrLib_Alloc(2 * tasks * sizeof(size_t));
+    StrLib_ParallelSearch search = {
+        .hay = String_Buf(str),
+        .n = str->len,
+        .needle = String_Buf(old),
+        .m = old->len,
+        .chunks = StrLib_Alloc(tasks * sizeof(StrLib_ChunkMatches)),
+        .starts = offsets,
+        .before = &offsets[tasks],
+        .new = new,
+    };
+    size_t count = StrLib_ParallelCount(pool, &search);
+
+    String ret = String_New(str->len - count * old->len + count * new->len);
+    search.dst = String_Buf(&ret);
+    StrLib_PoolRun(pool, tasks, StrLib_ReplaceTask, &search);
+
+    StrLib_Free(search.chunks);
+    StrLib_Free(offsets);
+    return ret;
+}
+
+// Operation applied to each String of a StringList by StringList_ParallelForEach
+typedef void StringListFn(const String* str, size_t index, void* ctx);
+
+typedef struct {
+    const StringList* list;
+    StringListFn* fn;
+    void* ctx;
+} StrLib_ParallelList;
+
+static inline void StrLib_ListTask(void* ctx, size_t task)
+{
+    StrLib_ParallelList* op = ctx;
+    size_t end = (task + 1) * STRLIB_PARALLEL_BLOCK < op->list->len ? (task + 1) * STRLIB_PARALLEL_BLOCK : op->list->len;
+    for (size_t ii = task * STRLIB_PARALLEL_BLOCK; ii < end; ii++) {
+        op->fn(&op->list->str[ii], ii, op->ctx);
+    }
+}
+
+// Calls fn(str, index, ctx) for every String of `list`, splitting the list into blocks across `pool`
+// NOTE: `fn` is called concurrently from several threads
+static inline void StringList_ParallelForEach(const StringThreadPool* pool, const StringList* list, StringListFn* fn, void* ctx)
+{
+    StrLib_ParallelList op = { .list = list, .fn = fn, .ctx = ctx };
+    StrLib_PoolRun(pool, (list->len + STRLIB_PARALLEL_BLOCK - 1) / STRLIB_PARALLEL_BLOCK, StrLib_ListTask, &op);
+}
+
+typedef struct {
+    uint64_t seed;
+    uint64_t* hashes;
+} StrLib_ListHash;
+
+static inline void StrLib_HashElement(const String* str, size_t index, void* ctx)
+{
+    StrLib_ListHash* op = ctx;
+    op->hashes[index] = String_Hash(str, op->seed);
+}
+
+// Hashes every String of `list` into `hashes` (which has room for list->len hashes) across `pool`
+static inline void StringList_ParallelHash(const StringThreadPool* pool, const StringList* list, uint64_t seed, uint64_t* hashes)
+{
+    StrLib_ListHash op = { .seed = seed, .hashes = hashes };
+    StringList_ParallelForEach(pool, list, StrLib_HashElement, &op);
+}
+
+static inline void StrLib_TrimElement(const String* str, size_t index, void* ctx)
+{
+    ((StringView*)ctx)[index] = String_TrimView(str);
+}
+
+// Trims whitespace from every String of `list` into `views` (which has room for list->len views) across `pool`
+static inline void StringList_ParallelTrimView(const StringThreadPool* pool, const StringList* list, StringView* views)
+{
+    StringList_ParallelForEach(pool, list, StrLib_TrimElement, views);
+}
+
+typedef struct {
+    const String* key;
+    ssize_t* order;
+} StrLib_ListCompare;
+
+static inline void StrLib_CompareElement(const String* str, size_t index, void* ctx)
+{
+    StrLib_ListCompare* op = ctx;
+    op->order[index] = String_Compare(str, op->key);
+}
+
+// Compares every String of `list` to `key` like String_Compare into `order` (which has room for list->len results)
+// across `pool`
+static inline void StringList_ParallelCompare(const StringThreadPool* pool, const StringList* list, const String* key, ssize_t* order)
+{
+    StrLib_ListCompare op = { .key = key, .order = order };
+    StringList_ParallelForEach(pool, list, StrLib_CompareElement, &op);
+}
+#endif
+
+/* ---- Sorting ---- */
+
+// Groups of at most this many Strings are sorted by insertion sort
+#define STRLIB_SORT_INSERTION 16
+
+// Groups sharing a prefix of at least this many bytes are sorted by comparing whole Strings instead of 8 more bytes
+// at a time
+#define STRLIB_SORT_DEEP 64
+
+typedef struct {
+    uint64_t key; // the 8 bytes after the prefix shared by the group being sorted, big-endian so they order like memcmp
+    size_t rem;   // bytes left after the shared prefix, 9 if there are more than `key` holds
+    const String* str;
+} StrLib_SortItem;
+
+static inline void StrLib_SortLoadKey(StrLib_SortItem* item, size_t depth)
+{
+    size_t left = item->str->len > depth ? item->str->len - depth : 0;
+    item->key = StrLib_PrefixWord(String_Buf(item->str) + depth, left);
+    item->rem = left > 8 ? 9 : left;
+}
+
+// Orders `a` and `b` by their cached keys, a String that ends within them comes before a longer one
+static inline int StrLib_SortKeyCompare(const StrLib_SortItem* a, const StrLib_SortItem* b)
+{
+    if (a->key != b->key) {
+        return a->key < b->key ? -1 : 1;
+    } else if (a->rem != b->rem) {
+        return a->rem < b->rem ? -1 : 1;
+    }
+
+    return 0;
+}
+
+// Orders `a` and `b`, which share their first `depth` bytes, like String_Compare
+static inline int StrLib_SortCompare(const StrLib_SortItem* a, const StrLib_SortItem* b, size_t depth)
+{
+    int cmp = StrLib_SortKeyCompare(a, b);
+    if (cmp || a->rem < 9) {
+        return cmp;
+    }
+
+    ssize_t order = StringView_Compare(
+        StringView_Slice(String_View(a->str), depth + 8, a->str->len),
+        StringView_Slice(String_View(b->str), depth + 8, b->str->len));
+    return (order > 0) - (order < 0);
+}
+
+static inline void StrLib_SortSwap(StrLib_SortItem* a, StrLib_SortItem* b)
+{
+    StrLib_SortItem tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// Sorts `items`, which share their first `depth` bytes and have their keys loaded at `depth`, with a three-way
+// (multikey) quicksort on the cached keys: the group equal to the pivot's key moves on to the next 8 bytes
+static inline void StrLib_SortItems(StrLib_SortItem* items, size_t n, size_t depth)
+{
+    while (n > STRLIB_SORT_INSERTION) {
+        bool deep = depth >= STRLIB_SORT_DEEP;
+        StrLib_SortItem* a = &items[0];
+        StrLib_SortItem* b = &items[n / 2];
+        StrLib_SortItem* c = &items[n - 1];
+        if (StrLib_SortCompare(a, b, depth) > 0) {
+            StrLib_SortItem* tmp = a;
+            a = b;
+            b = tmp;
+        }
+        StrLib_SortItem pivot = StrLib_SortCompare(b, c, depth) <= 0 ? *b : StrLib_SortCompare(a, c, depth) <= 0 ? *c : *a;
+
+        // [0, lt) < pivot, [lt, gt) == pivot, [gt, n) > pivot
+        size_t lt = 0;
+        size_t gt = n;
+        for (size_t ii = 0; ii < gt;) {
+            int cmp = deep ? StrLib_SortCompare(&items[ii], &pivot, depth) : StrLib_SortKeyCompare(&items[ii], &pivot);
+            if (cmp < 0) {
+                StrLib_SortSwap(&items[lt++], &items[ii++]);
+            } else if (cmp > 0) {
+                StrLib_SortSwap(&items[ii], &items[--gt]);
+            } else {
+                ii += 1;
+            }
+        }
+
+        if (!deep && pivot.rem == 9 && gt - lt > 1) {
+            for (size_t ii = lt; ii < gt; ii++) {
+                StrLib_SortLoadKey(&items[ii], depth + 8);
+            }
+            StrLib_SortItems(&items[lt], gt - lt, depth + 8);
+        }
+
+        // recurse into the smaller side, loop on the larger one
+        if (lt < n - gt) {
+            StrLib_SortItems(items, lt, depth);
+            items += gt;
+            n -= gt;
+        } else {
+            StrLib_SortItems(&items[gt], n - gt, depth);
+            n = lt;
+        }
+    }
+
+    for (size_t ii = 1; ii < n; ii++) {
+        StrLib_SortItem item = items[ii];
+        size_t jj = ii;
+        for (; jj > 0 && StrLib_SortCompare(&items[jj - 1], &item, depth) > 0; jj--) {
+            items[jj] = items[jj - 1];
+        }
+        items[jj] = item;
+    }
+}
+
+static inline StrLib_SortItem* StrLib_SortPrepare(const StringList* list)
+{
+    StrLib_SortItem* items = StrLib_Alloc(list->len * sizeof(StrLib_SortItem));
+    for (size_t ii = 0; ii < list->len; ii++) {
+        items[ii].str = &list->str[ii];
+        StrLib_SortLoadKey(&items[ii], 0);
+    }
+
+    return items;
+}
+
+// Rearranges the Strings of `list` into the order of `items`
+static inline void StrLib_SortApply(StringList* list, const StrLib_SortItem* items)
+{
+    String* sorted = StrLib_Alloc(list->len * sizeof(String));
+    for (size_t ii = 0; ii < list->len; ii++) {
+        sorted[ii] = *items[ii].str;
+    }
+
+    memcpy(list->str, sorted, list->len * sizeof(String));
+    StrLib_Free(sorted);
+}
+
+// Sorts the Strings of `list` in place into String_Compare order
+// NOTE: Sorts 8 byte prefixes cached next to pointers to the Strings, so most comparisons don't touch the Strings
+static inline void StringList_Sort(StringList* list)
+{
+    if (list->len < 2) {
+        return;
+    }
+
+    StrLib_SortItem* items = StrLib_SortPrepare(list);
+    StrLib_SortItems(items, list->len, 0);
+    StrLib_SortApply(list, items);
+    StrLib_Free(items);
+}
+
+// Moves the first String of each run of equal adjacent Strings of `list` to the front, keeping their order
+// returns the number of such (unique, if `list` is sorted) Strings, the rest are moved behind them
+// NOTE: `list` isn't shrunk, set list->len to the result after deleting the duplicates if they own their memory
+static inline size_t StringList_Unique(StringList* list)
+{
+    if (list->len < 2) {
+        return list->len;
+    }
+
+    size_t last = 0;
+    for (size_t ii = 1; ii < list->len; ii++) {
+        if (!StringView_Equal(String_View(&list->str[ii]), String_View(&list->str[last]))) {
+            last += 1;
+            if (last != ii) {
+                String tmp = list->str[last];
+                list->str[last] = list->str[ii];
+                list->str[ii] = tmp;
+            }
+        }
+    }
+
+    return last + 1;
+}
+
+#if !defined(__STDC_NO_THREADS__) && !defined(__STDC_NO_ATOMICS__)
+typedef struct {
+    StrLib_SortItem* items;
+    StrLib_SortItem* merged;
+    size_t len;
+    size_t run; // length of the sorted runs, each task sorts or merges two of them
+} StrLib_ParallelSortState;
+
+static inline void StrLib_SortRunTask(void* ctx, size_t task)
+{
+    StrLib_ParallelSortState* state = ctx;
+    size_t start = task * state->run;
+    if (start >= state->len) {
+        return;
+    }
+
+    size_t end = start + state->run < state->len ? start + state->run : state->len;
+    StrLib_SortItems(&state->items[start], end - start, 0);
+
+    // sorting loads deeper keys, merging compares from the start
+    for (size_t ii = start; ii < end; ii++) {
+        StrLib_SortLoadKey(&state->items[ii], 0);
+    }
+}
+
+static inline void StrLib_MergeRunsTask(void* ctx, size_t task)
+{
+    StrLib_ParallelSortState* state = ctx;
+    size_t start = 2 * task * state->run;
+    size_t mid = start + state->run < state->len ? start + state->run : state->len;
+    size_t end = mid + state->run < state->len ? mid + state->run : state->len;
+
+    size_t aa = start;
+    size_t bb = mid;
+    for (size_t ii = start; ii < end; ii++) {
+        bool take_a = bb == end || (aa < mid && StrLib_SortCompare(&state->items[aa], &state->items[bb], 0) <= 0);
+        state->merged[ii] = take_a ? state->items[aa++] : state->items[bb++];
+    }
+}
+
+// Sorts the Strings of `list` like StringList_Sort, sorting runs of it across `pool` and merging them in parallel
+static inline void StringList_ParallelSort(const StringThreadPool* pool, StringList* list)
+{
+    size_t threads = StringThreadPool_Threads(pool);
+    if (threads == 1 || list->len < 4 * STRLIB_PARALLEL_BLOCK) {
+        StringList_Sort(list);
+        return;
+    }
+
+    // a power of two number of runs, a few per thread for balance
+    size_t runs = 1;
+    while (runs < 4 * threads && list->len / (2 * runs) >= STRLIB_PARALLEL_BLOCK) {
+        runs *= 2;
+    }
+
+    StrLib_ParallelSortState state = {
+        .items = StrLib_SortPrepare(list),
+        .merged = StrLib_Alloc(list->len * sizeof(StrLib_SortItem)),
+        .len = list->len,
+        .run = (list->len + runs - 1) / runs,
+    };
+    StrLib_PoolRun(pool, runs, StrLib_SortRunTask, &state);
+
+    for (; runs > 1; runs /= 2) {
+        StrLib_PoolRun(pool, runs / 2, StrLib_MergeRunsTask, &state);
+        StrLib_SortItem* tmp = state.items;
+        state.items = state.merged;
+        state.merged = tmp;
+        state.run *= 2;
+    }
+
+    StrLib_SortApply(list, state.items);
+    StrLib_Free(state.items);
+    StrLib_Free(state.merged);
+}
+#endif
+
+/* ---- Rope ---- */
+
+// Leaves of a rope built from a String are at most this long
+#define STRLIB_ROPE_CHUNK 4096
+
+// Adjacent leaves are merged (copied) while their combined length is at most this, so runs of small edits don't
+// fragment the rope into tiny leaves
+#define STRLIB_ROPE_MERGE 256
+
+// Bound on the height of a rope, which is kept AVL balanced (at most ~1.44 log2(n) high)
+#define STRLIB_ROPE_MAX_HEIGHT 96
+
+// Node of a rope, immutable once built and reference counted so ropes, their copies and slices can share subtrees
+// Nodes (and the chars of leaves that aren't shared) are freed through the allocator they were allocated from
+typedef struct StrLib_RopeNode StrLib_RopeNode;
+struct StrLib_RopeNode {
+    StrLib_Refs refs;
+    StringAllocator* allocator;
+    size_t len;    // chars under this node
+    size_t height; // 0 for leaves
+    union {
+        struct {
+            StrLib_RopeNode* left;
+            StrLib_RopeNode* right;
+        };
+        String leaf; // shared (or short) so slicing a leaf doesn't copy its chars
+    };
+};
+
+// Text stored as a balanced tree of String chunks, so concatenating, inserting, removing and slicing are O(log n)
+// instead of copying the whole text like the String functions do
+// NOTE: an empty rope has no nodes, StringRope_New doesn't allocate
+typedef struct {
+    StrLib_RopeNode* root;
+} StringRope;
+
+// Returns a new reference to `node`, which may be NULL
+static inline StrLib_RopeNode* StrLib_RopeRetain(StrLib_RopeNode* node)
+{
+    if (node) {
+        StrLib_RefsAcquire(&node->refs);
+    }
+    return node;
+}
+
+// Drops a reference to `node` (which may be NULL), freeing it and releasing its children with the last one
+static inline void StrLib_RopeRelease(StrLib_RopeNode* node)
+{
+    if (!node || !StrLib_RefsRelease(&node->refs)) {
+        return;
+    }
+
+    if (node->height) {
+        StrLib_RopeRelease(node->left);
+        StrLib_RopeRelease(node->right);
+    } else if (node->leaf.kind == STRING_KIND_BUF) {
+        StrLib_FreeFrom(node->allocator, node->leaf.buf);
+    } else {
+        String_Delete(&node->leaf);
+    }
+    StrLib_FreeFrom(node->allocator, node);
+}
+
+// Creates a leaf owning `leaf`, which must have been allocated from the allocator in use
+static inline StrLib_RopeNode* StrLib_RopeLeaf(String leaf)
+{
+    StrLib_RopeNode* node = StrLib_Alloc(sizeof(StrLib_RopeNode));
+    StrLib_RefsInit(&node->refs);
+    node->allocator = strlib_allocator;
+    node->len = leaf.len;
+    node->height = 0;
+    node->leaf = leaf;
+    return node;
+}
+
+// Creates a node over `left` and `right`, taking over the references to them
+static inline StrLib_RopeNode* StrLib_RopeBranch(StrLib_RopeNode* left, StrLib_RopeNode* right)
+{
+    StrLib_RopeNode* node = StrLib_Alloc(sizeof(StrLib_RopeNode));
+    StrLib_RefsInit(&node->refs);
+    node->allocator = strlib_allocator;
+    node->len = left->len + right->len;
+    node->height = 1 + (left->height > right->height ? left->height : right->height);
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
+// Creates a node over `left` and `right` (whose heights differ by at most 2), rotating it back into balance
+// Takes over the references to `left` and `right`
+static inline StrLib_RopeNode* StrLib_RopeBalance(StrLib_RopeNode* left, StrLib_RopeNode* right)
+{
+    if (left->height > right->height + 1) {
+        StrLib_RopeNode* outer = StrLib_RopeRetain(left->left);
+        StrLib_RopeNode* inner = StrLib_RopeRetain(left->right);
+        StrLib_RopeRelease(left);
+        if (outer->height >= inner->height) {
+            return StrLib_RopeBranch(outer, StrLib_RopeBranch(inner, right));
+        }
+
+        StrLib_RopeNode* inner_left = StrLib_RopeRetain(inner->left);
+        StrLib_RopeNode* inner_right = StrLib_RopeRetain(inner->right);
+        StrLib_RopeRelease(inner);
+        return StrLib_RopeBranch(StrLib_RopeBranch(outer, inner_left), StrLib_RopeBranch(inner_right, right));
+    } else if (right->height > left->height + 1) {
+        StrLib_RopeNode* outer = StrLib_RopeRetain(right->right);
+        StrLib_RopeNode* inner = StrLib_RopeRetain(right->left);
+        StrLib_RopeRelease(right);
+        if (outer->height >= inner->height) {
+            return StrLib_RopeBranch(StrLib_RopeBranch(left, inner), outer);
+        }
+
+        StrLib_RopeNode* inner_left = StrLib_RopeRetain(inner->left);
+        StrLib_RopeNode* inner_right = StrLib_RopeRetain(inner->right);
+        StrLib_RopeRelease(inner);
+        return StrLib_RopeBranch(StrLib_RopeBranch(left, inner_left), StrLib_RopeBranch(inner_right, outer));
+    }
+
+    return StrLib_RopeBranch(left, right);
+}
+
+// Determines if the leaves `a` and `b` are small enough to be merged into one
+static inline bool StrLib_RopeMergeable(const StrLib_RopeNode* a, const StrLib_RopeNode* b)
+{
+    return a->height == 0 && b->height == 0 && a->len + b->len <= STRLIB_ROPE_MERGE;
+}
+
+// Concatenates `left` and `right` (either may be NULL) in O(|height difference|), taking over the references to them
+static inline StrLib_RopeNode* StrLib_RopeJoin(StrLib_RopeNode* left, StrLib_RopeNode* right)
+{
+    if (!left) {
+        return right;
+    } else if (!right) {
+        return left;
+    } else if (StrLib_RopeMergeable(left, right)) {
+        String merged = String_New(left->len + right->len);
+        memcpy(String_Buf(&merged), String_Buf(&left->leaf), left->len);
+        memcpy(String_Buf(&merged) + left->len, String_Buf(&right->leaf), right->len);
+        StrLib_RopeRelease(left);
+        StrLib_RopeRelease(right);
+        return StrLib_RopeLeaf(merged);
+    }
+
+    // descend the spine of the taller side until the heights match, also to reach a small leaf to merge with
+    if (left->height > right->height + 1 || (left->height == 1 && StrLib_RopeMergeable(left->right, right))) {
+        StrLib_RopeNode* outer = StrLib_RopeRetain(left->left);
+        StrLib_RopeNode* inner = StrLib_RopeJoin(StrLib_RopeRetain(left->right), right);
+        StrLib_RopeRelease(left);
+        return StrLib_RopeBalance(outer, inner);
+    } else if (right->height > left->height + 1 || (right->height == 1 && StrLib_RopeMergeable(left, right->left))) {
+        StrLib_RopeNode* outer = StrLib_RopeRetain(right->right);
+        StrLib_RopeNode* inner = StrLib_RopeJoin(left, StrLib_RopeRetain(right->left));
+        StrLib_RopeRelease(right);
+        return StrLib_RopeBalance(inner, outer);
+    }
+
+    return StrLib_RopeBranch(left, right);
+}
+
+// Splits the chars under `node` (which may be NULL) at `pos` into new references `left` and `right` in O(log n)
+static inline void StrLib_RopeSplit(StrLib_RopeNode* node, size_t pos, StrLib_RopeNode** left, StrLib_RopeNode** right)
+{
+    if (!node || pos == 0) {
+        *left = NULL;
+        *right = StrLib_RopeRetain(node);
+    } else if (pos >= node->len) {
+        *left = StrLib_RopeRetain(node);
+        *right = NULL;
+    } else if (node->height == 0) {
+        *left = StrLib_RopeLeaf(String_SliceShared(&node->leaf, 0, pos));
+        *right = StrLib_RopeLeaf(String_SliceShared(&node->leaf, pos, node->len));
+    } else if (pos < node->left->len) {
+        StrLib_RopeNode* rest;
+        StrLib_RopeSplit(node->left, pos, left, &rest);
+        *right = StrLib_RopeJoin(rest, StrLib_RopeRetain(node->right));
+    } else {
+        StrLib_RopeNode* rest;
+        StrLib_RopeSplit(node->right, pos - node->left->len, &rest, right);
+        *left = StrLib_RopeJoin(StrLib_RopeRetain(node->left), rest);
+    }
+}
+
+// Builds a balanced tree of leaves sharing the chars [`start`, `end`) of the shared (or short) String `str`
+static inline StrLib_RopeNode* StrLib_RopeBuild(const String* str, size_t start, size_t end)
+{
+    if (start == end) {
+        return NULL;
+    } else if (end - start <= STRLIB_ROPE_CHUNK) {
+        return StrLib_RopeLeaf(String_SliceShared(str, start, end));
+    }
+
+    // halve the number of chunks so both sides have (almost) the same height
+    size_t chunks = (end - start + STRLIB_ROPE_CHUNK - 1) / STRLIB_ROPE_CHUNK;
+    size_t mid = start + (chunks + 1) / 2 * STRLIB_ROPE_CHUNK;
+    return StrLib_RopeBranch(StrLib_RopeBuild(str, start, mid), StrLib_RopeBuild(str, mid, end));
+}
+
+// Builds the nodes of a rope holding the chars of `str`, sharing them if `str` is shared and copying them once if not
+static inline StrLib_RopeNode* StrLib_RopeFromString(const String* str)
+{
+    String shared = String_Share(str);
+    StrLib_RopeNode* node = StrLib_RopeBuild(&shared, 0, shared.len);
+    String_Delete(&shared);
+    return node;
+}
+
+// Creates an empty rope
+static inline StringRope StringRope_New(void)
+{
+    return (StringRope) { .root = NULL };
+}
+
+// Creates a rope holding the chars of `str`, which are only copied (once) if `str` isn't shared (see String_Share)
+static inline StringRope StringRope_FromString(const String* str)
+{
+    return (StringRope) { .root = StrLib_RopeFromString(str) };
+}
+
+// Returns a copy of `rope` in O(1), the copies share their nodes
+static inline StringRope StringRope_Copy(const StringRope* rope)
+{
+    return (StringRope) { .root = StrLib_RopeRetain(rope->root) };
+}
+
+// Frees a rope, nodes shared with copies and slices of it are freed once they have all been deleted
+// NOTE: nodes go back to the allocator in use when they were created, like the blocks of shared Strings
+static inline void StringRope_Delete(StringRope* rope)
+{
+    StrLib_RopeRelease(rope->root);
+    rope->root = NULL;
+}
+
+// Returns the number of chars in `rope`
+static inline size_t StringRope_Len(const StringRope* rope)
+{
+    return rope->root ? rope->root->len : 0;
+}
+
+// Returns the char at `index` of `rope` in O(log n)
+static inline char StringRope_At(const StringRope* rope, size_t index)
+{
+    assert(index < StringRope_Len(rope));
+    const StrLib_RopeNode* node = rope->root;
+    while (node->height) {
+        if (index < node->left->len) {
+            node = node->left;
+        } else {
+            index -= node->left->len;
+            node = node->right;
+        }
+    }
+
+    return String_Buf(&node->leaf)[index];
+}
+
+// Appends the chars of `other` to `rope` in O(log n), `other` is left unchanged
+static inline void StringRope_Concat(StringRope* rope, const StringRope* other)
+{
+    rope->root = StrLib_RopeJoin(rope->root, StrLib_RopeRetain(other->root));
+}
+
+// Appends the chars of `str` to `rope`, in O(log n) plus copying `str` if it isn't shared
+static inline void StringRope_Append(StringRope* rope, const String* str)
+{
+    rope->root = StrLib_RopeJoin(rope->root, StrLib_RopeFromString(str));
+}
+
+// Replaces the index range [`start`, `end`) of `rope` with the chars of `str`, in O(log n) plus copying `str` if it
+// isn't shared
+static inline void StringRope_Splice(StringRope* rope, size_t start, size_t end, const String* str)
+{
+    assert(start <= end && end <= StringRope_Len(rope));
+    StrLib_RopeNode* before;
+    StrLib_RopeNode* rest;
+    StrLib_RopeNode* removed;
+    StrLib_RopeNode* after;
+    StrLib_RopeSplit(rope->root, start, &before, &rest);
+    StrLib_RopeSplit(rest, end - start, &removed, &after);
+    StrLib_RopeRelease(rest);
+    StrLib_RopeRelease(removed);
+    StrLib_RopeRelease(rope->root);
+
+    rope->root = StrLib_RopeJoin(StrLib_RopeJoin(before, StrLib_RopeFromString(str)), after);
+}
+
+// Inserts the chars of `str` at `pos` of `rope`, in O(log n) plus copying `str` if it isn't shared
+static inline void StringRope_Insert(StringRope* rope, size_t pos, const String* str)
+{
+    StringRope_Splice(rope, pos, pos, str);
+}
+
+// Removes the index range [`start`, `end`) of `rope` in O(log n)
+static inline void StringRope_Remove(StringRope* rope, size_t start, size_t end)
+{
+    StringRope_Splice(rope, start, end, str(""));
+}
+
+// Returns a rope of the index range [`start`, `end`) of `rope` in O(log n), sharing its nodes
+static inline StringRope StringRope_Slice(const StringRope* rope, size_t start, size_t end)
+{
+    assert(start <= end && end <= StringRope_Len(rope));
+    StrLib_RopeNode* before;
+    StrLib_RopeNode* rest;
+    StrLib_RopeNode* slice;
+    StrLib_RopeNode* after;
+    StrLib_RopeSplit(rope->root, start, &before, &rest);
+    StrLib_RopeSplit(rest, end - start, &slice, &after);
+    StrLib_RopeRelease(before);
+    StrLib_RopeRelease(rest);
+    StrLib_RopeRelease(after);
+
+    return (StringRope) { .root = slice };
+}
+
+// Streams the chars of a rope one chunk (leaf) at a time
+// NOTE: the iterator borrows the nodes of the rope, which must not be modified or deleted while it is in use
+typedef struct {
+    const StrLib_RopeNode* stack[STRLIB_ROPE_MAX_HEIGHT + 1];
+    size_t depth;
+    size_t skip; // chars to skip at the start of the next chunk
+} StringRopeIterator;
+
+// Creates an iterator over the chunks of `rope` starting at index `pos`, the first chunk starts at `pos`
+static inline StringRopeIterator StringRope_Iter(const StringRope* rope, size_t pos)
+{
+    StringRopeIterator it = { .depth = 0 };
+    const StrLib_RopeNode* node = rope->root;
+    if (!node || pos >= node->len) {
+        return it;
+    }
+
+    // keep the right siblings of the path to `pos`, they are visited after the leaf holding it
+    while (node->height) {
+        if (pos < node->left->len) {
+            it.stack[it.depth++] = node->right;
+            node = node->left;
+        } else {
+            pos -= node->left->len;
+            node = node->right;
+        }
+    }
+
+    it.stack[it.depth++] = node;
+    it.skip = pos;
+    return it;
+}
+
+// Stores a view of the next chunk in `chunk`, returns false once all chunks have been yielded
+static inline bool StringRopeIterator_Next(StringRopeIterator* it, StringView* chunk)
+{
+    if (it->depth == 0) {
+        return false;
+    }
+
+    const StrLib_RopeNode* node = it->stack[--it->depth];
+    while (node->height) {
+        it->stack[it->depth++] = node->right;
+        node = node->left;
+    }
+
+    *chunk = StringView_Slice(String_View(&node->leaf), it->skip, node->len);
+    it->skip = 0;
+    return true;
+}
+
+// Finds the index of the first occurrence of `substr` in `rope` at or after index `from`, including occurrences
+// spanning several chunks
+// returns a negative value if no occurrence exists
+static inline ssize_t StringRope_Find(const StringRope* rope, const String* substr, size_t from)
+{
+    size_t len = StringRope_Len(rope);
+    size_t m = substr->len;
+    const char* needle = String_Buf(substr);
+    if (from > len || m > len - from) {
+        return -1;
+    } else if (m == 0) {
+        return (ssize_t)from;
+    }
+
+    // the last m - 1 chars before the current chunk followed by the first m - 1 chars of it, which holds every
+    // occurrence that starts before the chunk and ends in it
+    char local[256];
+    char* window = 2 * (m - 1) <= sizeof(local) ? local : StrLib_Alloc(2 * (m - 1));
+    size_t carry = 0;
+    size_t chunk_pos = from;
+    ssize_t ret = -1;
+
+    StringRopeIterator it = StringRope_Iter(rope, from);
+    StringView chunk;
+    while (ret < 0 && StringRopeIterator_Next(&it, &chunk)) {
+        if (carry) {
+            size_t head = chunk.len < m - 1 ? chunk.len : m - 1;
+            memcpy(&window[carry], chunk.buf, head);
+            ssize_t found = StrLib_FindFirst(window, carry + head, needle, m);
+            if (found >= 0 && (size_t)found < carry) {
+                ret = (ssize_t)(chunk_pos - carry + (size_t)found);
+                break;
+            }
+        }
+
+        ssize_t found = StrLib_FindFirst(chunk.buf, chunk.len, needle, m);
+        if (found >= 0) {
+            ret = (ssize_t)(chunk_pos + (size_t)found);
+            break;
+        }
+
+        if (chunk.len >= m - 1) {
+            memcpy(window, &chunk.buf[chunk.len - (m - 1)], m - 1);
+            carry = m - 1;
+        } else {
+            size_t keep = carry < m - 1 - chunk.len ? carry : m - 1 - chunk.len;
+            memmove(window, &window[carry - keep], keep);
+            memcpy(&window[keep], chunk.buf, chunk.len);
+            carry = keep + chunk.len;
+        }
+        chunk_pos += chunk.len;
+    }
+
+    if (window != local) {
+        StrLib_Free(window);
+    }
     return ret;
 }
 
-// Returns a StringList which contains all the substrings formed by splitting `str` wherever `delim` occurs
-// NOTE: Calling String_Split with delim == "" is invalid
-static inline StringList String_Split(const String* str, const String* delim)
+// Returns a flat String holding the chars of `rope`
+static inline String StringRope_Flatten(const StringRope* rope)
 {
-    assert(delim->len > 0);
+    String ret = String_New(StringRope_Len(rope));
+    char* dst = String_Buf(&ret);
+    StringRopeIterator it = StringRope_Iter(rope, 0);
+    StringView chunk;
+    while (StringRopeIterator_Next(&it, &chunk)) {
+        memcpy(dst, chunk.buf, chunk.len);
+        dst += chunk.len;
+    }
 
-    size_t delim_count = String_DistinctInstancesOf(str, delim);
-    size_t substr_count = delim_count + 1;
-    size_t char_count = str->len - delim_count * delim->len;
-    size_t char_buf_size = char_count + substr_count; // need 1 extra byte per substring for null terminator insertion
-    size_t str_header_size = sizeof(String) * substr_count;
+    return ret;
+}
 
-    char* mem = calloc(1, char_buf_size + str_header_size);
-    String* strs = (String*)mem;
-    char* data = mem + str_header_size;
+/* ---- UTF-8 ---- */
 
-    *strs = (String) { .len = 0, .buf = data };
-    size_t str_pos;
-    for (str_pos = 0; str_pos < str->len - delim->len + 1;) {
-        bool found = !memcmp(&str->buf[str_pos], delim->buf, delim->len);
-        if (found) {
-            strs += 1;
-            data += 1;
-            *strs = (String) { .len = 0, .buf = data };
-            str_pos += delim->len;
+// NOTE: code points are counted, sliced and indexed by their lead bytes, which is only exact for valid UTF-8, so
+// validate text from untrusted sources with String_ValidateUtf8 first
+
+// Code point that invalid bytes decode to
+#define STRLIB_UTF8_REPLACEMENT 0xFFFD
+
+// Code point offsets are found by counting (and skipping) the code points of this many bytes at a time
+#define STRLIB_UTF8_SKIP_BLOCK 64
+
+// StringUtf8Index keeps the number of code points before every this many bytes
+#define STRLIB_UTF8_INDEX_STRIDE 1024
+
+// Decodes the code point starting at `buf[0]` (of `len` > 0 bytes), stores it in `cp` and returns its length in bytes
+// returns 0 if `buf` doesn't start with a valid (shortest form, not a surrogate, at most U+10FFFF) UTF-8 sequence
+static inline size_t StrLib_Utf8Decode(const unsigned char* buf, size_t len, uint32_t* cp)
+{
+    unsigned char lead = buf[0];
+    size_t n;
+    uint32_t min;
+    uint32_t val;
+    if (lead < 0x80) {
+        *cp = lead;
+        return 1;
+    } else if (lead >= 0xC2 && lead <= 0xDF) {
+        n = 2;
+        min = 0x80;
+        val = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        n = 3;
+        min = 0x800;
+        val = lead & 0x0F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        n = 4;
+        min = 0x10000;
+        val = lead & 0x07;
+    } else {
+        return 0;
+    }
+
+    if (len < n) {
+        return 0;
+    }
+
+    for (size_t ii = 1; ii < n; ii++) {
+        if ((buf[ii] & 0xC0) != 0x80) {
+            return 0;
+        }
+        val = val << 6 | (buf[ii] & 0x3F);
+    }
+
+    if (val < min || val > 0x10FFFF || (val >= 0xD800 && val <= 0xDFFF)) {
+        return 0;
+    }
+
+    *cp = val;
+    return n;
+}
+
+// Decodes the multi-byte sequence starting at `buf[0]` of valid UTF-8, stores it in `cp` and returns its length
+static inline size_t StrLib_Utf8DecodeValid(const unsigned char* buf, uint32_t* cp)
+{
+    if (buf[0] < 0xE0) {
+        *cp = (uint32_t)(buf[0] & 0x1F) << 6 | (buf[1] & 0x3F);
+        return 2;
+    } else if (buf[0] < 0xF0) {
+        *cp = (uint32_t)(buf[0] & 0x0F) << 12 | (uint32_t)(buf[1] & 0x3F) << 6 | (buf[2] & 0x3F);
+        return 3;
+    }
+
+    *cp = (uint32_t)(buf[0] & 0x07) << 18 | (uint32_t)(buf[1] & 0x3F) << 12 | (uint32_t)(buf[2] & 0x3F) << 6
+        | (buf[3] & 0x3F);
+    return 4;
+}
+
+// Encodes the code point `cp` (at most U+10FFFF) as UTF-8 in `dst`, returns the number of bytes written (at most 4)
+static inline size_t StrLib_Utf8Encode(uint32_t cp, char* dst)
+{
+    if (cp < 0x80) {
+        dst[0] = (char)cp;
+        return 1;
+    } else if (cp < 0x800) {
+        dst[0] = (char)(0xC0 | cp >> 6);
+        dst[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    } else if (cp < 0x10000) {
+        dst[0] = (char)(0xE0 | cp >> 12);
+        dst[1] = (char)(0x80 | (cp >> 6 & 0x3F));
+        dst[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+
+    dst[0] = (char)(0xF0 | cp >> 18);
+    dst[1] = (char)(0x80 | (cp >> 12 & 0x3F));
+    dst[2] = (char)(0x80 | (cp >> 6 & 0x3F));
+    dst[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Returns the index of the first byte at or after `start` that doesn't start a valid UTF-8 sequence, `len` if all do
+static inline size_t StrLib_Utf8ValidPrefix(const char* buf, size_t start, size_t len)
+{
+    const unsigned char* bytes = (const unsigned char*)buf;
+    size_t ii = start;
+    while (ii < len) {
+        if (ii + 8 <= len && !(StrLib_Read8(&bytes[ii]) & 0x8080808080808080)) {
+            ii += 8;
+            continue;
+        }
+
+        uint32_t cp;
+        size_t n = StrLib_Utf8Decode(&bytes[ii], len - ii, &cp);
+        if (!n) {
+            return ii;
+        }
+        ii += n;
+    }
+
+    return len;
+}
+
+// Counts the bytes in the index range [`start`, `len`) of `buf` that aren't continuation bytes (the code points of
+// valid UTF-8), plus the 4 byte lead bytes if `utf16` (whose code points take two UTF-16 units)
+static inline size_t StrLib_Utf8CountScalar(const char* buf, size_t start, size_t len, bool utf16)
+{
+    size_t count = 0;
+    for (size_t ii = start; ii < len; ii++) {
+        unsigned char byte = (unsigned char)buf[ii];
+        count += (byte & 0xC0) != 0x80;
+        count += utf16 && byte >= 0xF0;
+    }
+
+    return count;
+}
+
+#if STRLIB_X86_SIMD
+// Validation classifies each byte by the high nibble of the byte before it, the low nibble of the byte before it and
+// its own high nibble with three table lookups, the errors a pair of bytes can have are the bits set in all three (see
+// Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte")
+#define STRLIB_UTF8_TOO_SHORT  (1 << 0) // lead byte not followed by a continuation byte
+#define STRLIB_UTF8_TOO_LONG   (1 << 1) // ASCII followed by a continuation byte
+#define STRLIB_UTF8_OVERLONG_3 (1 << 2) // E0 followed by 80..9F
+#define STRLIB_UTF8_TOO_LARGE  (1 << 3) // F4 followed by 90..BF, or F5..FF
+#define STRLIB_UTF8_SURROGATE  (1 << 4) // ED followed by A0..BF
+#define STRLIB_UTF8_OVERLONG_2 (1 << 5) // C0 or C1
+#define STRLIB_UTF8_OVERLONG_4 (1 << 6) // F0 followed by 80..8F (shares its bit with the F5..FF half of TOO_LARGE)
+#define STRLIB_UTF8_TWO_CONTS  (1 << 7) // two continuation bytes, only an error if they don't follow a 3 or 4 byte lead
+#define STRLIB_UTF8_TOO_LARGE_1000 STRLIB_UTF8_OVERLONG_4
+#define STRLIB_UTF8_CARRY      (STRLIB_UTF8_TOO_SHORT | STRLIB_UTF8_TOO_LONG | STRLIB_UTF8_TWO_CONTS)
+
+/* clang-format off */
+static const unsigned char strlib_utf8_lookup[3][16] = {
+    // high nibble of the previous byte
+    {
+        STRLIB_UTF8_TOO_LONG, STRLIB_UTF8_TOO_LONG, STRLIB_UTF8_TOO_LONG, STRLIB_UTF8_TOO_LONG,
+        STRLIB_UTF8_TOO_LONG, STRLIB_UTF8_TOO_LONG, STRLIB_UTF8_TOO_LONG, STRLIB_UTF8_TOO_LONG,
+        STRLIB_UTF8_TWO_CONTS, STRLIB_UTF8_TWO_CONTS, STRLIB_UTF8_TWO_CONTS, STRLIB_UTF8_TWO_CONTS,
+        STRLIB_UTF8_TOO_SHORT | STRLIB_UTF8_OVERLONG_2,
+        STRLIB_UTF8_TOO_SHORT,
+        STRLIB_UTF8_TOO_SHORT | STRLIB_UTF8_OVERLONG_3 | STRLIB_UTF8_SURROGATE,
+        STRLIB_UTF8_TOO_SHORT | STRLIB_UTF8_TOO_LARGE | STRLIB_UTF8_TOO_LARGE_1000 | STRLIB_UTF8_OVERLONG_4,
+    },
+    // low nibble of the previous byte
+    {
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_OVERLONG_3 | STRLIB_UTF8_OVERLONG_2 | STRLIB_UTF8_OVERLONG_4,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_OVERLONG_2,
+        STRLIB_UTF8_CARRY,
+        STRLIB_UTF8_CARRY,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_TOO_LARGE,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_TOO_LARGE | STRLIB_UTF8_TOO_LARGE_1000,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_TOO_LARGE | STRLIB_UTF8_TOO_LARGE_1000,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_TOO_LARGE | STRLIB_UTF8_TOO_LARGE_1000,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_TOO_LARGE | STRLIB_UTF8_TOO_LARGE_1000,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_TOO_LARGE | STRLIB_UTF8_TOO_LARGE_1000,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_TOO_LARGE | STRLIB_UTF8_TOO_LARGE_1000,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_TOO_LARGE | STRLIB_UTF8_TOO_LARGE_1000,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_TOO_LARGE | STRLIB_UTF8_TOO_LARGE_1000,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_TOO_LARGE | STRLIB_UTF8_TOO_LARGE_1000 | STRLIB_UTF8_SURROGATE,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_TOO_LARGE | STRLIB_UTF8_TOO_LARGE_1000,
+        STRLIB_UTF8_CARRY | STRLIB_UTF8_TOO_LARGE | STRLIB_UTF8_TOO_LARGE_1000,
+    },
+    // high nibble of the byte itself
+    {
+        STRLIB_UTF8_TOO_SHORT, STRLIB_UTF8_TOO_SHORT, STRLIB_UTF8_TOO_SHORT, STRLIB_UTF8_TOO_SHORT,
+        STRLIB_UTF8_TOO_SHORT, STRLIB_UTF8_TOO_SHORT, STRLIB_UTF8_TOO_SHORT, STRLIB_UTF8_TOO_SHORT,
+        STRLIB_UTF8_TOO_LONG | STRLIB_UTF8_OVERLONG_2 | STRLIB_UTF8_TWO_CONTS | STRLIB_UTF8_OVERLONG_3
+            | STRLIB_UTF8_TOO_LARGE_1000 | STRLIB_UTF8_OVERLONG_4,
+        STRLIB_UTF8_TOO_LONG | STRLIB_UTF8_OVERLONG_2 | STRLIB_UTF8_TWO_CONTS | STRLIB_UTF8_OVERLONG_3
+            | STRLIB_UTF8_TOO_LARGE,
+        STRLIB_UTF8_TOO_LONG | STRLIB_UTF8_OVERLONG_2 | STRLIB_UTF8_TWO_CONTS | STRLIB_UTF8_SURROGATE
+            | STRLIB_UTF8_TOO_LARGE,
+        STRLIB_UTF8_TOO_LONG | STRLIB_UTF8_OVERLONG_2 | STRLIB_UTF8_TWO_CONTS | STRLIB_UTF8_SURROGATE
+            | STRLIB_UTF8_TOO_LARGE,
+        STRLIB_UTF8_TOO_SHORT, STRLIB_UTF8_TOO_SHORT, STRLIB_UTF8_TOO_SHORT, STRLIB_UTF8_TOO_SHORT,
+    },
+};
+
+// Last bytes a block may end with without a sequence continuing into the next block, lead bytes above them are
+// incomplete (3 and 4 byte leads in the last 2 and 3 bytes, any lead in the last byte)
+static const unsigned char strlib_utf8_max_tail[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF,
+};
+/* clang-format on */
+
+// Returns a block that is non-zero where `input` (which follows `prev`) isn't valid UTF-8
+__attribute__((target("ssse3"))) static inline __m128i StrLib_Utf8ErrorsSSSE3(__m128i input, __m128i prev)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+    __m128i byte_1_high = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)strlib_utf8_lookup[0]), _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+    __m128i byte_1_low
+        = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)strlib_utf8_lookup[1]), _mm_and_si128(prev1, nibble));
+    __m128i byte_2_high = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)strlib_utf8_lookup[2]), _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+    __m128i special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    // the 2nd and 3rd bytes after 3 and 4 byte leads must be continuations, which are TWO_CONTS above
+    __m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 14), _mm_set1_epi8(0xE0 - 0x80));
+    __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13), _mm_set1_epi8(0xF0 - 0x80));
+    __m128i must_continue = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+
+    return _mm_xor_si128(must_continue, special);
+}
+
+__attribute__((target("ssse3"))) static inline bool StrLib_ValidUtf8SSSE3(const char* buf, size_t len)
+{
+    const __m128i max_tail = _mm_loadu_si128((const __m128i*)&strlib_utf8_max_tail[16]);
+    __m128i error = _mm_setzero_si128();
+    __m128i prev = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+    char tail[16] = { 0 };
+
+    for (size_t ii = 0; ii < len; ii += 16) {
+        __m128i input;
+        if (ii + 16 <= len) {
+            input = _mm_loadu_si128((const __m128i*)&buf[ii]);
+        } else {
+            // the padding is ASCII, so an incomplete sequence at the end is an error within this block
+            memcpy(tail, &buf[ii], len - ii);
+            input = _mm_loadu_si128((const __m128i*)tail);
+        }
+
+        if (!_mm_movemask_epi8(input)) {
+            error = _mm_or_si128(error, incomplete);
         } else {
-            *data = str->buf[str_pos];
-            data += 1;
-            strs->len += 1;
-            str_pos += 1;
+            error = _mm_or_si128(error, StrLib_Utf8ErrorsSSSE3(input, prev));
+            incomplete = _mm_subs_epu8(input, max_tail);
         }
+        prev = input;
     }
 
-    if (str_pos != str->len) {
-        memcpy(data, &str->buf[str_pos], str->len - str_pos);
-        strs->len += str->len - str_pos;
+    error = _mm_or_si128(error, incomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+// Returns `input` shifted up by `n` bytes with the last `n` bytes of `prev` shifted in (`n` is 1, 2 or 3)
+#define STRLIB_UTF8_PREV_AVX2(input, prev, n) \
+    _mm256_alignr_epi8((input), _mm256_permute2x128_si256((prev), (input), 0x21), 16 - (n))
+
+__attribute__((target("avx2"))) static inline __m256i StrLib_Utf8ErrorsAVX2(__m256i input, __m256i prev)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i prev1 = STRLIB_UTF8_PREV_AVX2(input, prev, 1);
+    __m256i byte_1_high = _mm256_shuffle_epi8(
+        _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)strlib_utf8_lookup[0])),
+        _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    __m256i byte_1_low = _mm256_shuffle_epi8(
+        _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)strlib_utf8_lookup[1])),
+        _mm256_and_si256(prev1, nibble));
+    __m256i byte_2_high = _mm256_shuffle_epi8(
+        _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)strlib_utf8_lookup[2])),
+        _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    __m256i third = _mm256_subs_epu8(STRLIB_UTF8_PREV_AVX2(input, prev, 2), _mm256_set1_epi8(0xE0 - 0x80));
+    __m256i fourth = _mm256_subs_epu8(STRLIB_UTF8_PREV_AVX2(input, prev, 3), _mm256_set1_epi8(0xF0 - 0x80));
+    __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+
+    return _mm256_xor_si256(must_continue, special);
+}
+
+__attribute__((target("avx2"))) static inline bool StrLib_ValidUtf8AVX2(const char* buf, size_t len)
+{
+    const __m256i max_tail = _mm256_loadu_si256((const __m256i*)strlib_utf8_max_tail);
+    __m256i error = _mm256_setzero_si256();
+    __m256i prev = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    char tail[32] = { 0 };
+
+    for (size_t ii = 0; ii < len; ii += 32) {
+        __m256i input;
+        if (ii + 32 <= len) {
+            input = _mm256_loadu_si256((const __m256i*)&buf[ii]);
+        } else {
+            memcpy(tail, &buf[ii], len - ii);
+            input = _mm256_loadu_si256((const __m256i*)tail);
+        }
+
+        if (!_mm256_movemask_epi8(input)) {
+            error = _mm256_or_si256(error, incomplete);
+        } else {
+            error = _mm256_or_si256(error, StrLib_Utf8ErrorsAVX2(input, prev));
+            incomplete = _mm256_subs_epu8(input, max_tail);
+        }
+        prev = input;
     }
 
-    return (StringList) {
-        .len = substr_count,
-        .str = (String*)mem,
-    };
+    error = _mm256_or_si256(error, incomplete);
+    return _mm256_testz_si256(error, error);
 }
 
-// Returns a C-style string given a String
-// NOTE: Does not allocate memory, lifetime of the return value is tied to that of the supplied String
-// intended to be used to interface with C-style APIs efficiently
-static inline const char* String_CStr(String* str)
+// Counts like StrLib_Utf8CountScalar, comparing 16 bytes at a time into byte counters that are summed before they
+// can overflow
+static inline size_t StrLib_Utf8CountSSE2(const char* buf, size_t len, bool utf16)
 {
-    str->buf[str->len] = '\0';
-    return str->buf;
+    const __m128i last_cont = _mm_set1_epi8(-65); // 0xBF
+    const __m128i lead_4 = _mm_set1_epi8((char)0xF0);
+    size_t count = 0;
+    size_t ii = 0;
+
+    while (ii + 16 <= len) {
+        // each block adds at most 2 to a counter
+        size_t blocks = (len - ii) / 16 < 127 ? (len - ii) / 16 : 127;
+        __m128i acc = _mm_setzero_si128();
+        for (size_t end = ii + 16 * blocks; ii < end; ii += 16) {
+            __m128i blk = _mm_loadu_si128((const __m128i*)&buf[ii]);
+            acc = _mm_sub_epi8(acc, _mm_cmpgt_epi8(blk, last_cont));
+            if (utf16) {
+                acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_max_epu8(blk, lead_4), blk));
+            }
+        }
+
+        __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+        count += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+
+    return count + StrLib_Utf8CountScalar(buf, ii, len, utf16);
 }
 
-// Return a slice from a string from index range [`start`, `end`) from `str`
-static inline String String_Slice(const String* str, size_t start, size_t end)
+__attribute__((target("avx2"))) static inline size_t StrLib_Utf8CountAVX2(const char* buf, size_t len, bool utf16)
 {
-    assert(0 <= start && start < str->len);
-    assert(0 <= end && end <= str->len);
-    assert(end >= start);
-    return String_FromCharArray(&str->buf[start], end - start);
+    const __m256i last_cont = _mm256_set1_epi8(-65);
+    const __m256i lead_4 = _mm256_set1_epi8((char)0xF0);
+    size_t count = 0;
+    size_t ii = 0;
+
+    while (ii + 32 <= len) {
+        size_t blocks = (len - ii) / 32 < 127 ? (len - ii) / 32 : 127;
+        __m256i acc = _mm256_setzero_si256();
+        for (size_t end = ii + 32 * blocks; ii < end; ii += 32) {
+            __m256i blk = _mm256_loadu_si256((const __m256i*)&buf[ii]);
+            acc = _mm256_sub_epi8(acc, _mm256_cmpgt_epi8(blk, last_cont));
+            if (utf16) {
+                acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(_mm256_max_epu8(blk, lead_4), blk));
+            }
+        }
+
+        __m256i sums = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+        __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+        count += (size_t)_mm_cvtsi128_si32(half) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+    }
+
+    return count + StrLib_Utf8CountScalar(buf, ii, len, utf16);
 }
+#endif
 
-// Write a string to a FILE*
-static inline void String_Write(const String* str, FILE* fd)
+STRLIB_NOINLINE static bool StrLib_ValidUtf8Long(const char* buf, size_t len)
 {
-    fwrite(str->buf, sizeof(char), str->len, fd);
+#if STRLIB_X86_SIMD
+    if (StrLib_HasAVX2()) {
+        return StrLib_ValidUtf8AVX2(buf, len);
+    } else if (StrLib_HasSSSE3()) {
+        return StrLib_ValidUtf8SSSE3(buf, len);
+    }
+#endif
+    return StrLib_Utf8ValidPrefix(buf, 0, len) == len;
 }
 
-// Print a string to stdout
-// NOTE: Capable of printing past null chars
-static inline void String_Print(const String* str)
+// Determines if `buf` is valid UTF-8
+static inline bool StrLib_ValidUtf8(const char* buf, size_t len)
 {
-    String_Write(str, stdout);
+    // short strings are checked inline, the vector validators need a few blocks to pay off
+    if (len < 32) {
+        return StrLib_Utf8ValidPrefix(buf, 0, len) == len;
+    }
+
+    return StrLib_ValidUtf8Long(buf, len);
+}
+
+// Counts the code points of the valid UTF-8 `buf`, or the UTF-16 units they take if `utf16`
+static inline size_t StrLib_Utf8Count(const char* buf, size_t len, bool utf16)
+{
+#if STRLIB_X86_SIMD
+    if (len >= 64 && StrLib_HasAVX2()) {
+        return StrLib_Utf8CountAVX2(buf, len, utf16);
+    }
+    return StrLib_Utf8CountSSE2(buf, len, utf16);
+#else
+    return StrLib_Utf8CountScalar(buf, 0, len, utf16);
+#endif
+}
+
+// Returns the index of the byte starting code point `index` of the valid UTF-8 `buf`, counting from `start`
+// Code points are counted (and skipped) 16 * STRLIB_UTF8_SKIP_BLOCK bytes, then STRLIB_UTF8_SKIP_BLOCK bytes at a time
+static inline size_t StrLib_Utf8Seek(const char* buf, size_t start, size_t len, size_t index)
+{
+    size_t ii = start;
+    for (size_t block = 16 * STRLIB_UTF8_SKIP_BLOCK; block >= STRLIB_UTF8_SKIP_BLOCK; block /= 16) {
+        while (len - ii >= block) {
+            size_t count = StrLib_Utf8Count(&buf[ii], block, false);
+            if (count > index) {
+                break;
+            }
+            index -= count;
+            ii += block;
+        }
+    }
+
+    for (; ii < len; ii++) {
+        if (((unsigned char)buf[ii] & 0xC0) != 0x80 && index-- == 0) {
+            return ii;
+        }
+    }
+
+    assert(index == 0 && "code point index out of range");
+    return len;
+}
+
+// Determines if `view` is valid UTF-8 (shortest form sequences of code points up to U+10FFFF, without surrogates)
+static inline bool StringView_ValidateUtf8(StringView view)
+{
+    return StrLib_ValidUtf8(view.buf, view.len);
+}
+
+// Determines if `str` is valid UTF-8 (shortest form sequences of code points up to U+10FFFF, without surrogates)
+static inline bool String_ValidateUtf8(const String* str)
+{
+    STRLIB_STATS_SCOPE(String_ValidateUtf8, str->len);
+    return StrLib_ValidUtf8(String_Buf(str), str->len);
+}
+
+// Finds the index of the first byte of `view` that doesn't start a valid UTF-8 sequence
+// returns a negative value if `view` is valid UTF-8
+static inline ssize_t StringView_Utf8Error(StringView view)
+{
+    // valid input (the common case) is checked with the vector validators, which can't tell where the error is
+    if (StrLib_ValidUtf8(view.buf, view.len)) {
+        return -1;
+    }
+
+    return (ssize_t)StrLib_Utf8ValidPrefix(view.buf, 0, view.len);
+}
+
+// Returns the number of code points in the valid UTF-8 `view`
+static inline size_t StringView_Utf8Len(StringView view)
+{
+    return StrLib_Utf8Count(view.buf, view.len, false);
+}
+
+// Returns the number of code points in the valid UTF-8 `str`
+static inline size_t String_Utf8Len(const String* str)
+{
+    return StrLib_Utf8Count(String_Buf(str), str->len, false);
+}
+
+// Returns the number of UTF-16 units the valid UTF-8 `view` converts to
+static inline size_t StringView_Utf16Len(StringView view)
+{
+    return StrLib_Utf8Count(view.buf, view.len, true);
+}
+
+// Returns the index of the byte starting code point `index` of the valid UTF-8 `view`, `view.len` if `index` is the
+// number of code points
+// NOTE: this counts the code points before `index`, for many lookups into the same text use a StringUtf8Index
+static inline size_t StringView_Utf8Offset(StringView view, size_t index)
+{
+    return StrLib_Utf8Seek(view.buf, 0, view.len, index);
+}
+
+// Returns the code point range [`start`, `end`) of the valid UTF-8 `view`
+static inline StringView StringView_Utf8Slice(StringView view, size_t start, size_t end)
+{
+    assert(start <= end);
+    size_t first = StringView_Utf8Offset(view, start);
+    size_t last = first + StringView_Utf8Offset(StringView_Slice(view, first, view.len), end - start);
+    return StringView_Slice(view, first, last);
+}
+
+// Converts the UTF-8 `view` to UTF-16 in `dst`, which must have room for StringView_Utf16Len(view) units (at most
+// `view.len`)
+// returns the number of units written, or a negative value if `view` isn't valid UTF-8
+static inline ssize_t StringView_ToUtf16(StringView view, uint16_t* dst)
+{
+    // validating up front with the vector validators is cheaper than checking each sequence while decoding
+    if (!StrLib_ValidUtf8(view.buf, view.len)) {
+        return -1;
+    }
+
+    const unsigned char* bytes = (const unsigned char*)view.buf;
+    size_t out = 0;
+    size_t ii = 0;
+    while (ii < view.len) {
+        if (bytes[ii] < 0x80) {
+#if STRLIB_X86_SIMD
+            // runs of ASCII are widened 16 bytes at a time
+            if (ii + 16 <= view.len) {
+                __m128i blk = _mm_loadu_si128((const __m128i*)&bytes[ii]);
+                if (!_mm_movemask_epi8(blk)) {
+                    _mm_storeu_si128((__m128i*)&dst[out], _mm_unpacklo_epi8(blk, _mm_setzero_si128()));
+                    _mm_storeu_si128((__m128i*)&dst[out + 8], _mm_unpackhi_epi8(blk, _mm_setzero_si128()));
+                    ii += 16;
+                    out += 16;
+                    continue;
+                }
+            }
+#endif
+            dst[out++] = bytes[ii++];
+            continue;
+        }
+
+        uint32_t cp;
+        ii += StrLib_Utf8DecodeValid(&bytes[ii], &cp);
+        if (cp >= 0x10000) {
+            dst[out++] = (uint16_t)(0xD800 | (cp - 0x10000) >> 10);
+            dst[out++] = (uint16_t)(0xDC00 | (cp & 0x3FF));
+        } else {
+            dst[out++] = (uint16_t)cp;
+        }
+    }
+
+    return (ssize_t)out;
+}
+
+// Converts the UTF-8 `view` to UTF-32 in `dst`, which must have room for StringView_Utf8Len(view) code points (at most
+// `view.len`)
+// returns the number of code points written, or a negative value if `view` isn't valid UTF-8
+static inline ssize_t StringView_ToUtf32(StringView view, uint32_t* dst)
+{
+    if (!StrLib_ValidUtf8(view.buf, view.len)) {
+        return -1;
+    }
+
+    const unsigned char* bytes = (const unsigned char*)view.buf;
+    size_t out = 0;
+    size_t ii = 0;
+    while (ii < view.len) {
+        if (bytes[ii] < 0x80) {
+#if STRLIB_X86_SIMD
+            if (ii + 16 <= view.len) {
+                __m128i blk = _mm_loadu_si128((const __m128i*)&bytes[ii]);
+                if (!_mm_movemask_epi8(blk)) {
+                    __m128i lo = _mm_unpacklo_epi8(blk, _mm_setzero_si128());
+                    __m128i hi = _mm_unpackhi_epi8(blk, _mm_setzero_si128());
+                    _mm_storeu_si128((__m128i*)&dst[out], _mm_unpacklo_epi16(lo, _mm_setzero_si128()));
+                    _mm_storeu_si128((__m128i*)&dst[out + 4], _mm_unpackhi_epi16(lo, _mm_setzero_si128()));
+                    _mm_storeu_si128((__m128i*)&dst[out + 8], _mm_unpacklo_epi16(hi, _mm_setzero_si128()));
+                    _mm_storeu_si128((__m128i*)&dst[out + 12], _mm_unpackhi_epi16(hi, _mm_setzero_si128()));
+                    ii += 16;
+                    out += 16;
+                    continue;
+                }
+            }
+#endif
+            dst[out++] = bytes[ii++];
+            continue;
+        }
+
+        ii += StrLib_Utf8DecodeValid(&bytes[ii], &dst[out++]);
+    }
+
+    return (ssize_t)out;
+}
+
+// Determines if the 8 UTF-16 units at `src` are all ASCII
+static inline bool StrLib_Utf16Ascii8(const uint16_t* src)
+{
+    return !((StrLib_Read8((const unsigned char*)src) | StrLib_Read8((const unsigned char*)&src[4]))
+             & 0xFF80FF80FF80FF80);
+}
+
+// Creates `str` from the UTF-16 `src` of `len` units, returns false (leaving `str` unchanged) if `src` has unpaired
+// surrogates
+static inline bool String_FromUtf16(const uint16_t* src, size_t len, String* str)
+{
+    STRLIB_STATS_SCOPE(String_FromUtf16, len * sizeof(uint16_t));
+    // the first pass validates the surrogate pairs and sizes the String
+    size_t bytes = 0;
+    for (size_t ii = 0; ii < len;) {
+        if (ii + 8 <= len && StrLib_Utf16Ascii8(&src[ii])) {
+            bytes += 8;
+            ii += 8;
+            continue;
+        }
+
+        uint16_t unit = src[ii++];
+        if (unit < 0x80) {
+            bytes += 1;
+        } else if (unit < 0x800) {
+            bytes += 2;
+        } else if (unit < 0xD800 || unit > 0xDFFF) {
+            bytes += 3;
+        } else if (unit <= 0xDBFF && ii < len && src[ii] >= 0xDC00 && src[ii] <= 0xDFFF) {
+            bytes += 4;
+            ii += 1;
+        } else {
+            return false;
+        }
+    }
+
+    String ret = String_New(bytes);
+    char* dst = String_Buf(&ret);
+    for (size_t ii = 0; ii < len;) {
+        if (ii + 8 <= len && StrLib_Utf16Ascii8(&src[ii])) {
+#if STRLIB_X86_SIMD
+            __m128i units = _mm_loadu_si128((const __m128i*)&src[ii]);
+            _mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(units, units));
+#else
+            for (size_t jj = 0; jj < 8; jj++) {
+                dst[jj] = (char)src[ii + jj];
+            }
+#endif
+            dst += 8;
+            ii += 8;
+            continue;
+        }
+
+        uint32_t cp = src[ii++];
+        if (cp >= 0xD800 && cp <= 0xDBFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (src[ii++] - 0xDC00u);
+        }
+        dst += StrLib_Utf8Encode(cp, dst);
+    }
+
+    *str = ret;
+    return true;
+}
+
+// Creates `str` from the UTF-32 `src` of `len` code points, returns false (leaving `str` unchanged) if `src` has
+// surrogates or values above U+10FFFF
+static inline bool String_FromUtf32(const uint32_t* src, size_t len, String* str)
+{
+    STRLIB_STATS_SCOPE(String_FromUtf32, len * sizeof(uint32_t));
+    size_t bytes = 0;
+    for (size_t ii = 0; ii < len; ii++) {
+        uint32_t cp = src[ii];
+        if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            return false;
+        }
+        bytes += 1 + (cp >= 0x80) + (cp >= 0x800) + (cp >= 0x10000);
+    }
+
+    String ret = String_New(bytes);
+    char* dst = String_Buf(&ret);
+    for (size_t ii = 0; ii < len; ii++) {
+        dst += StrLib_Utf8Encode(src[ii], dst);
+    }
+
+    *str = ret;
+    return true;
+}
+
+// Iterates over the code points of UTF-8 text
+// NOTE: the iterator borrows the chars it iterates over, they must outlive it
+typedef struct {
+    StringView view;
+    size_t pos; // index of the byte starting the next code point
+} StringUtf8Iterator;
+
+// Creates an iterator over the code points of `view`
+static inline StringUtf8Iterator StringView_Utf8Iter(StringView view)
+{
+    return (StringUtf8Iterator) { .view = view, .pos = 0 };
+}
+
+// Creates an iterator over the code points of `str`
+static inline StringUtf8Iterator String_Utf8Iter(const String* str)
+{
+    return StringView_Utf8Iter(String_View(str));
+}
+
+// Stores the next code point in `cp`, returns false once all code points have been yielded
+// Bytes that don't start a valid sequence are yielded one at a time as STRLIB_UTF8_REPLACEMENT
+static inline bool StringUtf8Iterator_Next(StringUtf8Iterator* it, uint32_t* cp)
+{
+    if (it->pos >= it->view.len) {
+        return false;
+    }
+
+    const unsigned char* bytes = (const unsigned char*)&it->view.buf[it->pos];
+    if (bytes[0] < 0x80) {
+        *cp = bytes[0];
+        it->pos += 1;
+        return true;
+    }
+
+    size_t n = StrLib_Utf8Decode(bytes, it->view.len - it->pos, cp);
+    if (!n) {
+        *cp = STRLIB_UTF8_REPLACEMENT;
+        n = 1;
+    }
+    it->pos += n;
+    return true;
+}
+
+// Index of the code points of valid UTF-8 text, so code point offsets and slices are found in O(log n) (plus counting
+// at most STRLIB_UTF8_INDEX_STRIDE bytes) instead of counting from the start on every lookup
+// NOTE: the index borrows the chars it indexes, they must outlive it and not be modified
+typedef struct {
+    StringView view;
+    size_t len;     // number of code points
+    size_t* counts; // counts[k] is the number of code points in the first k * STRLIB_UTF8_INDEX_STRIDE bytes
+    size_t strides;
+} StringUtf8Index;
+
+// Creates an index of the code points of the valid UTF-8 `view` in O(n)
+static inline StringUtf8Index StringUtf8Index_New(StringView view)
+{
+    StringUtf8Index index = { .view = view, .strides = view.len / STRLIB_UTF8_INDEX_STRIDE + 1 };
+    index.counts = StrLib_Alloc(index.strides * sizeof(size_t));
+    index.counts[0] = 0;
+    for (size_t ii = 1; ii < index.strides; ii++) {
+        const char* stride = &view.buf[(ii - 1) * STRLIB_UTF8_INDEX_STRIDE];
+        index.counts[ii] = index.counts[ii - 1] + StrLib_Utf8Count(stride, STRLIB_UTF8_INDEX_STRIDE, false);
+    }
+
+    size_t last = (index.strides - 1) * STRLIB_UTF8_INDEX_STRIDE;
+    index.len = index.counts[index.strides - 1] + StrLib_Utf8Count(&view.buf[last], view.len - last, false);
+    return index;
+}
+
+// Frees an index
+static inline void StringUtf8Index_Delete(StringUtf8Index* index)
+{
+    StrLib_Free(index->counts);
+    index->counts = NULL;
+}
+
+// Returns the number of code points in the indexed text
+static inline size_t StringUtf8Index_Len(const StringUtf8Index* index)
+{
+    return index->len;
+}
+
+// Returns the index of the byte starting code point `cp` of the indexed text, the text's length if `cp` is the number
+// of code points
+static inline size_t StringUtf8Index_Offset(const StringUtf8Index* index, size_t cp)
+{
+    assert(cp <= index->len);
+    if (cp == index->len) {
+        return index->view.len;
+    }
+
+    // the last stride starting with fewer than `cp` + 1 code points before it holds the lead byte of `cp`
+    size_t lo = 0;
+    size_t hi = index->strides;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->counts[mid] <= cp) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return StrLib_Utf8Seek(
+        index->view.buf, lo * STRLIB_UTF8_INDEX_STRIDE, index->view.len, cp - index->counts[lo]);
+}
+
+// Returns the code point range [`start`, `end`) of the indexed text
+static inline StringView StringUtf8Index_Slice(const StringUtf8Index* index, size_t start, size_t end)
+{
+    assert(start <= end);
+    return StringView_Slice(index->view, StringUtf8Index_Offset(index, start), StringUtf8Index_Offset(index, end));
+}
+
+// Creates an iterator over the code points of the indexed text starting at code point `cp`
+static inline StringUtf8Iterator StringUtf8Index_Iter(const StringUtf8Index* index, size_t cp)
+{
+    return (StringUtf8Iterator) { .view = index->view, .pos = StringUtf8Index_Offset(index, cp) };
 }
@@ -54,7 +54,7 @@ void test_creation(TestResult* result)
     {
         char arr[] = "Hello World\n";
         String str = String_New(sizeof(arr) - 1);
-        memcpy(str.buf, arr, sizeof(arr) - 1);
+        memcpy(String_Buf(&str), arr, sizeof(arr) - 1);
 
         ASSERT(strcmp(String_CStr(&str), "Hello World\n") == 0);
         ASSERT(str.len == strlen("Hello World\n"));
@@ -93,7 +93,7 @@ void test_creation(TestResult* result)
 
         ASSERT(z.len == 3);
         ASSERT(String_Equal(&z, str("abc")));
-        ASSERT(z.buf != x.buf);
+        ASSERT(String_Buf(&z) != String_Buf(&x));
 
         ASSERT(w.len == 5);
         ASSERT(String_Equal(&w, str("\0\0\0\0\0")));
@@ -156,6 +156,49 @@ void test_simple(TestResult* result)
     String_Delete(&str2);
 }
 
+void test_search(TestResult* result)
+{
+    // long enough to go through the vectorized candidate filter
+    String hay = String_New(1000);
+    memset(hay.buf, 'a', hay.len);
+    memcpy(&hay.buf[37], "needle", 6);
+    memcpy(&hay.buf[900], "needle", 6);
+    hay.buf[hay.len - 1] = 'b';
+
+    ASSERT(String_FirstOccurrenceOf(&hay, str("needle")) == 37);
+    ASSERT(String_LastOccurrenceOf(&hay, str("needle")) == 900);
+    ASSERT(String_FirstOccurrenceOf(&hay, str("ab")) == (ssize_t)hay.len - 2);
+    ASSERT(String_LastOccurrenceOf(&hay, str("aan")) == 898);
+    ASSERT(String_FirstOccurrenceOf(&hay, str("b")) == (ssize_t)hay.len - 1);
+    ASSERT(String_LastOccurrenceOf(&hay, str("e")) == 905);
+    ASSERT(String_FirstOccurrenceOf(&hay, str("needles")) < 0);
+    ASSERT(String_LastOccurrenceOf(&hay, str("bb")) < 0);
+
+    // adversarial input, forces the Two-Way fallback
+    String adv = String_New(100000);
+    memset(adv.buf, 'a', adv.len);
+    adv.buf[50000] = 'b';
+    String needle = String_New(64);
+    memset(needle.buf, 'a', needle.len);
+    needle.buf[needle.len - 1] = 'b';
+    String rneedle = String_New(64);
+    memset(rneedle.buf, 'a', rneedle.len);
+    rneedle.buf[0] = 'b';
+
+    ASSERT(String_FirstOccurrenceOf(&adv, &needle) == 50000 - 63);
+    ASSERT(String_LastOccurrenceOf(&adv, &needle) == 50000 - 63);
+    ASSERT(String_FirstOccurrenceOf(&adv, &rneedle) == 50000);
+    ASSERT(String_LastOccurrenceOf(&adv, &rneedle) == 50000);
+    adv.buf[50000] = 'a';
+    ASSERT(String_FirstOccurrenceOf(&adv, &needle) < 0);
+    ASSERT(String_LastOccurrenceOf(&adv, &rneedle) < 0);
+
+    String_Delete(&hay);
+    String_Delete(&adv);
+    String_Delete(&needle);
+    String_Delete(&rneedle);
+}
+
 void test_comparison(TestResult* result)
 {
     String str1 = String("abc");
@@ -189,6 +232,73 @@ void test_comparison(TestResult* result)
     String_Delete(&str5);
 }
 
+void test_compare_kernels(TestResult* result)
+{
+    // every length the kernels special-case, with a single differing byte at every position, compared against memcmp
+    char buf_a[300];
+    char buf_b[300 + 1];
+    for (size_t ii = 0; ii < sizeof(buf_a); ii++) {
+        buf_a[ii] = (char)('a' + ii % 23);
+    }
+
+    bool equal_ok = true;
+    bool order_ok = true;
+    bool prefix_ok = true;
+    for (size_t len = 0; len < sizeof(buf_a); len += len < 80 ? 1 : 37) {
+        // misaligned so the wide loads don't line up with the buffers
+        char* b = &buf_b[1];
+        memcpy(b, buf_a, len);
+        StringView view_a = { .len = len, .buf = buf_a };
+        StringView view_b = { .len = len, .buf = b };
+        equal_ok &= StringView_Equal(view_a, view_b) && StringView_Compare(view_a, view_b) == 0;
+
+        for (size_t pos = 0; pos < len; pos++) {
+            for (int delta = -1; delta <= 1; delta += 2) {
+                b[pos] = (char)(buf_a[pos] + delta * 0x70);
+                int expect = memcmp(buf_a, b, len);
+                ssize_t order = StringView_Compare(view_a, view_b);
+                equal_ok &= !StringView_Equal(view_a, view_b);
+                order_ok &= (order < 0) == (expect < 0) && (order > 0) == (expect > 0) && order != 0;
+
+                StringPrefixView pa = StringPrefixView_FromView(view_a);
+                StringPrefixView pb = StringPrefixView_FromView(view_b);
+                ssize_t prefix_order = StringPrefixView_Compare(&pa, &pb);
+                prefix_ok &= (prefix_order < 0) == (expect < 0) && !StringPrefixView_Equal(&pa, &pb);
+                b[pos] = buf_a[pos];
+            }
+        }
+    }
+    ASSERT(equal_ok);
+    ASSERT(order_ok);
+    ASSERT(prefix_ok);
+
+    // bytes above 0x7f order as unsigned, like memcmp
+    ASSERT(StringView_Compare(strview("abc\x80"), strview("abc\x01")) > 0);
+    ASSERT(StringView_Compare(strview("0123456789abcde\xff"), strview("0123456789abcde\x7f")) > 0);
+    ASSERT(StringView_StartsWith(strview("0123456789abcdefghij"), strview("0123456789abcdefg")));
+    ASSERT(!StringView_EndsWith(strview("0123456789abcdefghij"), strview("0123456789abcdefghi")));
+
+    // the zero padding of a short prefix must not compare equal to a real \0
+    String abc = String("abc");
+    String abc0 = String_FromCharArray("abc\0", 4);
+    StringPrefixView pv_abc = String_PrefixView(&abc);
+    StringPrefixView pv_abc0 = String_PrefixView(&abc0);
+    ASSERT(pv_abc.prefix == pv_abc0.prefix);
+    ASSERT(!StringPrefixView_Equal(&pv_abc, &pv_abc0));
+    ASSERT(StringPrefixView_Compare(&pv_abc, &pv_abc0) < 0);
+    ASSERT(StringPrefixView_Compare(&pv_abc0, &pv_abc) > 0);
+
+    StringPrefixView pv_long = StringPrefixView_FromView(strview("prefixed and longer"));
+    StringPrefixView pv_long_b = StringPrefixView_FromView(strview("prefixed and longer"));
+    StringPrefixView pv_short = StringPrefixView_FromView(strview("prefixed"));
+    ASSERT(StringPrefixView_Equal(&pv_long, &pv_long_b));
+    ASSERT(StringPrefixView_Compare(&pv_long, &pv_long_b) == 0);
+    ASSERT(StringPrefixView_Compare(&pv_short, &pv_long) < 0);
+
+    String_Delete(&abc);
+    String_Delete(&abc0);
+}
+
 void test_instances(TestResult* result)
 {
     String str1 = String("12341234");
@@ -222,6 +332,57 @@ void test_instances(TestResult* result)
     String_Delete(&str2);
 }
 
+void test_find_all(TestResult* result)
+{
+    size_t positions[8];
+
+    ASSERT(String_FindAll(str("abababa"), str("aba"), false, positions, 8) == 2);
+    ASSERT(positions[0] == 0 && positions[1] == 4);
+    ASSERT(String_FindAll(str("abababa"), str("aba"), true, positions, 8) == 3);
+    ASSERT(positions[0] == 0 && positions[1] == 2 && positions[2] == 4);
+
+    // the count includes matches that don't fit in `positions`
+    ASSERT(String_FindAll(str("777777"), str("7"), false, positions, 2) == 6);
+    ASSERT(positions[0] == 0 && positions[1] == 1);
+    ASSERT(String_FindAll(str("777777"), str("8"), true, positions, 8) == 0);
+    ASSERT(String_FindAll(str("77"), str("777"), true, positions, 8) == 0);
+    ASSERT(String_FindAll(str("abc"), str(""), false, positions, 8) == 4);
+    ASSERT(positions[3] == 3);
+
+    StringFindIterator it = String_FindIter(str("a--b--c----"), str("--"), false);
+    size_t pos;
+    size_t found[8];
+    size_t count = 0;
+    while (count < 8 && StringFindIterator_Next(&it, &pos)) {
+        found[count++] = pos;
+    }
+    ASSERT(count == 4);
+    ASSERT(found[0] == 1 && found[1] == 4 && found[2] == 7 && found[3] == 9);
+    ASSERT(!StringFindIterator_Next(&it, &pos));
+
+    // more matches than String_Split and String_Replace record in their first pass
+    StringBuilder sb = StringBuilder_New(0);
+    for (size_t ii = 0; ii < 1000; ii++) {
+        StringBuilder_AppendCString(&sb, ii % 3 ? "ab, " : "c, ");
+    }
+    String text = StringBuilder_Finalize(&sb);
+
+    StringList list = String_Split(&text, str(", "));
+    ASSERT(list.len == 1001);
+    ASSERT(String_Equal(&list.str[0], str("c")));
+    ASSERT(String_Equal(&list.str[998], str("ab")));
+    ASSERT(String_Equal(&list.str[999], str("c")));
+    ASSERT(String_Equal(&list.str[1000], str("")));
+    StringList_Delete(&list);
+
+    String replaced = String_Replace(&text, str(", "), str(";"));
+    ASSERT(replaced.len == text.len - 1000);
+    ASSERT(String_InstancesOf(&replaced, str(";")) == 1000);
+    ASSERT(String_EndsWith(&replaced, str("ab;c;")));
+    String_Delete(&replaced);
+    String_Delete(&text);
+}
+
 void test_replace(TestResult* result)
 {
     String str1 = String("Bear Lion Sheep Lion Wolf Bear");
@@ -275,6 +436,42 @@ void test_replace(TestResult* result)
     String_Delete(&str2_r7);
     String_Delete(&str2_r8);
     String_Delete(&str2_r9);
+
+    // more matches than String_Replace records in its first pass
+    StringBuilder sb = { 0 };
+    for (int ii = 0; ii < 1000; ii++) {
+        StringBuilder_AppendCString(&sb, "{x}-");
+    }
+    String many = StringBuilder_Finalize(&sb);
+    String many_r = String_Replace(&many, str("{x}"), str("yy"));
+    ASSERT(many_r.len == 3000);
+    ASSERT(String_InstancesOf(&many_r, str("yy-")) == 1000);
+    ASSERT(String_EndsWith(&many_r, str("yy-yy-")));
+
+    String tmpl = String("Hello {name}, you are {age} years old, {name}!");
+    StringReplacement reps[] = {
+        { str("{name}"), str("Bob") },
+        { str("{age}"), str("42") },
+        { str("{"), str("<") },
+        { str(""), str("ignored") },
+    };
+    String tmpl_r1 = String_ReplaceMany(&tmpl, reps, 2);
+    String tmpl_r2 = String_ReplaceMany(&tmpl, &reps[1], 3);
+    String tmpl_r3 = String_ReplaceMany(&tmpl, reps, 0);
+    String many_r2 = String_ReplaceMany(&many, reps, 3);
+
+    ASSERT(String_Equal(&tmpl_r1, str("Hello Bob, you are 42 years old, Bob!")));
+    ASSERT(String_Equal(&tmpl_r2, str("Hello <name}, you are 42 years old, <name}!")));
+    ASSERT(String_Equal(&tmpl_r3, &tmpl));
+    ASSERT(String_InstancesOf(&many_r2, str("<x}-")) == 1000);
+
+    String_Delete(&many);
+    String_Delete(&many_r);
+    String_Delete(&many_r2);
+    String_Delete(&tmpl);
+    String_Delete(&tmpl_r1);
+    String_Delete(&tmpl_r2);
+    String_Delete(&tmpl_r3);
 }
 
 void test_trim(TestResult* result)
@@ -300,6 +497,39 @@ void test_trim(TestResult* result)
     ASSERT(String_Equal(&str5_tr, str("")));
     ASSERT(String_Equal(&str6_tr, str("")));
 
+    // long runs of padding take the vectorized path
+    String padded = String("\t\t                                       padded value \n                                 \r\n");
+    String left = String_TrimLeft(&padded);
+    String right = String_TrimRight(&padded);
+    ASSERT(strncmp(String_CStr(&left), "padded value \n", 14) == 0);
+    ASSERT(String_EndsWith(&left, str("\r\n")));
+    ASSERT(String_StartsWith(&right, str("\t\t ")));
+    ASSERT(String_EndsWith(&right, str("padded value")));
+    ASSERT(StringView_Equal(StringView_Trim(String_View(&padded)), strview("padded value")));
+    ASSERT(StringView_TrimLeft(strview("   ")).len == 0);
+    ASSERT(StringView_TrimRight(strview("   ")).len == 0);
+
+    StringCharSet zeros = StringCharSet_FromView(strview("0"));
+    String number = String("000000000000000000000000000000000000001020000000000000000000000000000000000000");
+    String digits = String_TrimSet(&number, &zeros);
+    ASSERT(String_Equal(&digits, str("102")));
+    ASSERT(StringView_Equal(StringView_TrimLeftSet(String_View(&number), &zeros), String_SliceView(&number, 38, number.len)));
+
+    StringCharSet punct = StringCharSet_FromView(strview(",;\xff"));
+    StringView csv = strview("field one has no separators until here;then \xff and, done");
+    ASSERT(StringView_FindFirstOf(csv, &punct) == 38);
+    ASSERT(StringView_FindLastOf(csv, &punct) == 49);
+    ASSERT(StringView_FindFirstNotOf(strview(";;,,;,;;,,;,;;,,;,;;,,;,;;,,;,;;,,x"), &punct) == 34);
+    ASSERT(StringView_FindLastNotOf(strview("x;;,,;,;;,,;,;;,,;,;;,,;,;;,,;,;;,,"), &punct) == 0);
+    ASSERT(StringView_FindFirstOf(strview("no separators in this rather long view"), &punct) == -1);
+    ASSERT(StringView_FindLastNotOf(strview(""), &punct) == -1);
+
+    String_Delete(&padded);
+    String_Delete(&left);
+    String_Delete(&right);
+    String_Delete(&number);
+    String_Delete(&digits);
+
     String_Delete(&str1);
     String_Delete(&str2);
     String_Delete(&str3);
@@ -334,6 +564,7 @@ void test_split(TestResult* result)
     StringList slist6_1 = String_Split(&str6, str(";"));
     StringList slist6_2 = String_Split(&str6, str("Hello World"));
     StringList slist7 = String_Split(&str7, str(";"));
+    StringList slist7_2 = String_Split(&str7, str(";;"));
 
     ASSERT(slist1.len == 3);
     ASSERT(String_Equal(&slist1.str[0], str("Test")));
@@ -388,6 +619,9 @@ void test_split(TestResult* result)
     ASSERT(slist7.len == 1);
     ASSERT(String_Equal(&slist7.str[0], str("")));
 
+    ASSERT(slist7_2.len == 1);
+    ASSERT(String_Equal(&slist7_2.str[0], str("")));
+
     String_Delete(&str1);
     String_Delete(&str2);
     String_Delete(&str3);
@@ -406,6 +640,115 @@ void test_split(TestResult* result)
     StringList_Delete(&slist6_1);
     StringList_Delete(&slist6_2);
     StringList_Delete(&slist7);
+    StringList_Delete(&slist7_2);
+}
+
+void test_view(TestResult* result)
+{
+    String src = String("  GET /index.html HTTP/1.1\r\n");
+    StringView line = String_TrimView(&src);
+
+    ASSERT(StringView_Equal(line, strview("GET /index.html HTTP/1.1")));
+    ASSERT(line.buf == String_Buf(&src) + 2);
+    ASSERT(StringView_StartsWith(line, strview("GET ")));
+    ASSERT(StringView_EndsWith(line, strview("HTTP/1.1")));
+    ASSERT(!StringView_StartsWith(line, strview("POST")));
+    ASSERT(StringView_Contains(line, strview("index")));
+    ASSERT(StringView_FirstOccurrenceOf(line, strview(" ")) == 3);
+    ASSERT(StringView_LastOccurrenceOf(line, strview(" ")) == 15);
+    ASSERT(StringView_Compare(line, strview("GET")) > 0);
+    ASSERT(StringView_Compare(strview("GET"), line) < 0);
+
+    StringView pieces[4];
+    ASSERT(StringView_Split(line, strview(" "), pieces, 4) == 3);
+    ASSERT(StringView_Equal(pieces[0], strview("GET")));
+    ASSERT(StringView_Equal(pieces[1], strview("/index.html")));
+    ASSERT(StringView_Equal(pieces[2], strview("HTTP/1.1")));
+    ASSERT(pieces[1].buf == line.buf + 4);
+
+    ASSERT(StringView_Split(line, strview(" "), pieces, 2) == 2);
+    ASSERT(StringView_Equal(pieces[1], strview("/index.html HTTP/1.1")));
+    ASSERT(StringView_Split(strview(";;"), strview(";"), pieces, 4) == 3);
+    ASSERT(pieces[0].len == 0 && pieces[1].len == 0 && pieces[2].len == 0);
+
+    StringView key, value;
+    ASSERT(StringView_Cut(strview("key=value=x"), strview("="), &key, &value));
+    ASSERT(StringView_Equal(key, strview("key")));
+    ASSERT(StringView_Equal(value, strview("value=x")));
+    ASSERT(!StringView_Cut(strview("novalue"), strview("="), &key, &value));
+    ASSERT(StringView_Equal(key, strview("novalue")) && value.len == 0);
+
+    StringView path = String_SliceView(&src, 7, 18);
+    ASSERT(StringView_Equal(path, strview("index.html ")));
+    ASSERT(StringView_Equal(StringView_Trim(path), strview("index.html")));
+    ASSERT(StringView_Slice(path, path.len, path.len).len == 0);
+    ASSERT(StringView_Trim(strview(" \t\n ")).len == 0);
+
+    String path_str = StringView_AsString(path);
+    ASSERT(String_EndsWith(&path_str, str(".html ")));
+
+    String copy = String_FromView(StringView_Trim(path));
+    ASSERT(String_Equal(&copy, str("index.html")));
+    ASSERT(StringView_Equal(StringView_FromCString("abc"), StringView_FromCharArray("abcd", 3)));
+
+    String_Delete(&src);
+    String_Delete(&copy);
+}
+
+void test_split_iter(TestResult* result)
+{
+    {
+        String csv = String("id,name,,email,");
+        StringSplitIterator it = String_SplitIter(&csv, str(","));
+        StringView piece;
+        StringList expected = String_Split(&csv, str(","));
+
+        size_t count = 0;
+        while (StringSplitIterator_Next(&it, &piece)) {
+            ASSERT(count < expected.len && StringView_Equal(piece, String_View(&expected.str[count])));
+            count += 1;
+        }
+        ASSERT(count == 5);
+        ASSERT(!StringSplitIterator_Next(&it, &piece));
+
+        StringList_Delete(&expected);
+        String_Delete(&csv);
+    }
+
+    {
+        StringSplitIterator it = StringView_SplitIter(strview("a--b--c--d"), strview("--"), 2);
+        StringView piece;
+
+        ASSERT(StringSplitIterator_Next(&it, &piece) && StringView_Equal(piece, strview("a")));
+        ASSERT(StringSplitIterator_Next(&it, &piece) && StringView_Equal(piece, strview("b")));
+        ASSERT(StringSplitIterator_Next(&it, &piece) && StringView_Equal(piece, strview("c--d")));
+        ASSERT(!StringSplitIterator_Next(&it, &piece));
+
+        it = StringView_SplitIter(strview(""), strview(";"), STRING_SPLIT_ALL);
+        ASSERT(StringSplitIterator_Next(&it, &piece) && piece.len == 0);
+        ASSERT(!StringSplitIterator_Next(&it, &piece));
+
+        it = StringView_SplitIter(strview("a;b"), strview(";"), 0);
+        ASSERT(StringSplitIterator_Next(&it, &piece) && StringView_Equal(piece, strview("a;b")));
+        ASSERT(!StringSplitIterator_Next(&it, &piece));
+    }
+
+    {
+        StringSplitIterator it = StringView_SplitAnyIter(strview("a b\tc\n\nd"), strview(" \t\n"), STRING_SPLIT_ALL);
+        StringView piece;
+
+        ASSERT(StringSplitIterator_Next(&it, &piece) && StringView_Equal(piece, strview("a")));
+        ASSERT(StringSplitIterator_Next(&it, &piece) && StringView_Equal(piece, strview("b")));
+        ASSERT(StringSplitIterator_Next(&it, &piece) && StringView_Equal(piece, strview("c")));
+        ASSERT(StringSplitIterator_Next(&it, &piece) && StringView_Equal(piece, strview("")));
+        ASSERT(StringSplitIterator_Next(&it, &piece) && StringView_Equal(piece, strview("d")));
+        ASSERT(!StringSplitIterator_Next(&it, &piece));
+
+        it = StringView_SplitAnyIter(strview("k=v;x=y"), strview("=;"), 1);
+        ASSERT(StringSplitIterator_Next(&it, &piece) && StringView_Equal(piece, strview("k")));
+        ASSERT(StringSplitIterator_Next(&it, &piece) && StringView_Equal(piece, strview("v;x=y")));
+        ASSERT(!StringSplitIterator_Next(&it, &piece));
+    }
 }
 
 void test_join(TestResult* result)
@@ -431,6 +774,42 @@ void test_join(TestResult* result)
     String_Delete(&join2_1);
     String_Delete(&join2_3);
     String_Delete(&join3_3);
+
+    {
+        StringList fields = String_Split(str("a,bc,,d"), str(","));
+        String joined = StringList_Join(&fields, str(","));
+        String dashed = StringList_Join(&fields, str(" - "));
+        String packed = StringList_Join(&fields, NULL);
+        ASSERT(String_Equal(&joined, str("a,bc,,d")));
+        ASSERT(String_Equal(&dashed, str("a - bc -  - d")));
+        ASSERT(String_Equal(&packed, str("abcd")));
+        String_Delete(&joined);
+        String_Delete(&dashed);
+        String_Delete(&packed);
+        StringList_Delete(&fields);
+    }
+
+    {
+        String parts[] = { String("the quick brown fox"), String(""), String("jumps") };
+        String joined = String_JoinArray(parts, 3, str(", "));
+        String single = String_JoinArray(parts, 1, str(", "));
+        String none = String_JoinArray(parts, 0, str(", "));
+        String many = String_JoinMany(str("/"), 4, &parts[2], str("over"), &parts[1], str("the lazy dog"));
+        String nothing = String_JoinMany(str("/"), 0);
+        ASSERT(String_Equal(&joined, str("the quick brown fox, , jumps")));
+        ASSERT(String_Equal(&single, &parts[0]));
+        ASSERT(none.len == 0);
+        ASSERT(String_Equal(&many, str("jumps/over//the lazy dog")));
+        ASSERT(nothing.len == 0);
+        String_Delete(&joined);
+        String_Delete(&single);
+        String_Delete(&none);
+        String_Delete(&many);
+        String_Delete(&nothing);
+        for (size_t ii = 0; ii < 3; ii++) {
+            String_Delete(&parts[ii]);
+        }
+    }
 }
 
 void test_slice(TestResult* result)
@@ -454,6 +833,91 @@ void test_slice(TestResult* result)
     String_Delete(&slice4);
 }
 
+#if !defined(__STDC_NO_THREADS__) && !defined(__STDC_NO_ATOMICS__)
+static int Test_RetainAndDelete(void* arg)
+{
+    const String* shared = arg;
+    for (size_t ii = 0; ii < 10000; ii++) {
+        String copy = String_Retain(shared);
+        String slice = String_SliceShared(&copy, 1, copy.len - 1);
+        String_Delete(&copy);
+        String_Delete(&slice);
+    }
+    return 0;
+}
+#endif
+
+void test_shared(TestResult* result)
+{
+    String payload = String("a payload long enough to be stored on the heap");
+    String shared = String_Share(&payload);
+    String_Delete(&payload);
+
+    ASSERT(String_IsShared(&shared));
+    ASSERT(String_RefCount(&shared) == 1);
+    ASSERT(String_Equal(&shared, str("a payload long enough to be stored on the heap")));
+    ASSERT(strcmp(String_CStr(&shared), "a payload long enough to be stored on the heap") == 0);
+
+    // copies and slices reference the same chars
+    String copy = String_Retain(&shared);
+    String again = String_Share(&copy);
+    String slice = String_SliceShared(&shared, 2, 41);
+    String tail = String_SliceShared(&slice, 23, slice.len);
+    String end = String_SliceShared(&shared, shared.len - 20, shared.len);
+    ASSERT(String_RefCount(&shared) == 6);
+    ASSERT(String_Buf(&copy) == String_Buf(&shared) && String_Buf(&again) == String_Buf(&shared));
+    ASSERT(String_Buf(&slice) == String_Buf(&shared) + 2);
+    ASSERT(String_Buf(&tail) == String_Buf(&shared) + 25);
+    ASSERT(String_Equal(&slice, str("payload long enough to be stored on the")));
+    ASSERT(String_Equal(&tail, str("be stored on the")));
+
+    // the deep copy stays available, short slices and Strings that aren't shared are copied
+    String deep = String_Copy(&shared);
+    String short_slice = String_SliceShared(&shared, 2, 9);
+    String plain_slice = String_SliceShared(str("a String that is not shared at all"), 2, 30);
+    ASSERT(!String_IsShared(&deep) && String_Buf(&deep) != String_Buf(&shared));
+    ASSERT(!String_IsShared(&short_slice) || STRING_SSO_CAPACITY < 7);
+    ASSERT(!String_IsShared(&plain_slice));
+    ASSERT(String_Equal(&plain_slice, str("String that is not shared at")));
+    ASSERT(String_RefCount(&deep) == 0);
+
+    // the chars outlive the String they were shared from (short slices are only shared without SSO)
+    size_t slice_refs = String_IsShared(&short_slice) ? 4 : 3;
+    String_Delete(&shared);
+    String_Delete(&copy);
+    String_Delete(&again);
+    ASSERT(String_RefCount(&slice) == slice_refs);
+    ASSERT(String_Equal(&slice, str("payload long enough to be stored on the")));
+    ASSERT(strcmp(String_CStr(&end), "e stored on the heap") == 0);
+
+    // slices ending before their block are copied to be terminated, without changing the Strings sharing the block
+    String head = String_SliceShared(&slice, 0, 20);
+    ASSERT(strcmp(String_CStr(&head), "payload long enough ") == 0);
+    ASSERT(!String_IsShared(&head) && String_RefCount(&slice) == slice_refs);
+    ASSERT(String_Equal(&slice, str("payload long enough to be stored on the")));
+    String_Delete(&head);
+
+#if !defined(__STDC_NO_THREADS__) && !defined(__STDC_NO_ATOMICS__)
+    {
+        thrd_t threads[4];
+        for (size_t ii = 0; ii < 4; ii++) {
+            thrd_create(&threads[ii], Test_RetainAndDelete, &slice);
+        }
+        for (size_t ii = 0; ii < 4; ii++) {
+            thrd_join(threads[ii], NULL);
+        }
+        ASSERT(String_RefCount(&slice) == slice_refs);
+    }
+#endif
+
+    String_Delete(&end);
+    String_Delete(&tail);
+    String_Delete(&slice);
+    String_Delete(&deep);
+    String_Delete(&short_slice);
+    String_Delete(&plain_slice);
+}
+
 void test_write_print(TestResult* result)
 {
     FILE* fd_write = fopen("test.txt", "wb");
@@ -507,20 +971,1049 @@ void test_write_print(TestResult* result)
     String_Delete(&str3);
 }
 
+void test_builder(TestResult* result)
+{
+    {
+        StringBuilder sb = StringBuilder_New(0);
+        StringBuilder_Append(&sb, str("foo"));
+        StringBuilder_AppendChar(&sb, ' ');
+        StringBuilder_AppendCString(&sb, "bar");
+        StringBuilder_AppendCharArray(&sb, " baz", 4);
+        StringBuilder_AppendInt(&sb, -42);
+        StringBuilder_AppendChar(&sb, ' ');
+        StringBuilder_AppendUInt(&sb, 18446744073709551615ull);
+        StringBuilder_AppendFormat(&sb, " %s=%d", "x", 7);
+
+        String built = StringBuilder_Finalize(&sb);
+        ASSERT(String_Equal(&built, str("foo bar baz-42 18446744073709551615 x=7")));
+        ASSERT(strcmp(String_CStr(&built), "foo bar baz-42 18446744073709551615 x=7") == 0);
+        ASSERT(sb.buf == NULL && sb.len == 0);
+
+        String_Delete(&built);
+    }
+
+    {
+        StringBuilder sb = { 0 };
+        for (int ii = 0; ii < 1000; ii++) {
+            StringBuilder_AppendFormat(&sb, "%d,", ii % 10);
+        }
+        ASSERT(sb.len == 2000);
+        ASSERT(sb.cap > sb.len);
+
+        size_t cap = sb.cap;
+        StringBuilder_Clear(&sb);
+        ASSERT(sb.len == 0 && sb.cap == cap);
+
+        StringBuilder_Reserve(&sb, 10000);
+        ASSERT(sb.cap > 10000);
+
+        StringBuilder_AppendInt(&sb, 0);
+        String built = StringBuilder_Finalize(&sb);
+        ASSERT(String_Equal(&built, str("0")));
+        String_Delete(&built);
+
+        String empty = StringBuilder_Finalize(&sb);
+        ASSERT(String_Equal(&empty, str("")));
+        String_Delete(&empty);
+    }
+}
+
+void test_sso(TestResult* result)
+{
+    String small = String("short key");
+    String edge = String_New(STRING_SSO_CAPACITY);
+    String large = String_New(STRING_SSO_CAPACITY + 1);
+    String heap = String_NewHeap(3);
+    memset(String_Buf(&edge), 'e', edge.len);
+    memset(String_Buf(&large), 'l', large.len);
+    memcpy(String_Buf(&heap), "abc", 3);
+
+#ifndef STRLIB_NO_SSO
+    ASSERT(String_IsInline(&small));
+    ASSERT(String_IsInline(&edge));
+#endif
+    ASSERT(!String_IsInline(&large));
+    ASSERT(!String_IsInline(&heap));
+    ASSERT(!String_IsInline(str("literal")));
+#ifndef STRLIB_NO_SSO
+    // everything but the length and kind byte holds inline chars
+    ASSERT(STRING_SSO_CAPACITY + 2 + sizeof(STRLIB_LEN_TYPE) == sizeof(String));
+#endif
+
+    ASSERT(strcmp(String_CStr(&small), "short key") == 0);
+    ASSERT(strlen(String_CStr(&edge)) == STRING_SSO_CAPACITY);
+    ASSERT(strlen(String_CStr(&large)) == STRING_SSO_CAPACITY + 1);
+    ASSERT(String_Equal(&heap, str("abc")));
+
+    // inline Strings are values, copying the struct copies the chars
+    String moved = small;
+    ASSERT(String_Equal(&moved, str("short key")));
+#ifndef STRLIB_NO_SSO
+    ASSERT(String_Buf(&moved) != String_Buf(&small));
+#endif
+
+    String joined = String_Join(&small, &heap);
+    ASSERT(String_Equal(&joined, str("short keyabc")));
+    ASSERT(String_FirstOccurrenceOf(&joined, str("keya")) == 6);
+
+    String_Delete(&small);
+    String_Delete(&edge);
+    String_Delete(&large);
+    String_Delete(&heap);
+    String_Delete(&joined);
+}
+
+void test_matcher(TestResult* result)
+{
+    String patterns[] = {
+        String("he"),
+        String("she"),
+        String("his"),
+        String("hers"),
+        String(""),
+        String("he"),
+    };
+    size_t count = sizeof(patterns) / sizeof(patterns[0]);
+    StringMatcher m = StringMatcher_New(patterns, count);
+    String text = String("ushers and this");
+    StringMatch match = { 0 };
+
+    ASSERT(StringMatcher_FindFirst(&m, &text, &match));
+    ASSERT(match.pos == 1 && match.pattern == 1);
+    ASSERT(StringMatcher_FindFirst(&m, str("a hershe"), &match));
+    ASSERT(match.pos == 2 && match.pattern == 0);
+    ASSERT(!StringMatcher_FindFirst(&m, str("nothing"), &match));
+
+    ASSERT(StringMatcher_Contains(&m, &text));
+    ASSERT(!StringMatcher_Contains(&m, str("")));
+    ASSERT(StringMatcher_Count(&m, &text) == 5);
+
+    StringMatch matches[8];
+    ASSERT(StringMatcher_FindAll(&m, &text, matches, 8) == 5);
+    ASSERT(matches[0].pos == 1 && matches[0].pattern == 1);
+    ASSERT(matches[1].pos == 2 && (matches[1].pattern == 0 || matches[1].pattern == 5));
+    ASSERT(matches[2].pos == 2 && (matches[2].pattern == 0 || matches[2].pattern == 5));
+    ASSERT(matches[3].pos == 2 && matches[3].pattern == 3);
+    ASSERT(matches[4].pos == 12 && matches[4].pattern == 2);
+    ASSERT(StringMatcher_FindAll(&m, &text, matches, 2) == 5);
+
+    StringMatcher empty = StringMatcher_New(NULL, 0);
+    ASSERT(StringMatcher_Count(&empty, &text) == 0);
+    ASSERT(!StringMatcher_FindFirst(&empty, &text, &match));
+
+    StringMatcher_Delete(&m);
+    StringMatcher_Delete(&empty);
+    String_Delete(&text);
+    for (size_t ii = 0; ii < count; ii++) {
+        String_Delete(&patterns[ii]);
+    }
+
+    {
+        // patterns over every byte value, too many states for a dense table
+        String haystack = String_New(1 << 16);
+        unsigned seed = 3;
+        for (size_t ii = 0; ii < haystack.len; ii++) {
+            seed = seed * 1103515245 + 12345;
+            String_Buf(&haystack)[ii] = (char)(ii % 3 ? (seed >> 16) : (seed >> 16) % 4);
+        }
+
+        enum { BINARY_PATTERNS = 2000 };
+        String* binary = malloc(BINARY_PATTERNS * sizeof(String));
+        size_t expected = 0;
+        size_t leftmost = haystack.len;
+        for (size_t ii = 0; ii < BINARY_PATTERNS; ii++) {
+            size_t start = (ii * 7919) % (haystack.len - 32);
+            binary[ii] = String_Slice(&haystack, start, start + 1 + ii % 24);
+            expected += String_InstancesOf(&haystack, &binary[ii]);
+            size_t first = (size_t)String_FirstOccurrenceOf(&haystack, &binary[ii]);
+            leftmost = first < leftmost ? first : leftmost;
+        }
+
+        StringMatcher sparse = StringMatcher_New(binary, BINARY_PATTERNS);
+        ASSERT(sparse.sparse);
+        ASSERT(StringMatcher_Count(&sparse, &haystack) == expected);
+        ASSERT(StringMatcher_FindFirst(&sparse, &haystack, &match) && match.pos == leftmost);
+        String found = String_Slice(&haystack, match.pos, match.pos + binary[match.pattern].len);
+        ASSERT(String_Equal(&found, &binary[match.pattern]));
+        String_Delete(&found);
+
+        StringMatcher_Delete(&sparse);
+        for (size_t ii = 0; ii < BINARY_PATTERNS; ii++) {
+            String_Delete(&binary[ii]);
+        }
+        free(binary);
+        String_Delete(&haystack);
+    }
+}
+
+void test_allocators(TestResult* result)
+{
+    String before = String("allocated before switching allocators");
+
+    {
+        StringArena arena = StringArena_New(256);
+        ASSERT(String_SetAllocator(&arena.base) == NULL);
+        ASSERT(String_GetAllocator() == &arena.base);
+
+        String joined = String_Join(&before, str(" and joined in the arena"));
+        String replaced = String_Replace(&joined, str("arena"), str("bump allocator"));
+        StringList split = String_Split(&replaced, str(" "));
+        String big = String_New(1000);
+
+        StringBuilder sb = { 0 };
+        for (int ii = 0; ii < 100; ii++) {
+            StringBuilder_AppendInt(&sb, ii);
+        }
+        String built = StringBuilder_Finalize(&sb);
+
+        ASSERT(String_Equal(&replaced, str("allocated before switching allocators and joined in the bump allocator")));
+        ASSERT(split.len == 10);
+        ASSERT(String_Equal(&split.str[9], str("allocator")));
+        ASSERT(big.len == 1000 && String_Buf(&big)[999] == 0);
+        ASSERT(built.len == 190 && String_StartsWith(&built, str("0123456789101112")));
+        ASSERT(arena.blocks != NULL);
+
+        // deleting Strings from before the switch goes to the default allocator
+        String_Delete(&before);
+
+        String_Delete(&joined);
+        StringList_Delete(&split);
+        StringArena_Reset(&arena);
+        ASSERT(arena.blocks != NULL && arena.blocks->used == 0 && arena.blocks->next == NULL);
+
+        String again = String_FromCString("reusing the arena after a reset");
+        ASSERT(String_Equal(&again, str("reusing the arena after a reset")));
+
+        ASSERT(String_SetAllocator(NULL) == &arena.base);
+        StringArena_Delete(&arena);
+    }
+
+    {
+        // with many blocks, frees and reallocs find their block (or the default allocator) without walking the list
+        String outside = String("allocated with the default allocator before the arena");
+        StringArena arena = StringArena_New(64);
+        String_SetAllocator(&arena.base);
+
+        StringBuilder held = { 0 };
+        StringBuilder_AppendCString(&held, "started before the other allocations");
+
+        String strings[200];
+        for (size_t ii = 0; ii < 200; ii++) {
+            StringBuilder sb = { 0 };
+            StringBuilder_AppendInt(&sb, (long long)ii * 1000003);
+            StringBuilder_AppendCString(&sb, " is a string long enough to leave the inline buffer");
+            strings[ii] = StringBuilder_Finalize(&sb);
+        }
+        ASSERT(arena.index_len > 100);
+        bool sorted = true;
+        for (size_t ii = 1; ii < arena.index_len; ii++) {
+            sorted &= (char*)arena.index[ii - 1] < (char*)arena.index[ii];
+        }
+        ASSERT(sorted);
+        bool owned = true;
+        for (size_t ii = 0; ii < 200; ii++) {
+            owned &= StrLib_ArenaOwner(&arena, String_Buf(&strings[ii])) != NULL;
+        }
+        ASSERT(owned);
+        ASSERT(StrLib_ArenaOwner(&arena, String_Buf(&outside)) == NULL);
+
+        // growing an old allocation copies it, deleting one is a no-op
+        StringBuilder_AppendCString(&held, ", and then grown");
+        String grown = StringBuilder_Finalize(&held);
+        ASSERT(String_Equal(&grown, str("started before the other allocations, and then grown")));
+        ASSERT(StrLib_ArenaOwner(&arena, String_Buf(&grown)) != NULL);
+        String_Delete(&strings[7]);
+        ASSERT(String_StartsWith(&strings[8], str("8000024 is")));
+
+        String_Delete(&outside);
+        StringArena_Reset(&arena);
+        ASSERT(arena.index_len == 1 && arena.index[0] == arena.blocks);
+
+        String_SetAllocator(NULL);
+        StringArena_Delete(&arena);
+        ASSERT(arena.index == NULL);
+    }
+
+    {
+        StringPool pool = StringPool_New(32, 2);
+        String_SetAllocator(&pool.base);
+
+        String a = String("pooled string number one");
+        String b = String("pooled string number two");
+        String c = String("the pool is exhausted so this one is from malloc");
+        ASSERT(StrLib_PoolOwns(&pool, String_Buf(&a)));
+        ASSERT(StrLib_PoolOwns(&pool, String_Buf(&b)));
+        ASSERT(!StrLib_PoolOwns(&pool, String_Buf(&c)));
+
+        String_Delete(&a);
+        String d = String("reuses a's block");
+        ASSERT(String_Buf(&d) == a.buf);
+        ASSERT(String_Equal(&b, str("pooled string number two")));
+
+        String_Delete(&b);
+        String_Delete(&c);
+        String_Delete(&d);
+        String_SetAllocator(NULL);
+        StringPool_Delete(&pool);
+    }
+
+    {
+        // shared blocks go back to the allocator they came from, whichever allocator is in use when they are released
+        StringPool pool = StringPool_New(128, 1);
+        String_SetAllocator(&pool.base);
+        String shared = String_Share(str("shared from a pool block, released with the default allocator"));
+        ASSERT(StrLib_PoolOwns(&pool, StrLib_SharedBlockOf(&shared)));
+        String_SetAllocator(NULL);
+
+        String_Delete(&shared);
+        ASSERT(pool.free_list != NULL);
+        StringPool_Delete(&pool);
+    }
+}
+
+void test_packed(TestResult* result)
+{
+    String src = String("a string stored behind its length");
+    StringPacked packed = String_Pack(&src);
+    StringPacked empty = StringPacked_FromView(strview(""));
+    StringPacked zero = { 0 };
+
+    ASSERT(StringPacked_Len(packed) == src.len);
+    ASSERT(strcmp(StringPacked_CStr(packed), "a string stored behind its length") == 0);
+    ASSERT(StringView_Equal(StringPacked_View(packed), String_View(&src)));
+    ASSERT(StringView_Contains(StringPacked_View(packed), strview("behind")));
+
+    // lengths of 128 and above take more than one header byte
+    String long_src = String_New(300);
+    memset(String_Buf(&long_src), 'x', long_src.len);
+    StringPacked long_packed = String_Pack(&long_src);
+    ASSERT(StringPacked_Len(long_packed) == 300);
+    ASSERT(strlen(StringPacked_CStr(long_packed)) == 300);
+    StringPacked_Delete(&long_packed);
+    String_Delete(&long_src);
+
+    ASSERT(empty.mem == NULL);
+    ASSERT(StringPacked_Len(zero) == 0);
+    ASSERT(strcmp(StringPacked_CStr(zero), "") == 0);
+
+    String unpacked = StringPacked_Unpack(packed);
+    ASSERT(String_Equal(&unpacked, &src));
+
+    StringPacked_Delete(&packed);
+    StringPacked_Delete(&empty);
+    ASSERT(packed.mem == NULL);
+    String_Delete(&unpacked);
+    String_Delete(&src);
+}
+
+void test_hash_map(TestResult* result)
+{
+    String heap = String_NewHeap(5);
+    memcpy(String_Buf(&heap), "hello", 5);
+    ASSERT(String_Hash(&heap, 1) == String_Hash(str("hello"), 1));
+    ASSERT(String_Hash(&heap, 1) == StringView_Hash(StringView_Slice(strview("say hello"), 4, 9), 1));
+    ASSERT(String_Hash(&heap, 1) != String_Hash(&heap, 2));
+    ASSERT(String_Hash(str("hello"), 0) != String_Hash(str("hellp"), 0));
+    ASSERT(String_Hash(str(""), 0) != String_Hash(str("a"), 0));
+
+    StringMap map = StringMap_New(0, 42);
+    ASSERT(StringMap_Get(&map, strview("missing")) == NULL);
+    ASSERT(StringMap_Set(&map, String_View(&heap), &result->total));
+    ASSERT(!StringMap_Set(&map, strview("hello"), &result->passed));
+    ASSERT(StringMap_Get(&map, strview("hello")) == &result->passed);
+    ASSERT(map.len == 1);
+
+    // lookup with a view into a larger buffer, keys are copied on insert
+    String line = String("key=value");
+    ASSERT(StringMap_Set(&map, String_SliceView(&line, 0, 3), NULL));
+    String_Delete(&line);
+    ASSERT(StringMap_Contains(&map, strview("key")));
+
+    char key[32];
+    for (size_t ii = 0; ii < 1000; ii++) {
+        bool inserted;
+        snprintf(key, sizeof(key), "generated key %zu", ii);
+        StringMapEntry* entry = StringMap_Upsert(&map, StringView_FromCString(key), &inserted);
+        entry->value = (void*)(uintptr_t)(ii + 1);
+    }
+    ASSERT(map.len == 1002);
+    ASSERT(StringMap_Get(&map, strview("generated key 0")) == (void*)1);
+    ASSERT(StringMap_Get(&map, strview("generated key 999")) == (void*)1000);
+    ASSERT(StringMap_Get(&map, strview("hello")) == &result->passed);
+
+    for (size_t ii = 0; ii < 1000; ii += 2) {
+        snprintf(key, sizeof(key), "generated key %zu", ii);
+        StringMap_Remove(&map, StringView_FromCString(key));
+    }
+    ASSERT(!StringMap_Remove(&map, strview("generated key 0")));
+    ASSERT(!StringMap_Contains(&map, strview("generated key 998")));
+    ASSERT(StringMap_Get(&map, strview("generated key 997")) == (void*)998);
+    ASSERT(map.len == 502);
+
+    size_t count = 0;
+    size_t pos = 0;
+    StringMapEntry* entry;
+    while ((entry = StringMap_Next(&map, &pos))) {
+        count += StringMap_Find(&map, String_View(&entry->key)) == entry;
+    }
+    ASSERT(count == 502);
+
+    StringMap_Clear(&map);
+    ASSERT(map.len == 0 && !StringMap_Contains(&map, strview("hello")));
+    ASSERT(StringMap_Set(&map, strview("hello"), NULL));
+
+    StringMap zero = { 0 };
+    ASSERT(!StringMap_Contains(&zero, strview("")));
+    ASSERT(StringMap_Set(&zero, strview(""), NULL));
+    ASSERT(StringMap_Contains(&zero, strview("")));
+
+    StringMap_Delete(&map);
+    StringMap_Delete(&zero);
+    String_Delete(&heap);
+}
+
+void test_interner(TestResult* result)
+{
+    StringInterner in = StringInterner_New(7, false);
+    String field = String("content-type");
+
+    const String* a = StringInterner_Intern(&in, String_View(&field));
+    const String* b = StringInterner_Intern(&in, strview("content-type"));
+    const String* c = StringInterner_Intern(&in, strview("a longer value that doesn't fit inline"));
+    ASSERT(a == b);
+    ASSERT(a != c);
+    ASSERT(String_Equal(a, &field));
+    ASSERT(String_Buf(a) != String_Buf(&field));
+    ASSERT(StringInterner_Find(&in, strview("a longer value that doesn't fit inline")) == c);
+    ASSERT(StringInterner_Find(&in, strview("missing")) == NULL);
+    ASSERT(in.len == 2);
+
+    // canonical Strings don't move as the table grows
+    char name[32];
+    for (size_t ii = 0; ii < 3000; ii++) {
+        snprintf(name, sizeof(name), "field %zu", ii % 1500);
+        StringInterner_Intern(&in, StringView_FromCString(name));
+    }
+    ASSERT(in.len == 1502);
+    ASSERT(StringInterner_Intern(&in, strview("content-type")) == a);
+    ASSERT(String_Equal(c, str("a longer value that doesn't fit inline")));
+
+    String record = String("GET;200;GET;content-type;field 7");
+    StringList fields = String_Split(&record, str(";"));
+    const String* interned[5];
+    StringInterner_InternList(&in, &fields, interned);
+    ASSERT(interned[0] == interned[2]);
+    ASSERT(interned[0] != interned[1]);
+    ASSERT(interned[3] == a);
+    ASSERT(interned[4] == StringInterner_Find(&in, strview("field 7")));
+    ASSERT(in.len == 1504);
+
+    StringInterner shared = StringInterner_New(7, true);
+    ASSERT(StringInterner_Intern(&shared, strview("x")) == StringInterner_Intern(&shared, strview("x")));
+
+    StringInterner_Delete(&in);
+    StringInterner_Delete(&shared);
+    StringList_Delete(&fields);
+    String_Delete(&record);
+    String_Delete(&field);
+}
+
+#if STRLIB_POSIX
+void test_writev(TestResult* result)
+{
+    // more pieces than a single writev call takes, short pieces are staged and long pieces are written in place
+    size_t count = 3 * STRLIB_IOV_BATCH + 5;
+    String* pieces = malloc(count * sizeof(String));
+    StringBuilder expected = StringBuilder_New(0);
+    for (size_t ii = 0; ii < count; ii++) {
+        char num[128];
+        int len = snprintf(num, sizeof(num), ii % 3 ? "%zu" : "%0100zu", ii);
+        pieces[ii] = ii % 5 ? String_FromCharArray(num, (size_t)len) : String("");
+        if (ii) {
+            StringBuilder_AppendCString(&expected, ", ");
+        }
+        StringBuilder_Append(&expected, &pieces[ii]);
+    }
+    String joined = StringBuilder_Finalize(&expected);
+
+    int fd = open("test.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    assert(fd >= 0);
+    ASSERT(String_WriteV(fd, pieces, count, str(", ")) == (ssize_t)joined.len);
+    close(fd);
+
+    String written;
+    ASSERT(String_MapFile("test.txt", &written));
+    ASSERT(String_Equal(&written, &joined));
+    String_UnmapFile(&written);
+
+    StringList list = String_Split(str("a,bc,,d"), str(","));
+    fd = open("test.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    assert(fd >= 0);
+    ASSERT(StringList_WriteV(fd, &list, NULL) == 4);
+    ASSERT(String_WriteV(fd, pieces, 0, str(", ")) == 0);
+    close(fd);
+
+    ASSERT(String_MapFile("test.txt", &written));
+    ASSERT(String_Equal(&written, str("abcd")));
+    String_UnmapFile(&written);
+
+    ASSERT(String_WriteV(-1, pieces, 2, NULL) < 0);
+
+    StringList_Delete(&list);
+    for (size_t ii = 0; ii < count; ii++) {
+        String_Delete(&pieces[ii]);
+    }
+    free(pieces);
+    String_Delete(&joined);
+}
+#endif
+
+void test_reader(TestResult* result)
+{
+    // records crossing buffer boundaries, longer than the buffer, empty and without a final delimiter
+    const char data[] = "first line\nsecond\n\na record much longer than the buffer\nlast";
+    FILE* fd = fopen("test.txt", "wb");
+    assert(fd);
+    fwrite(data, 1, sizeof(data) - 1, fd);
+    fclose(fd);
+
+    const char* expected[] = { "first line", "second", "", "a record much longer than the buffer", "last" };
+    size_t buf_sizes[] = { 1, 7, 0 };
+    for (size_t ii = 0; ii < sizeof(buf_sizes) / sizeof(buf_sizes[0]); ii++) {
+        fd = fopen("test.txt", "rb");
+        assert(fd);
+        StringReader reader = StringReader_New(fd, '\n', buf_sizes[ii]);
+        StringView record;
+        size_t count = 0;
+        while (StringReader_Next(&reader, &record)) {
+            ASSERT(count < 5 && StringView_Equal(record, StringView_FromCString(expected[count])));
+            count += 1;
+        }
+        ASSERT(count == 5);
+        ASSERT(!reader.error);
+        ASSERT(!StringReader_Next(&reader, &record));
+        StringReader_Delete(&reader);
+        fclose(fd);
+    }
+
+    {
+        fd = fopen("test.txt", "rb");
+        assert(fd);
+        StringReader reader = StringReader_New(fd, ' ', 4);
+        StringView record;
+        ASSERT(StringReader_Next(&reader, &record) && StringView_Equal(record, strview("first")));
+        ASSERT(StringReader_Next(&reader, &record) && StringView_Equal(record, strview("line\nsecond\n\na")));
+        StringReader_Delete(&reader);
+        fclose(fd);
+    }
+
+#if STRLIB_POSIX
+    {
+        int raw = open("test.txt", O_RDONLY);
+        assert(raw >= 0);
+        StringReader reader = StringReader_FromFd(raw, '\n', 5);
+        StringView record;
+        size_t count = 0;
+        while (StringReader_Next(&reader, &record)) {
+            ASSERT(count < 5 && StringView_Equal(record, StringView_FromCString(expected[count])));
+            count += 1;
+        }
+        ASSERT(count == 5);
+        StringReader_Delete(&reader);
+        close(raw);
+    }
+#endif
+
+    {
+        fd = fopen("test.txt", "wb");
+        assert(fd);
+        fclose(fd);
+        fd = fopen("test.txt", "rb");
+        assert(fd);
+        StringReader reader = StringReader_New(fd, '\n', 0);
+        StringView record;
+        ASSERT(!StringReader_Next(&reader, &record));
+        StringReader_Delete(&reader);
+        fclose(fd);
+    }
+}
+
+#if STRLIB_POSIX
+void test_map_file(TestResult* result)
+{
+    // sizes ending inside a page and exactly on a page boundary
+    size_t sizes[] = { 1, 100, (size_t)sysconf(_SC_PAGESIZE), 3 * (size_t)sysconf(_SC_PAGESIZE) };
+    for (size_t ii = 0; ii < sizeof(sizes) / sizeof(sizes[0]); ii++) {
+        String contents = String_New(sizes[ii]);
+        for (size_t jj = 0; jj < sizes[ii]; jj++) {
+            String_Buf(&contents)[jj] = (char)('a' + jj % 26);
+        }
+        String_Buf(&contents)[sizes[ii] - 1] = '\n';
+
+        FILE* fd = fopen("test.txt", "wb");
+        assert(fd);
+        String_Write(&contents, fd);
+        fclose(fd);
+
+        String mapped;
+        ASSERT(String_MapFile("test.txt", &mapped));
+        ASSERT(String_Equal(&mapped, &contents));
+        ASSERT(String_CStr(&mapped)[mapped.len] == '\0');
+        ASSERT(strlen(String_CStr(&mapped)) == sizes[ii]);
+        ASSERT(String_InstancesOf(&mapped, str("\n")) == 1);
+        String_UnmapFile(&mapped);
+
+        StringView view;
+        ASSERT(StringView_MapFile("test.txt", &view));
+        ASSERT(StringView_Equal(view, String_View(&contents)));
+        StringView_UnmapFile(view);
+
+        String_Delete(&contents);
+    }
+
+    {
+        FILE* fd = fopen("test.txt", "wb");
+        assert(fd);
+        fclose(fd);
+
+        String mapped;
+        ASSERT(String_MapFile("test.txt", &mapped));
+        ASSERT(mapped.len == 0);
+        ASSERT(!strcmp(String_CStr(&mapped), ""));
+        String_UnmapFile(&mapped);
+    }
+
+    {
+        String mapped;
+        ASSERT(!String_MapFile("does/not/exist.txt", &mapped));
+    }
+}
+#endif
+
+void test_sort(TestResult* result)
+{
+    // embedded \0 bytes, prefixes of each other, long shared prefixes and duplicates
+    const String* words[] = {
+        str("pear"),
+        str("apple"),
+        str("apple\0"),
+        str("apple\0\0"),
+        str("apple\0a"),
+        str(""),
+        str("app"),
+        str("pear"),
+        str("common prefix longer than the cached keys, one"),
+        str("common prefix longer than the cached keys, two"),
+        str("common prefix longer than the cached keys"),
+        str("\xff"),
+        str("apple"),
+    };
+    size_t count = sizeof(words) / sizeof(words[0]);
+
+    // enough copies to be sorted by partitioning rather than insertion sort
+    StringList list = { .len = 4 * count, .str = malloc(4 * count * sizeof(String)) };
+    for (size_t ii = 0; ii < list.len; ii++) {
+        list.str[ii] = String_Copy(words[(ii * 7) % count]);
+    }
+
+    StringList_Sort(&list);
+    bool sorted = true;
+    for (size_t ii = 1; ii < list.len; ii++) {
+        sorted &= String_Compare(&list.str[ii - 1], &list.str[ii]) <= 0;
+    }
+    ASSERT(sorted);
+    ASSERT(String_Equal(&list.str[0], str("")));
+    ASSERT(String_Equal(&list.str[4], str("app")));
+    ASSERT(String_Equal(&list.str[list.len - 1], str("\xff")));
+
+    size_t unique = StringList_Unique(&list);
+    ASSERT(unique == count - 2);
+    ASSERT(String_Equal(&list.str[1], str("app")));
+    ASSERT(String_Equal(&list.str[2], str("apple")));
+    ASSERT(String_Equal(&list.str[3], str("apple\0")));
+    ASSERT(String_Equal(&list.str[4], str("apple\0\0")));
+    ASSERT(String_Equal(&list.str[5], str("apple\0a")));
+    ASSERT(String_Equal(&list.str[6], str("common prefix longer than the cached keys")));
+    ASSERT(String_Equal(&list.str[7], str("common prefix longer than the cached keys, one")));
+
+    // the duplicates are moved behind the unique Strings, so they can still be deleted
+    for (size_t ii = 0; ii < list.len; ii++) {
+        String_Delete(&list.str[ii]);
+    }
+    free(list.str);
+
+#if !defined(__STDC_NO_THREADS__) && !defined(__STDC_NO_ATOMICS__)
+    {
+        String text = String_New(64 * STRLIB_PARALLEL_BLOCK);
+        for (size_t ii = 0; ii < text.len; ii++) {
+            String_Buf(&text)[ii] = ii % 7 ? (char)('a' + (ii * ii) % 3) : ' ';
+        }
+
+        StringList parallel = String_Split(&text, str(" "));
+        StringList serial = String_Split(&text, str(" "));
+        StringThreadPool pool = StringThreadPool_New(4);
+        StringList_ParallelSort(&pool, &parallel);
+        StringList_Sort(&serial);
+        bool equal = true;
+        for (size_t ii = 0; ii < serial.len; ii++) {
+            equal &= String_Equal(&parallel.str[ii], &serial.str[ii]);
+        }
+        ASSERT(equal);
+        ASSERT(StringList_Unique(&parallel) == StringList_Unique(&serial));
+
+        StringThreadPool_Delete(&pool);
+        StringList_Delete(&parallel);
+        StringList_Delete(&serial);
+        String_Delete(&text);
+    }
+#endif
+}
+
+void test_rope(TestResult* result)
+{
+    StringRope empty = StringRope_New();
+    ASSERT(StringRope_Len(&empty) == 0);
+    ASSERT(StringRope_Find(&empty, str("a"), 0) < 0);
+    ASSERT(StringRope_Find(&empty, str(""), 0) == 0);
+
+    // several chunks, with a marker straddling the boundary between the first two
+    String text = String_New(3 * STRLIB_ROPE_CHUNK + 100);
+    for (size_t ii = 0; ii < text.len; ii++) {
+        String_Buf(&text)[ii] = (char)('a' + ii % 26);
+    }
+    memcpy(&String_Buf(&text)[STRLIB_ROPE_CHUNK - 3], "MARKER", 6);
+    StringRope rope = StringRope_FromString(&text);
+    ASSERT(StringRope_Len(&rope) == text.len);
+    ASSERT(StringRope_At(&rope, STRLIB_ROPE_CHUNK) == 'K');
+    ASSERT(StringRope_Find(&rope, str("MARKER"), 0) == STRLIB_ROPE_CHUNK - 3);
+    ASSERT(StringRope_Find(&rope, str("MARKER"), STRLIB_ROPE_CHUNK - 2) < 0);
+
+    // chunks are streamed in order, starting at the given index
+    StringRopeIterator it = StringRope_Iter(&rope, 10);
+    StringView chunk;
+    size_t chunks = 0;
+    size_t pos = 10;
+    bool in_order = true;
+    while (StringRopeIterator_Next(&it, &chunk)) {
+        in_order &= memcmp(chunk.buf, &String_Buf(&text)[pos], chunk.len) == 0;
+        pos += chunk.len;
+        chunks += 1;
+    }
+    ASSERT(in_order && pos == text.len && chunks == 4);
+
+    // edits leave copies unchanged
+    StringRope copy = StringRope_Copy(&rope);
+    StringRope_Insert(&rope, 2, str("<inserted>"));
+    StringRope_Remove(&rope, 0, 2);
+    StringRope_Splice(&rope, 10, 13, str("|"));
+    StringRope_Insert(&rope, StringRope_Len(&rope), str("!"));
+    ASSERT(StringRope_Len(&rope) == text.len + 7);
+    ASSERT(StringRope_Find(&rope, str("<inserted>|fghi"), 0) == 0);
+    ASSERT(StringRope_At(&rope, StringRope_Len(&rope) - 1) == '!');
+    ASSERT(StringRope_Len(&copy) == text.len);
+
+    String flat = StringRope_Flatten(&copy);
+    ASSERT(String_Equal(&flat, &text));
+    String_Delete(&flat);
+
+    // slices and concatenations share chunks
+    StringRope slice = StringRope_Slice(&rope, StringRope_Len(&rope) - 5, StringRope_Len(&rope));
+    StringRope_Concat(&slice, &slice);
+    flat = StringRope_Flatten(&slice);
+    ASSERT(String_Equal(&flat, str("ijkl!ijkl!")));
+    ASSERT(StringRope_Find(&slice, str("l!i"), 0) == 3);
+    String_Delete(&flat);
+
+    StringRope_Remove(&rope, 0, StringRope_Len(&rope));
+    ASSERT(StringRope_Len(&rope) == 0);
+
+    // nodes built under a pool are freed back to it after switching to the default allocator
+    StringPool pool = StringPool_New(sizeof(StrLib_RopeNode), 8);
+    String_SetAllocator(&pool.base);
+    StringRope pooled = StringRope_Slice(&copy, 100, 3 * STRLIB_ROPE_CHUNK);
+    StringRope_Insert(&pooled, 5, str("a leaf longer than the small-string capacity"));
+    String_SetAllocator(NULL);
+    StringRope_Delete(&pooled);
+    StringPool_Delete(&pool);
+
+    StringRope_Delete(&empty);
+    StringRope_Delete(&rope);
+    StringRope_Delete(&copy);
+    StringRope_Delete(&slice);
+    String_Delete(&text);
+}
+
+void test_utf8(TestResult* result)
+{
+    // "héllo wörld, 日本語 and 🎉" repeated past a few index strides
+    const String* sample = str("h\xc3\xa9llo w\xc3\xb6rld, \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e and \xf0\x9f\x8e\x89 ");
+    ASSERT(String_ValidateUtf8(sample));
+    ASSERT(String_Utf8Len(sample) == 23);
+    ASSERT(StringView_Utf16Len(String_View(sample)) == 24);
+
+    StringBuilder sb = StringBuilder_New(0);
+    for (size_t ii = 0; ii < 200; ii++) {
+        StringBuilder_AppendCharArray(&sb, String_Buf(sample), sample->len);
+    }
+    String text = StringBuilder_Finalize(&sb);
+    ASSERT(String_ValidateUtf8(&text));
+    ASSERT(String_Utf8Len(&text) == 200 * 23);
+
+    // overlong, surrogate, out of range, truncated and stray continuation bytes
+    ASSERT(!StringView_ValidateUtf8(StringView_FromCString("\xc0\xaf")));
+    ASSERT(!StringView_ValidateUtf8(StringView_FromCString("\xe0\x80\xaf")));
+    ASSERT(!StringView_ValidateUtf8(StringView_FromCString("\xed\xa0\x80")));
+    ASSERT(!StringView_ValidateUtf8(StringView_FromCString("\xf4\x90\x80\x80")));
+    ASSERT(!StringView_ValidateUtf8(StringView_FromCString("abc\xe6\x97")));
+    ASSERT(!StringView_ValidateUtf8(StringView_FromCString("\x80")));
+    ASSERT(StringView_ValidateUtf8(StringView_FromCString("\xf4\x8f\xbf\xbf")));
+    ASSERT(StringView_Utf8Error(String_View(&text)) < 0);
+    String_Buf(&text)[1000] = (char)0xff;
+    ASSERT(!String_ValidateUtf8(&text));
+    ASSERT(StringView_Utf8Error(String_View(&text)) == 1000);
+    String_Buf(&text)[1000] = String_Buf(sample)[1000 % sample->len];
+
+    // code point offsets with and without an index agree
+    StringUtf8Index index = StringUtf8Index_New(String_View(&text));
+    ASSERT(StringUtf8Index_Len(&index) == 200 * 23);
+    ASSERT(StringUtf8Index_Offset(&index, 23 * 150 + 1) == sample->len * 150 + 1);
+    ASSERT(StringUtf8Index_Offset(&index, 23 * 150 + 2) == sample->len * 150 + 3);
+    ASSERT(StringView_Utf8Offset(String_View(&text), 23 * 150 + 2) == sample->len * 150 + 3);
+    ASSERT(StringUtf8Index_Offset(&index, 200 * 23) == text.len);
+    StringView word = StringUtf8Index_Slice(&index, 23 * 100 + 13, 23 * 100 + 16);
+    ASSERT(StringView_Equal(word, StringView_FromCString("\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e")));
+    word = StringView_Utf8Slice(String_View(&text), 23 * 100 + 13, 23 * 100 + 16);
+    ASSERT(StringView_Equal(word, StringView_FromCString("\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e")));
+
+    StringUtf8Iterator it = StringUtf8Index_Iter(&index, 23 * 199 + 21);
+    uint32_t cp = 0;
+    ASSERT(StringUtf8Iterator_Next(&it, &cp) && cp == 0x1F389);
+    ASSERT(StringUtf8Iterator_Next(&it, &cp) && cp == ' ');
+    ASSERT(!StringUtf8Iterator_Next(&it, &cp));
+    StringUtf8Index_Delete(&index);
+
+    // invalid bytes are yielded as replacement chars
+    it = StringView_Utf8Iter(StringView_FromCString("a\xe6\x97z"));
+    size_t replaced = 0;
+    while (StringUtf8Iterator_Next(&it, &cp)) {
+        replaced += cp == STRLIB_UTF8_REPLACEMENT;
+    }
+    ASSERT(replaced == 2);
+
+    // round trips through UTF-16 and UTF-32
+    uint16_t* utf16 = malloc(text.len * sizeof(uint16_t));
+    uint32_t* utf32 = malloc(text.len * sizeof(uint32_t));
+    ssize_t units = StringView_ToUtf16(String_View(&text), utf16);
+    ssize_t cps = StringView_ToUtf32(String_View(&text), utf32);
+    ASSERT(units == 200 * 24 && utf16[21] == 0xD83C && utf16[22] == 0xDF89);
+    ASSERT(cps == 200 * 23 && utf32[21] == 0x1F389);
+
+    String from16;
+    String from32;
+    ASSERT(String_FromUtf16(utf16, (size_t)units, &from16) && String_Equal(&from16, &text));
+    ASSERT(String_FromUtf32(utf32, (size_t)cps, &from32) && String_Equal(&from32, &text));
+    ASSERT(StringView_ToUtf16(StringView_FromCString("\xed\xa0\x80"), utf16) < 0);
+
+    String rejected = String("unchanged");
+    ASSERT(!String_FromUtf16((const uint16_t[]) { 'a', 0xDC00, 'b' }, 3, &rejected));
+    ASSERT(!String_FromUtf32((const uint32_t[]) { 0x110000 }, 1, &rejected));
+    ASSERT(String_Equal(&rejected, str("unchanged")));
+
+    free(utf16);
+    free(utf32);
+    String_Delete(&from16);
+    String_Delete(&from32);
+    String_Delete(&rejected);
+    String_Delete(&text);
+}
+
+#if !defined(__STDC_NO_THREADS__) && !defined(__STDC_NO_ATOMICS__)
+void test_parallel(TestResult* result)
+{
+    StringThreadPool pool = StringThreadPool_New(3);
+    ASSERT(StringThreadPool_Threads(&pool) == 3);
+
+    // periodic text, so matches straddle chunk boundaries and overlap each other
+    String text = String_New(5 * STRLIB_PARALLEL_CHUNK / 2 + 7);
+    for (size_t ii = 0; ii < text.len; ii++) {
+        String_Buf(&text)[ii] = "abaab"[ii % 5];
+    }
+    String_Buf(&text)[text.len - 3] = 'z';
+
+    const String* needles[] = { str("ab"), str("aba"), str("abaababaab"), str("a"), str("z"), str("zz"), str("baabaa") };
+    for (size_t ii = 0; ii < sizeof(needles) / sizeof(needles[0]); ii++) {
+        ASSERT(String_ParallelInstancesOf(&pool, &text, needles[ii]) == String_InstancesOf(&text, needles[ii]));
+        ASSERT(
+            String_ParallelDistinctInstancesOf(&pool, &text, needles[ii])
+            == String_DistinctInstancesOf(&text, needles[ii]));
+        ASSERT(String_ParallelFirstOccurrenceOf(&pool, &text, needles[ii]) == String_FirstOccurrenceOf(&text, needles[ii]));
+
+        String parallel = String_ParallelReplace(&pool, &text, needles[ii], str("<replaced>"));
+        String serial = String_Replace(&text, needles[ii], str("<replaced>"));
+        ASSERT(String_Equal(&parallel, &serial));
+        String_Delete(&parallel);
+        String_Delete(&serial);
+    }
+
+    {
+        String_Buf(&text)[text.len - 3] = 'a';
+        ASSERT(String_ParallelFirstOccurrenceOf(&pool, &text, str("z")) < 0);
+        String removed = String_ParallelReplace(&pool, &text, str("b"), str(""));
+        ASSERT(removed.len == String_InstancesOf(&text, str("a")));
+        String_Delete(&removed);
+    }
+
+    {
+        StringList lines = String_Split(str("  b \n a\n\n c  \n  b"), str("\n"));
+        uint64_t hashes[5];
+        StringView trimmed[5];
+        ssize_t order[5];
+        StringList_ParallelHash(&pool, &lines, 7, hashes);
+        StringList_ParallelTrimView(&pool, &lines, trimmed);
+        StringList_ParallelCompare(&pool, &lines, str(" a"), order);
+        for (size_t ii = 0; ii < lines.len; ii++) {
+            ASSERT(hashes[ii] == String_Hash(&lines.str[ii], 7));
+            ASSERT(StringView_Equal(trimmed[ii], String_TrimView(&lines.str[ii])));
+            ASSERT((order[ii] < 0) == (String_Compare(&lines.str[ii], str(" a")) < 0));
+        }
+        StringList_Delete(&lines);
+    }
+
+    {
+        // random haystacks and needles over a small alphabet, with enough rounds to cover the chunk boundary fix-ups
+        // when built with a tiny STRLIB_PARALLEL_CHUNK (see `make test-chunks`)
+        size_t rounds = STRLIB_PARALLEL_CHUNK <= 4096 ? 3000 : 4;
+        unsigned seed = 1;
+        bool matches_serial = true;
+        for (size_t round = 0; round < rounds; round++) {
+            seed = seed * 1103515245 + 12345;
+            String hay = String_New(2 * STRLIB_PARALLEL_CHUNK + (seed >> 8) % (6 * STRLIB_PARALLEL_CHUNK));
+            for (size_t ii = 0; ii < hay.len; ii++) {
+                seed = seed * 1103515245 + 12345;
+                String_Buf(&hay)[ii] = "aab"[(seed >> 16) % 3];
+            }
+
+            seed = seed * 1103515245 + 12345;
+            size_t start = (seed >> 8) % hay.len;
+            size_t len = 1 + (seed >> 4) % 9;
+            String needle = String_Slice(&hay, start, start + len < hay.len ? start + len : hay.len);
+            if (round % 4 == 0) {
+                String_Buf(&needle)[needle.len - 1] = 'c';
+            }
+
+            matches_serial &= String_ParallelInstancesOf(&pool, &hay, &needle) == String_InstancesOf(&hay, &needle);
+            matches_serial &= String_ParallelDistinctInstancesOf(&pool, &hay, &needle)
+                              == String_DistinctInstancesOf(&hay, &needle);
+            matches_serial &= String_ParallelFirstOccurrenceOf(&pool, &hay, &needle)
+                              == String_FirstOccurrenceOf(&hay, &needle);
+            String parallel = String_ParallelReplace(&pool, &hay, &needle, str("<>"));
+            String serial_replaced = String_Replace(&hay, &needle, str("<>"));
+            matches_serial &= String_Equal(&parallel, &serial_replaced);
+
+            String_Delete(&parallel);
+            String_Delete(&serial_replaced);
+            String_Delete(&needle);
+            String_Delete(&hay);
+        }
+        ASSERT(matches_serial);
+    }
+
+    StringThreadPool_Delete(&pool);
+
+    // a pool without workers runs everything on the calling thread
+    StringThreadPool serial = StringThreadPool_New(1);
+    ASSERT(StringThreadPool_Threads(&serial) == 1);
+    ASSERT(String_ParallelInstancesOf(&serial, &text, str("ab")) == String_InstancesOf(&text, str("ab")));
+    StringThreadPool_Delete(&serial);
+
+    String_Delete(&text);
+}
+#endif
+
+#ifdef STRLIB_STATS
+void test_stats(TestResult* result)
+{
+    String_StatsReset();
+    String long_str = String("the quick brown fox jumps over the lazy dog");
+    String word = String("the");
+    String repl = String("a much longer replacement");
+
+    String replaced = String_Replace(&long_str, &word, &repl);
+    ASSERT(String_InstancesOf(&long_str, &word) == 2);
+
+    StringStats stats = String_StatsSnapshot();
+    ASSERT(stats.fn[STRLIB_STATS_String_Replace].calls == 1);
+    ASSERT(stats.fn[STRLIB_STATS_String_Replace].allocs == 1);
+    ASSERT(stats.fn[STRLIB_STATS_String_Replace].bytes_allocated == replaced.len + 1);
+    ASSERT(stats.fn[STRLIB_STATS_String_Replace].bytes_scanned == long_str.len);
+    ASSERT(stats.fn[STRLIB_STATS_String_InstancesOf].calls == 1);
+    ASSERT(stats.fn[STRLIB_STATS_String_InstancesOf].allocs == 0);
+    // the String_New inside String_Replace is attributed to String_Replace
+    ASSERT(stats.fn[STRLIB_STATS_String_New].calls == 0);
+    ASSERT(stats.fn[STRLIB_STATS_String_FromCString].calls == 3);
+    ASSERT(!strcmp(StringStats_Name(STRLIB_STATS_String_Replace), "String_Replace"));
+
+    StringBuilder sb = StringBuilder_New(0);
+    StringBuilder_Append(&sb, &long_str);
+    ASSERT(String_StatsSnapshot().fn[STRLIB_STATS_StringBuilder_Reserve].allocs == 1);
+    ASSERT(String_StatsSnapshot().fn[STRLIB_STATS_other].allocs == 1);
+    StringStats_Merge(&stats, &stats);
+    ASSERT(stats.fn[STRLIB_STATS_String_Replace].calls == 2);
+
+    String_StatsReset();
+    ASSERT(String_StatsSnapshot().fn[STRLIB_STATS_String_Replace].calls == 0);
+
+    StringBuilder_Delete(&sb);
+    String_Delete(&replaced);
+    String_Delete(&long_str);
+    String_Delete(&word);
+    String_Delete(&repl);
+}
+#endif
+
 int main(void)
 {
     TestResult result = { 0 };
 
     test_creation(&result);
+    test_sso(&result);
     test_simple(&result);
+    test_search(&result);
     test_comparison(&result);
+    test_compare_kernels(&result);
     test_instances(&result);
+    test_find_all(&result);
     test_replace(&result);
     test_trim(&result);
     test_split(&result);
+    test_split_iter(&result);
     test_join(&result);
     test_slice(&result);
+    test_shared(&result);
+    test_view(&result);
     test_write_print(&result);
+    test_builder(&result);
+    test_matcher(&result);
+    test_allocators(&result);
+    test_packed(&result);
+    test_hash_map(&result);
+    test_interner(&result);
+#if STRLIB_POSIX
+    test_map_file(&result);
+#endif
+    test_reader(&result);
+#if STRLIB_POSIX
+    test_writev(&result);
+#endif
+#if !defined(__STDC_NO_THREADS__) && !defined(__STDC_NO_ATOMICS__)
+    test_parallel(&result);
+#endif
+    test_sort(&result);
+    test_rope(&result);
+    test_utf8(&result);
+#ifdef STRLIB_STATS
+    test_stats(&result);
+#endif
 
     printf(
         "\n\n"